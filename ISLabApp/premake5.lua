@@ -11,6 +11,7 @@ project "ISLabApp"
    {
       "../vendor/imgui",
       "../vendor/glfw/include",
+      "../vendor/stb_image",
 
       "../Walnut/src",
 
@@ -31,12 +32,12 @@ project "ISLabApp"
       defines { "WL_PLATFORM_WINDOWS" }
 
    filter "configurations:Debug"
-      defines { "WL_DEBUG" }
+      defines { "WL_DEBUG", "WL_ENABLE_TRACING" }
       runtime "Debug"
       symbols "On"
 
    filter "configurations:Release"
-      defines { "WL_RELEASE" }
+      defines { "WL_RELEASE", "WL_ENABLE_TRACING" }
       runtime "Release"
       optimize "On"
       symbols "On"
@@ -6,6 +6,7 @@
 #include "OrdersTableWindow.h"
 #include "InventoriesTableWindow.h"
 #include "WarehousesTableWindow.h"
+#include "ExportWindow.h"
 
 #include <imgui.h>
 #include <implot.h>
@@ -14,6 +15,69 @@
 #include <set>
 #include <ctime>
 
+namespace
+{
+
+// Orders fetched at a time when the filter runs on the server
+constexpr std::size_t ORDERS_PAGE_ROWS = 200;
+
+// Keyset condition for the rows after _Order in the order of AdminWindow::BuildFilterQuery
+void WhereAfter(
+    QueryBuilder & _Query,
+    const OrderEntry & _Order,
+    const std::string & _QuantityText,
+    int _ColIdx,
+    ImGuiSortDirection _SortDir
+  )
+{
+  const std::string Op = _SortDir == ImGuiSortDirection_Descending ? " < ?" : " > ?";
+
+  QueryBuilder::Value Key;
+  switch (_ColIdx)
+  {
+  case 1: Key = _Order.Customer.Id; break;
+  case 2: Key = ORDER_STATUS_TO_STRING.at(_Order.Status); break;
+  case 3: Key = _Order.Date; break;
+  case 4: Key = _Order.Product.Id; break;
+  // The decimal text compares exactly with NUMBER(8,2), a float would not
+  case 5: Key = _QuantityText; break;
+  default:
+    _Query.Where("o.order_id" + Op, { _Order.OrderId });
+    return;
+  }
+
+  const auto Column = "o." + ORDERS_SORT_COLUMNS.at(_ColIdx);
+  _Query.Where(Column + Op + " OR (" + Column + " = ? AND o.order_id" + Op + ")", { Key, Key, _Order.OrderId });
+}
+
+double ToTime(
+    const oci::Date & _Date
+  )
+{
+  std::tm Time{};
+  int Year = 0;
+  unsigned Month = 0, Day = 0, Hour = 0, Minute = 0, Second = 0;
+  _Date.getDate(Year, Month, Day, Hour, Minute, Second);
+
+  Time.tm_year = Year - 1900;
+  Time.tm_mon  = Month - 1;
+  Time.tm_mday = Day;
+  Time.tm_hour = Hour;
+  Time.tm_min  = Minute;
+  Time.tm_sec  = Second;
+
+  return static_cast<double>(std::mktime(&Time));
+}
+
+// Sales per day of every order, for a paged orders table the client does not hold
+const std::string DAILY_SALES_QUERY =
+    "SELECT TRUNC(o.order_date), SUM(p.price * o.quantity), SUM(p.cost * o.quantity) "
+    "FROM orders o "
+    "JOIN products p ON p.product_id = o.product_id "
+    "GROUP BY TRUNC(o.order_date)";
+
+} // namespace
+
 AdminWindow::AdminWindow(
     oci::Environment * _Env,
     oci::Connection * _Conn,
@@ -22,7 +86,8 @@ AdminWindow::AdminWindow(
     ProductCategoriesTableWindow * _Categories,
     OrdersTableWindow * _Orders,
     InventoriesTableWindow * _Inventories,
-    WarehousesTableWindow * _Warehouses
+    WarehousesTableWindow * _Warehouses,
+    ExportWindow * _Export
   ) :
     m_Env{ _Env },
     m_Conn{ _Conn },
@@ -31,35 +96,46 @@ AdminWindow::AdminWindow(
     m_Categories{ _Categories },
     m_Orders{ _Orders },
     m_Inventories{ _Inventories },
-    m_Warehouses{ _Warehouses }
+    m_Warehouses{ _Warehouses },
+    m_Export{ _Export },
+    m_SearchBuffer(256, '\0')
 {
-  m_MakeOrderStmt = m_Conn->createStatement("SELECT * FROM inventories");
+  m_SignalConnections.AddConnection(m_Products->TableChangedSignal, this, &AdminWindow::OnTableChanged);
+  m_SignalConnections.AddConnection(m_Customers->TableChangedSignal, this, &AdminWindow::OnTableChanged);
+  m_SignalConnections.AddConnection(m_Categories->TableChangedSignal, this, &AdminWindow::OnTableChanged);
+  m_SignalConnections.AddConnection(m_Orders->TableChangedSignal, this, &AdminWindow::OnTableChanged);
+  m_SignalConnections.AddConnection(m_Inventories->TableChangedSignal, this, &AdminWindow::OnTableChanged);
+  m_SignalConnections.AddConnection(m_Warehouses->TableChangedSignal, this, &AdminWindow::OnTableChanged);
 
-  m_SignalConnections.AddConnection(m_Products->TableChangedSignal, this, &AdminWindow::UpdateData);
-  m_SignalConnections.AddConnection(m_Customers->TableChangedSignal, this, &AdminWindow::UpdateData);
-  m_SignalConnections.AddConnection(m_Categories->TableChangedSignal, this, &AdminWindow::UpdateData);
-  m_SignalConnections.AddConnection(m_Orders->TableChangedSignal, this, &AdminWindow::UpdateData);
-  m_SignalConnections.AddConnection(m_Inventories->TableChangedSignal, this, &AdminWindow::UpdateData);
-  m_SignalConnections.AddConnection(m_Warehouses->TableChangedSignal, this, &AdminWindow::UpdateData);
+  m_SalesStmt = DBStatement(m_Conn, DAILY_SALES_QUERY);
 
   for (const auto & Status : ORDER_STATUS_LIST)
     m_StatusFilter[Status] = true;
+
+  UpdateFilter();
 }
 
 AdminWindow::~AdminWindow()
 {
-  m_Conn->terminateStatement(m_MakeOrderStmt);
-
   m_SignalConnections.Disconnect();
 }
 
 void AdminWindow::OnUIRender()
 {
-  ImGui::Begin("Admin panel");
+  WL_TRACE_SCOPE_CAT("render", __FUNCTION__);
+
+  const bool IsVisible = ImGui::Begin("Admin panel");
 
   if (ImGui::IsWindowAppearing())
     m_NeedUpdate = true;
 
+  // Table changes are only marked while hidden, the orders and charts are rebuilt once it is shown
+  if (!IsVisible)
+  {
+    ImGui::End();
+    return;
+  }
+
   if (m_NeedUpdate)
   {
     UpdateData();
@@ -115,28 +191,220 @@ void AdminWindow::CloseErrorWindow()
   m_IsError = false;
 }
 
+void AdminWindow::OnTableChanged()
+{
+  m_NeedUpdate = true;
+}
+
 void AdminWindow::UpdateData()
 {
+  WL_TRACE_SCOPE_CAT("app", __FUNCTION__);
+
+  UpdateSales();
+
   m_OrderEntries.clear();
+  m_HasMoreOrders = false;
+
+  m_IsPushedDown = ShouldPushDown(m_Orders->GetTable().size(), m_Orders->GetRowCount());
+  if (m_IsPushedDown)
+  {
+    // As many orders as were scrolled through, the cards do not jump when a status changes
+    FetchFilteredOrders(std::max(m_PushedDownRows, ORDERS_PAGE_ROWS));
+    UpdateVisibleEntries();
+    return;
+  }
+
+  // One version of each table for the whole join, a table published meanwhile does not change them
+  const auto CustomerRows = m_Customers->GetSnapshot();
+  const auto ProductRows = m_Products->GetSnapshot();
+  const auto OrderRows = m_Orders->GetSnapshot();
 
   std::unordered_map<int, OrderCustomerData> Customers;
   std::unordered_map<int, OrderProductData> Products;
 
-  for (const auto & [CustomerId, FirstName, LastName, Address, Email, Country] : m_Customers->GetTable())
+  for (const auto & [CustomerId, FirstName, LastName, Address, Email, Country] : *CustomerRows)
     Customers.emplace(CustomerId, OrderCustomerData{ CustomerId, FirstName, LastName, Address });
 
-  for (const auto & [ProductId, Name, Description, Cost, Price, Category] : m_Products->GetTable())
+  for (const auto & [ProductId, Name, Cost, Price, Category] : *ProductRows)
     Products.emplace(ProductId, OrderProductData{ ProductId, Name, Cost, Price });
 
-  for (const auto & [OrderId, CustomerId, OrderStatus, Date, ProductId, Quantity] : m_Orders->GetTable())
+  for (const auto & [OrderId, CustomerId, OrderStatus, Date, ProductId, Quantity] : *OrderRows)
+  {
+    // Tables restored from the snapshot are revalidated one by one, an order may briefly reference a row not loaded yet
+    const auto CustomerIt = Customers.find(CustomerId);
+    const auto ProductIt = Products.find(ProductId);
+    if (CustomerIt == Customers.end() || ProductIt == Products.end())
+      continue;
+
     m_OrderEntries.emplace_back(OrderEntry{
         OrderId,
         Quantity,
         OrderStatus,
         Date,
-        Customers.at(CustomerId),
-        Products.at(ProductId)
+        CustomerIt->second,
+        ProductIt->second
+      });
+  }
+
+  UpdateVisibleEntries();
+}
+
+void AdminWindow::UpdateSales()
+{
+  WL_TRACE_SCOPE_CAT("app", __FUNCTION__);
+
+  m_Sales.clear();
+
+  if (m_Orders->IsPaged())
+  {
+    try
+    {
+      Table<oci::Date, double, double> Rows;
+      m_SalesStmt.FetchInto(Rows, [](oci::ResultSet * _Result)
+      {
+        return std::make_tuple(_Result->getDate(1), _Result->getDouble(2), _Result->getDouble(3));
       });
+
+      m_Sales.reserve(Rows.size());
+      for (const auto & [Date, Income, Outlay] : Rows)
+        m_Sales.emplace_back(SalesPoint{ Income, Outlay, ToTime(Date) });
+    }
+    catch (const oci::SQLException & ex)
+    {
+      OpenErrorWindow(ex.what());
+    }
+  }
+  else
+  {
+    const auto ProductRows = m_Products->GetSnapshot();
+    const auto OrderRows = m_Orders->GetSnapshot();
+
+    std::unordered_map<int, std::pair<float, float>> Prices;
+    for (const auto & [ProductId, Name, Cost, Price, Category] : *ProductRows)
+      Prices.emplace(ProductId, std::make_pair(Price, Cost));
+
+    m_Sales.reserve(OrderRows->size());
+    for (const auto & [OrderId, CustomerId, OrderStatus, Date, ProductId, Quantity] : *OrderRows)
+    {
+      const auto PriceIt = Prices.find(ProductId);
+      if (PriceIt != Prices.end())
+        m_Sales.emplace_back(SalesPoint{ PriceIt->second.first * Quantity, PriceIt->second.second * Quantity, ToTime(Date) });
+    }
+  }
+
+  {
+    WL_TRACE_SCOPE_CAT("sort", "AdminWindow::UpdateSales sort");
+    std::sort(m_Sales.begin(), m_Sales.end(), [](const auto _lhs, const auto _rhs) { return _lhs.Date < _rhs.Date; });
+  }
+
+  m_CumulativeSales = m_Sales;
+  for (std::size_t i = 1; i < m_CumulativeSales.size(); ++i)
+  {
+    m_CumulativeSales[i].Income += m_CumulativeSales[i - 1].Income;
+    m_CumulativeSales[i].Outlay += m_CumulativeSales[i - 1].Outlay;
+  }
+}
+
+QueryBuilder AdminWindow::BuildFilterQuery() const
+{
+  QueryBuilder Query(
+      "SELECT o.order_id, o.quantity, o.status, o.order_date, "
+      "c.customer_id, c.first_name, c.last_name, c.address, "
+      "p.product_id, p.product_name, p.cost, p.price "
+      "FROM orders o "
+      "JOIN customers c ON c.customer_id = o.customer_id "
+      "JOIN products p ON p.product_id = o.product_id"
+    );
+
+  ApplyOrderFilter(Query, m_Filter);
+
+  // Same order as the orders window, as when the entries are built from its table
+  const auto & SortPredicate = m_Orders->GetSortPredicate();
+  Query.OrderBy("o." + ORDERS_SORT_COLUMNS.at(SortPredicate.m_ColIdx), SortPredicate.m_SortDir);
+  if (SortPredicate.m_ColIdx != 0)
+    Query.OrderBy("o.order_id", SortPredicate.m_SortDir);
+
+  return Query;
+}
+
+void AdminWindow::FetchFilteredOrders(
+    std::size_t _Rows
+  )
+{
+  auto Query = BuildFilterQuery();
+
+  if (!m_OrderEntries.empty())
+  {
+    const auto & SortPredicate = m_Orders->GetSortPredicate();
+    WhereAfter(Query, m_OrderEntries.back(), m_LastQuantityText, SortPredicate.m_ColIdx, SortPredicate.m_SortDir);
+  }
+  Query.Limit(static_cast<int>(_Rows));
+
+  try
+  {
+    // Filters produce a handful of distinct statements, keep the last one prepared
+    auto Sql = Query.GetSql();
+    if (Sql != m_FilterSql)
+    {
+      m_FilterStmt = DBStatement(m_Conn, Sql);
+      m_FilterSql = std::move(Sql);
+    }
+
+    Query.Bind(m_FilterStmt.Get());
+
+    Table<int, float, EOrderStatus, oci::Date, int, std::string, std::string, std::string, int, std::string, float, float> Rows;
+    std::string LastQuantityText;
+    m_FilterStmt.FetchInto(Rows, [&](oci::ResultSet * _Result)
+    {
+      LastQuantityText = _Result->getString(2);
+
+      return std::make_tuple(
+          _Result->getInt(1),
+          _Result->getFloat(2),
+          STRING_TO_ORDER_STATUS.at(_Result->getString(3)),
+          _Result->getDate(4),
+          _Result->getInt(5),
+          _Result->getString(6),
+          _Result->getString(7),
+          _Result->getString(8),
+          _Result->getInt(9),
+          _Result->getString(10),
+          _Result->getFloat(11),
+          _Result->getFloat(12)
+        );
+    });
+
+    m_OrderEntries.reserve(Rows.size());
+    for (auto & [OrderId, Quantity, Status, Date, CustomerId, FirstName, LastName, Address, ProductId, ProductName, Cost, Price] : Rows)
+      m_OrderEntries.emplace_back(OrderEntry{
+          OrderId,
+          Quantity,
+          Status,
+          Date,
+          OrderCustomerData{ CustomerId, std::move(FirstName), std::move(LastName), std::move(Address) },
+          OrderProductData{ ProductId, std::move(ProductName), Cost, Price }
+        });
+
+    if (!Rows.empty())
+      m_LastQuantityText = std::move(LastQuantityText);
+
+    m_HasMoreOrders = Rows.size() == _Rows;
+    m_PushedDownRows = m_OrderEntries.size();
+  }
+  catch (const oci::SQLException & ex)
+  {
+    m_FilterSql.clear();
+    m_HasMoreOrders = false;
+    OpenErrorWindow(ex.what());
+  }
+}
+
+void AdminWindow::UpdateVisibleEntries()
+{
+  m_VisibleEntries.clear();
+  for (std::size_t i = 0; i < m_OrderEntries.size(); ++i)
+    if (IsFilterSuitable(m_OrderEntries[i]))
+      m_VisibleEntries.push_back(i);
 }
 
 void AdminWindow::RenderOrderEntry(
@@ -214,69 +482,127 @@ void AdminWindow::RenderAdminPanel()
 
   if (ImGui::BeginPopup("FiltersPopup"))
   {
+    bool IsChanged = false;
+
     ImGui::BeginGroup();
     ImGui::TextUnformatted("Order statuses");
     ImGui::Separator();
     for (const auto & [Status, String]: ORDER_STATUS_TO_STRING)
-      ImGui::MenuItem(String.c_str(), nullptr, &m_StatusFilter[Status]);
+      IsChanged |= ImGui::MenuItem(String.c_str(), nullptr, &m_StatusFilter[Status]);
+    ImGui::EndGroup();
+
+    ImGui::SameLine();
+
+    ImGui::BeginGroup();
+    ImGui::TextUnformatted("Orders");
+    ImGui::Separator();
+    IsChanged |= ImGui::Checkbox("##From", &m_IsFromEnabled);
+    ImGui::SameLine();
+    IsChanged |= ImGui::InputInt3("From (D M Y)", m_FromDate) && m_IsFromEnabled;
+    IsChanged |= ImGui::Checkbox("##To", &m_IsToEnabled);
+    ImGui::SameLine();
+    IsChanged |= ImGui::InputInt3("To (D M Y)", m_ToDate) && m_IsToEnabled;
+    IsChanged |= ImGui::InputInt("Customer ID (0 - any)", &m_CustomerFilterId);
+    IsChanged |= ImGui::InputInt("Product ID (0 - any)", &m_ProductFilterId);
+    IsChanged |= ImGui::InputText("Search", m_SearchBuffer.data(), m_SearchBuffer.size());
     ImGui::EndGroup();
 
+    if (IsChanged)
+    {
+      UpdateFilter();
+      if (m_IsPushedDown)
+      {
+        m_PushedDownRows = 0;
+        m_NeedUpdate = true;
+      }
+      else
+      {
+        UpdateVisibleEntries();
+      }
+    }
+
     ImGui::EndPopup();
   }
 
+  ImGui::SameLine();
+  if (ImGui::Button("Export"))
+    m_Export->SetViewSource("filtered_orders", BuildFilterQuery());
+
+  ImGui::SameLine();
+  if (!m_IsPushedDown)
+    ImGui::TextDisabled("%zu orders", m_OrderEntries.size());
+  else if (m_HasMoreOrders)
+    ImGui::TextDisabled("First %zu orders, filtered by the server", m_OrderEntries.size());
+  else
+    ImGui::TextDisabled("%zu orders, filtered by the server", m_OrderEntries.size());
+
   ImGui::Separator();
 
   ImGui::BeginChild("ProductsList", ImVec2(-1, -1), true);
 
-  for (std::size_t i = 0; i < m_OrderEntries.size(); ++i)
-    if (IsFilterSuitable(m_OrderEntries.at(i)))
-      RenderOrderEntry(m_OrderEntries.at(i));
+  // The cards are the same height, only those on screen are laid out
+  bool IsLastVisible = false;
+  ImGuiListClipper Clipper;
+  Clipper.Begin(static_cast<int>(m_VisibleEntries.size()));
+  while (Clipper.Step())
+  {
+    for (int Idx = Clipper.DisplayStart; Idx < Clipper.DisplayEnd; ++Idx)
+      RenderOrderEntry(m_OrderEntries[m_VisibleEntries[Idx]]);
+
+    IsLastVisible |= Clipper.DisplayEnd == static_cast<int>(m_VisibleEntries.size());
+  }
 
   ImGui::EndChild();
+
+  // Scrolled down to the last card, the next page follows it
+  if (IsLastVisible && m_HasMoreOrders)
+  {
+    FetchFilteredOrders(ORDERS_PAGE_ROWS);
+    UpdateVisibleEntries();
+  }
+}
+
+void AdminWindow::UpdateFilter()
+{
+  m_Filter = OrderFilter{};
+
+  for (const auto Status : ORDER_STATUS_LIST)
+    if (m_StatusFilter.at(Status))
+      m_Filter.Statuses.push_back(Status);
+
+  if (m_IsFromEnabled)
+    m_Filter.From = oci::Date(m_Env, m_FromDate[2], std::clamp(m_FromDate[1], 1, 12), std::clamp(m_FromDate[0], 1, 31));
+  if (m_IsToEnabled)
+    m_Filter.To = oci::Date(m_Env, m_ToDate[2], std::clamp(m_ToDate[1], 1, 12), std::clamp(m_ToDate[0], 1, 31));
+
+  if (m_CustomerFilterId > 0)
+    m_Filter.CustomerId = m_CustomerFilterId;
+  if (m_ProductFilterId > 0)
+    m_Filter.ProductId = m_ProductFilterId;
+
+  m_Filter.Search = m_SearchBuffer.data();
 }
 
 bool AdminWindow::IsFilterSuitable(
     const OrderEntry & _Order
   ) const
 {
-  return m_StatusFilter.at(_Order.Status);
+  if (m_IsPushedDown)
+    return true;
+
+  return IsOrderSuitable(
+      m_Filter,
+      _Order.Status,
+      _Order.Date,
+      _Order.Customer.Id,
+      _Order.Product.Id,
+      _Order.Customer.FirstName + ' ' + _Order.Customer.LastName,
+      _Order.Product.ProductName
+    );
 }
 
 void AdminWindow::RenderCharts()
 {
-  struct SalesPoint
-  {
-    double Income, Outlay, Date;
-  };
-
-  std::vector<SalesPoint> Data;
-
-  for (const auto & Order : m_OrderEntries)
-  {
-    std::tm OrderDate{};
-    int Year = 0;
-    unsigned Month = 0, Day = 0, Hour = 0, Minute = 0, Second = 0;
-    Order.Date.getDate(Year, Month, Day, Hour, Minute, Second);
-
-    OrderDate.tm_year = Year - 1900;
-    OrderDate.tm_mon  = Month - 1;
-    OrderDate.tm_mday = Day;
-    OrderDate.tm_hour = Hour;
-    OrderDate.tm_min  = Minute;
-    OrderDate.tm_sec  = Second;
-
-    const double Income = Order.Product.Price * Order.Quantity;
-    const double Outlay = Order.Product.Cost * Order.Quantity;
-
-    Data.emplace_back(SalesPoint{
-        Income,
-        Outlay,
-        static_cast<double>(std::mktime(&OrderDate))
-      });
-  }
-
-  std::sort(Data.begin(), Data.end(), [](const auto _lhs, const auto _rhs) { return _lhs.Date < _rhs.Date; });
-
   auto IncomeGetter = [](int _i, void * _point) -> ImPlotPoint
   {
     const auto & Point = static_cast<SalesPoint *>(_point)[_i];
@@ -301,27 +627,21 @@ void AdminWindow::RenderCharts()
     ImPlot::SetupAxisScale(ImAxis_X1, ImPlotScale_Time);
     ImPlot::SetupAxisFormat(ImAxis_Y1, "$%.0f");
 
-    ImPlot::PlotLineG("Income", IncomeGetter, Data.data(), Data.size(), ImPlotLineFlags_Shaded);
-    ImPlot::PlotLineG("Outlay", OutlayGetter, Data.data(), Data.size(), ImPlotLineFlags_Shaded);
-    ImPlot::PlotLineG("Profit", ProfitGetter, Data.data(), Data.size(), ImPlotLineFlags_Shaded);
+    ImPlot::PlotLineG("Income", IncomeGetter, m_Sales.data(), m_Sales.size(), ImPlotLineFlags_Shaded);
+    ImPlot::PlotLineG("Outlay", OutlayGetter, m_Sales.data(), m_Sales.size(), ImPlotLineFlags_Shaded);
+    ImPlot::PlotLineG("Profit", ProfitGetter, m_Sales.data(), m_Sales.size(), ImPlotLineFlags_Shaded);
     ImPlot::EndPlot();
   }
 
-  for (std::size_t i = 1; i < Data.size(); ++i)
-  {
-    Data[i].Income += Data[i - 1].Income;
-    Data[i].Outlay += Data[i - 1].Outlay;
-  }
-
   if (ImPlot::BeginPlot("Cumulative sales", ImVec2(-1, -1)))
   {
     ImPlot::SetupAxes("Days", "Sales");
     ImPlot::SetupAxisScale(ImAxis_X1, ImPlotScale_Time);
     ImPlot::SetupAxisFormat(ImAxis_Y1, "$%.0f");
 
-    ImPlot::PlotLineG("Income", IncomeGetter, Data.data(), Data.size(), ImPlotLineFlags_Shaded);
-    ImPlot::PlotLineG("Outlay", OutlayGetter, Data.data(), Data.size(), ImPlotLineFlags_Shaded);
-    ImPlot::PlotLineG("Profit", ProfitGetter, Data.data(), Data.size(), ImPlotLineFlags_Shaded);
+    ImPlot::PlotLineG("Income", IncomeGetter, m_CumulativeSales.data(), m_CumulativeSales.size(), ImPlotLineFlags_Shaded);
+    ImPlot::PlotLineG("Outlay", OutlayGetter, m_CumulativeSales.data(), m_CumulativeSales.size(), ImPlotLineFlags_Shaded);
+    ImPlot::PlotLineG("Profit", ProfitGetter, m_CumulativeSales.data(), m_CumulativeSales.size(), ImPlotLineFlags_Shaded);
     ImPlot::EndPlot();
   }
 }
@@ -2,6 +2,8 @@
 
 #include "ISLabApp.h"
 #include "IWindow.h"
+#include "DBStatement.h"
+#include "QueryBuilder.h"
 
 #include <imgui.h>
 #include <vector>
@@ -16,6 +18,7 @@ class ProductCategoriesTableWindow;
 class OrdersTableWindow;
 class InventoriesTableWindow;
 class WarehousesTableWindow;
+class ExportWindow;
 
 struct OrderCustomerData
 {
@@ -43,6 +46,11 @@ struct OrderEntry
   OrderProductData Product;
 };
 
+struct SalesPoint
+{
+  double Income, Outlay, Date;
+};
+
 class AdminWindow
   : public IWindow
 {
@@ -56,7 +64,8 @@ public:
       ProductCategoriesTableWindow * _Categories,
       OrdersTableWindow * _Orders,
       InventoriesTableWindow * _Inventories,
-      WarehousesTableWindow * _Warehouses
+      WarehousesTableWindow * _Warehouses,
+      ExportWindow * _Export
     );
 
   ~AdminWindow();
@@ -70,6 +79,8 @@ public:
   void CloseErrorWindow();
 
   void UpdateData();
+  // Defers UpdateData to the next frame the window is visible, any number of changes rebuild it once
+  void OnTableChanged();
 
   void RenderOrderEntry(
       OrderEntry & _Order
@@ -77,19 +88,34 @@ public:
 
   void RenderAdminPanel();
 
+  // Rebuilds m_Filter from the filter widgets
+  void UpdateFilter();
+
   bool IsFilterSuitable(
       const OrderEntry & _Order
     ) const;
 
   void RenderCharts();
 
+  // Orders matching m_Filter joined with their customers and products, in the order of the orders window
+  QueryBuilder BuildFilterQuery() const;
+
 private:
 
+  // Appends up to _Rows orders matching m_Filter, the server picks up after the last entry
+  void FetchFilteredOrders(
+      std::size_t _Rows
+    );
+
+  // Rebuilds m_VisibleEntries from m_OrderEntries and m_Filter
+  void UpdateVisibleEntries();
+
+  // Rebuilds the chart series from every order, the cards may hold one page of them only
+  void UpdateSales();
+
   oci::Environment * m_Env = nullptr;
   oci::Connection * m_Conn = nullptr;
 
-  oci::Statement * m_MakeOrderStmt = nullptr;
-
   bool m_IsError = false;
   bool m_NeedUpdate = true;
 
@@ -101,9 +127,37 @@ private:
   OrdersTableWindow * m_Orders = nullptr;
   InventoriesTableWindow * m_Inventories = nullptr;
   WarehousesTableWindow * m_Warehouses = nullptr;
+  ExportWindow * m_Export = nullptr;
 
   sig::CMultiConnection m_SignalConnections;
 
   std::vector<OrderEntry> m_OrderEntries;
+  // Indices of the entries passing m_Filter, in m_OrderEntries order
+  std::vector<std::size_t> m_VisibleEntries;
   std::unordered_map<EOrderStatus, bool> m_StatusFilter;
+
+  bool m_IsFromEnabled = false;
+  bool m_IsToEnabled = false;
+  int m_FromDate[3] = { 1, 1, 2022 };
+  int m_ToDate[3] = { 31, 12, 2022 };
+  int m_CustomerFilterId = 0;
+  int m_ProductFilterId = 0;
+  std::vector<char> m_SearchBuffer;
+
+  OrderFilter m_Filter;
+
+  // Set when m_OrderEntries holds only the orders matching m_Filter, fetched by the server
+  bool m_IsPushedDown = false;
+  // Set while the server may hold more matching orders than fetched so far
+  bool m_HasMoreOrders = false;
+  // Orders fetched for the current filter, refetched at once when the tables change
+  std::size_t m_PushedDownRows = 0;
+  std::vector<SalesPoint> m_Sales;
+  std::vector<SalesPoint> m_CumulativeSales;
+  DBStatement m_SalesStmt;
+
+  // Quantity of the last entry as the server formats it, the keyset bound of the next page
+  std::string m_LastQuantityText;
+  DBStatement m_FilterStmt;
+  std::string m_FilterSql;
 };
\ No newline at end of file
@@ -0,0 +1,568 @@
+#include "BulkImport.h"
+
+#include "CsvReader.h"
+#include "DBStatement.h"
+
+#include <Walnut/Application.h>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace
+{
+
+constexpr std::size_t NAME_BUFFER_SIZE = 255 + 1;
+constexpr std::size_t DESCRIPTION_BUFFER_SIZE = 2000 + 1;
+
+// Rows read between progress updates while every row is rejected and no batch fills up
+constexpr std::uint64_t REPORT_INTERVAL = 4096;
+
+std::string_view Trim(
+    std::string_view _Field
+  )
+{
+  const auto Begin = _Field.find_first_not_of(" \t");
+  if (Begin == std::string_view::npos)
+    return {};
+  return _Field.substr(Begin, _Field.find_last_not_of(" \t") - Begin + 1);
+}
+
+template<typename TValue>
+bool ParseField(
+    std::string_view _Field,
+    TValue & _Value
+  )
+{
+  _Field = Trim(_Field);
+  const auto * End = _Field.data() + _Field.size();
+  const auto [Pos, Error] = std::from_chars(_Field.data(), End, _Value);
+  return Error == std::errc() && Pos == End;
+}
+
+void CopyField(
+    std::string_view _Field,
+    char * _Slot
+  )
+{
+  std::memcpy(_Slot, _Field.data(), _Field.size());
+  _Slot[_Field.size()] = '\0';
+}
+
+// Column arrays of one array insert, each Add fills the next row
+class ProductBatch
+{
+public:
+
+  static constexpr const char * SQL =
+      "INSERT INTO products(product_name, description, cost, price, category_id) VALUES(:1, :2, :3, :4, :5)";
+
+  explicit ProductBatch(
+      std::size_t _Capacity
+    ) :
+      m_Names(_Capacity * NAME_BUFFER_SIZE),
+      m_Descriptions(_Capacity * DESCRIPTION_BUFFER_SIZE),
+      m_Costs(_Capacity),
+      m_Prices(_Capacity),
+      m_CategoryIds(_Capacity),
+      m_NameLengths(_Capacity, static_cast<unsigned short>(NAME_BUFFER_SIZE)),
+      m_DescriptionLengths(_Capacity, static_cast<unsigned short>(DESCRIPTION_BUFFER_SIZE)),
+      m_FloatLengths(_Capacity, sizeof(float)),
+      m_IntLengths(_Capacity, sizeof(int))
+  {
+  }
+
+  // Returns the reason the row was rejected, or nullptr if it was added
+  const char * Add(
+      const std::vector<std::string_view> & _Fields,
+      const ImportKeys & _Keys
+    )
+  {
+    if (_Fields.size() != 5)
+      return "expected 5 fields: product_name, description, cost, price, category_id";
+    if (_Fields[0].empty() || _Fields[0].size() >= NAME_BUFFER_SIZE)
+      return "product name is empty or longer than 255 characters";
+    if (_Fields[1].size() >= DESCRIPTION_BUFFER_SIZE)
+      return "description is longer than 2000 characters";
+    if (!ParseField(_Fields[2], m_Costs[m_Size]) || m_Costs[m_Size] < 0)
+      return "cost is not a non-negative number";
+    if (!ParseField(_Fields[3], m_Prices[m_Size]) || m_Prices[m_Size] < 0)
+      return "price is not a non-negative number";
+    if (!ParseField(_Fields[4], m_CategoryIds[m_Size]))
+      return "category id is not a number";
+    if (_Keys.Categories.count(m_CategoryIds[m_Size]) == 0)
+      return "unknown category id";
+
+    CopyField(_Fields[0], &m_Names[m_Size * NAME_BUFFER_SIZE]);
+    CopyField(_Fields[1], &m_Descriptions[m_Size * DESCRIPTION_BUFFER_SIZE]);
+    ++m_Size;
+    return nullptr;
+  }
+
+  void Bind(
+      DBStatement & _Stmt
+    )
+  {
+    _Stmt->setDataBuffer(1, m_Names.data(), oci::OCCI_SQLT_STR, NAME_BUFFER_SIZE, m_NameLengths.data());
+    _Stmt->setDataBuffer(2, m_Descriptions.data(), oci::OCCI_SQLT_STR, DESCRIPTION_BUFFER_SIZE, m_DescriptionLengths.data());
+    _Stmt->setDataBuffer(3, m_Costs.data(), oci::OCCIFLOAT, sizeof(float), m_FloatLengths.data());
+    _Stmt->setDataBuffer(4, m_Prices.data(), oci::OCCIFLOAT, sizeof(float), m_FloatLengths.data());
+    _Stmt->setDataBuffer(5, m_CategoryIds.data(), oci::OCCIINT, sizeof(int), m_IntLengths.data());
+  }
+
+  std::size_t GetSize() const
+  {
+    return m_Size;
+  }
+
+  void Clear()
+  {
+    m_Size = 0;
+  }
+
+private:
+
+  std::size_t m_Size = 0;
+
+  std::vector<char> m_Names;
+  std::vector<char> m_Descriptions;
+  std::vector<float> m_Costs;
+  std::vector<float> m_Prices;
+  std::vector<int> m_CategoryIds;
+
+  std::vector<unsigned short> m_NameLengths;
+  std::vector<unsigned short> m_DescriptionLengths;
+  std::vector<unsigned short> m_FloatLengths;
+  std::vector<unsigned short> m_IntLengths;
+};
+
+class InventoryBatch
+{
+public:
+
+  // Stock counts are usually re-imported, so a known (product, warehouse) pair gets the new quantity instead of failing the batch
+  static constexpr const char * SQL =
+      "MERGE INTO inventories i "
+      "USING (SELECT :1 AS product_id, :2 AS warehouse_id, :3 AS quantity FROM dual) s "
+      "ON (i.product_id = s.product_id AND i.warehouse_id = s.warehouse_id) "
+      "WHEN MATCHED THEN UPDATE SET i.quantity = s.quantity "
+      "WHEN NOT MATCHED THEN INSERT (product_id, warehouse_id, quantity) VALUES (s.product_id, s.warehouse_id, s.quantity)";
+
+  explicit InventoryBatch(
+      std::size_t _Capacity
+    ) :
+      m_ProductIds(_Capacity),
+      m_WarehouseIds(_Capacity),
+      m_Quantities(_Capacity),
+      m_IntLengths(_Capacity, sizeof(int))
+  {
+  }
+
+  const char * Add(
+      const std::vector<std::string_view> & _Fields,
+      const ImportKeys & _Keys
+    )
+  {
+    if (_Fields.size() != 3)
+      return "expected 3 fields: product_id, warehouse_id, quantity";
+    if (!ParseField(_Fields[0], m_ProductIds[m_Size]))
+      return "product id is not a number";
+    if (!ParseField(_Fields[1], m_WarehouseIds[m_Size]))
+      return "warehouse id is not a number";
+    if (!ParseField(_Fields[2], m_Quantities[m_Size]) || m_Quantities[m_Size] < 0)
+      return "quantity is not a non-negative number";
+    if (_Keys.Products.count(m_ProductIds[m_Size]) == 0)
+      return "unknown product id";
+    if (_Keys.Warehouses.count(m_WarehouseIds[m_Size]) == 0)
+      return "unknown warehouse id";
+
+    ++m_Size;
+    return nullptr;
+  }
+
+  void Bind(
+      DBStatement & _Stmt
+    )
+  {
+    _Stmt->setDataBuffer(1, m_ProductIds.data(), oci::OCCIINT, sizeof(int), m_IntLengths.data());
+    _Stmt->setDataBuffer(2, m_WarehouseIds.data(), oci::OCCIINT, sizeof(int), m_IntLengths.data());
+    _Stmt->setDataBuffer(3, m_Quantities.data(), oci::OCCIINT, sizeof(int), m_IntLengths.data());
+  }
+
+  std::size_t GetSize() const
+  {
+    return m_Size;
+  }
+
+  void Clear()
+  {
+    m_Size = 0;
+  }
+
+private:
+
+  std::size_t m_Size = 0;
+
+  std::vector<int> m_ProductIds;
+  std::vector<int> m_WarehouseIds;
+  std::vector<int> m_Quantities;
+  std::vector<unsigned short> m_IntLengths;
+};
+
+void FetchKeyColumn(
+    oci::Connection * _Conn,
+    const char * _Sql,
+    std::unordered_set<int> & _Keys
+  )
+{
+  Table<int> Rows;
+  DBStatement Stmt(_Conn, _Sql);
+  Stmt.FetchInto(Rows, [](oci::ResultSet * _Result)
+  {
+    return std::make_tuple(_Result->getInt(1));
+  });
+
+  for (const auto & [Key] : Rows)
+    _Keys.insert(Key);
+}
+
+bool ParseCount(
+    const char * _Arg,
+    int & _Value
+  )
+{
+  return ParseField(_Arg, _Value) && _Value > 0;
+}
+
+} // namespace
+
+double ImportProgress::GetRowsPerSecond() const
+{
+  return ElapsedSeconds > 0.0 ? RowsRead / ElapsedSeconds : 0.0;
+}
+
+BulkImport::BulkImport(
+    oci::Environment * _Env,
+    std::string _UserName,
+    std::string _Password,
+    std::string _ConnectString
+  ) :
+    m_Env{ _Env },
+    m_UserName{ std::move(_UserName) },
+    m_Password{ std::move(_Password) },
+    m_ConnectString{ std::move(_ConnectString) }
+{
+}
+
+BulkImport::~BulkImport()
+{
+  Cancel();
+  if (m_Done.valid())
+    m_Done.wait();
+}
+
+void BulkImport::Start(
+    ImportOptions _Options,
+    ImportKeys _Keys
+  )
+{
+  if (IsRunning())
+    return;
+
+  m_IsCancelled = false;
+  Begin();
+
+  m_Done = std::async(std::launch::async, [this, Options = std::move(_Options), Keys = std::move(_Keys)]()
+  {
+    oci::Connection * Conn = nullptr;
+    try
+    {
+      Conn = m_Env->createConnection(m_UserName, m_Password, m_ConnectString);
+    }
+    catch (const oci::SQLException & ex)
+    {
+      return Finish(ex.what());
+    }
+
+    Run(Conn, Options, Keys);
+    m_Env->terminateConnection(Conn);
+  });
+}
+
+void BulkImport::Run(
+    oci::Connection * _Conn,
+    const ImportOptions & _Options,
+    const ImportKeys & _Keys
+  )
+{
+  WL_TRACE_SCOPE_CAT("sql", __FUNCTION__);
+
+  Begin();
+
+  CsvReader Reader(_Options.Path);
+  if (!Reader.IsOpen())
+    return Finish("Cannot open " + _Options.Path);
+
+  {
+    std::scoped_lock Lock(m_Mutex);
+    m_Progress.FileSize = Reader.GetFileSize();
+  }
+
+  try
+  {
+    if (_Options.Target == EImportTarget::PRODUCTS)
+      Import<ProductBatch>(_Conn, Reader, _Options, _Keys);
+    else
+      Import<InventoryBatch>(_Conn, Reader, _Options, _Keys);
+  }
+  catch (const oci::SQLException & ex)
+  {
+    return Finish("Batch ending at line " + std::to_string(Reader.GetLine()) + ": " + ex.what());
+  }
+
+  if (Reader.IsRecordTooLong())
+    return Finish("Record after line " + std::to_string(Reader.GetLine()) + " does not fit the read buffer");
+
+  Finish(m_IsCancelled ? "Cancelled" : "");
+}
+
+void BulkImport::Cancel()
+{
+  m_IsCancelled = true;
+}
+
+bool BulkImport::IsRunning() const
+{
+  return m_Done.valid() && m_Done.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+}
+
+ImportProgress BulkImport::GetProgress() const
+{
+  std::scoped_lock Lock(m_Mutex);
+
+  ImportProgress Progress = m_Progress;
+  if (Progress.IsRunning)
+    Progress.ElapsedSeconds = std::chrono::duration<double>(Clock::now() - m_StartTime).count();
+
+  return Progress;
+}
+
+ImportKeys BulkImport::FetchKeys(
+    oci::Connection * _Conn,
+    EImportTarget _Target
+  )
+{
+  ImportKeys Keys;
+  if (_Target == EImportTarget::PRODUCTS)
+  {
+    FetchKeyColumn(_Conn, "SELECT category_id FROM product_categories", Keys.Categories);
+  }
+  else
+  {
+    FetchKeyColumn(_Conn, "SELECT product_id FROM products", Keys.Products);
+    FetchKeyColumn(_Conn, "SELECT warehouse_id FROM warehouses", Keys.Warehouses);
+  }
+  return Keys;
+}
+
+const char * BulkImport::GetTargetName(
+    EImportTarget _Target
+  )
+{
+  return _Target == EImportTarget::PRODUCTS ? "products" : "inventories";
+}
+
+std::optional<EImportTarget> BulkImport::ParseTarget(
+    std::string_view _Name
+  )
+{
+  for (const auto Target : { EImportTarget::PRODUCTS, EImportTarget::INVENTORIES })
+    if (_Name == GetTargetName(Target))
+      return Target;
+  return std::nullopt;
+}
+
+template<typename TBatch>
+void BulkImport::Import(
+    oci::Connection * _Conn,
+    CsvReader & _Reader,
+    const ImportOptions & _Options,
+    const ImportKeys & _Keys
+  )
+{
+  const auto BatchSize = static_cast<std::size_t>(std::clamp(_Options.BatchSize, 1, MAX_BATCH_SIZE));
+  const auto CommitInterval = static_cast<std::uint64_t>(std::max(_Options.CommitInterval, 1));
+
+  DBStatement Stmt(_Conn, TBatch::SQL);
+  TBatch Batch(BatchSize);
+  std::vector<std::string_view> Fields;
+
+  std::uint64_t Read = 0;
+  std::uint64_t Inserted = 0;
+  std::uint64_t Committed = 0;
+
+  const auto Flush = [&]()
+  {
+    if (Batch.GetSize() == 0)
+      return;
+
+    Batch.Bind(Stmt);
+    Stmt.ExecuteArrayUpdate(static_cast<unsigned int>(Batch.GetSize()));
+    Inserted += Batch.GetSize();
+    Batch.Clear();
+
+    if (Inserted - Committed >= CommitInterval)
+    {
+      Stmt.Commit();
+      Committed = Inserted;
+    }
+  };
+
+  if (_Options.HasHeader)
+    _Reader.Next(Fields);
+
+  try
+  {
+    while (!m_IsCancelled && _Reader.Next(Fields))
+    {
+      ++Read;
+      if (const char * Reason = Batch.Add(Fields, _Keys))
+        Reject(_Reader.GetLine(), Reason);
+
+      if (Batch.GetSize() == BatchSize)
+      {
+        Flush();
+        Report(_Reader, Read, Inserted, Committed);
+      }
+      else if (Read % REPORT_INTERVAL == 0)
+      {
+        Report(_Reader, Read, Inserted, Committed);
+      }
+    }
+
+    if (m_IsCancelled)
+    {
+      Stmt.Rollback();
+      Inserted = Committed;
+    }
+    else
+    {
+      Flush();
+      Stmt.Commit();
+      Committed = Inserted;
+    }
+  }
+  catch (const oci::SQLException &)
+  {
+    Stmt.Rollback();
+    Report(_Reader, Read, Committed, Committed);
+    throw;
+  }
+
+  Report(_Reader, Read, Inserted, Committed);
+}
+
+void BulkImport::Begin()
+{
+  std::scoped_lock Lock(m_Mutex);
+
+  m_Progress = ImportProgress();
+  m_Progress.IsRunning = true;
+  m_StartTime = Clock::now();
+}
+
+void BulkImport::Reject(
+    std::uint64_t _Line,
+    const char * _Reason
+  )
+{
+  std::scoped_lock Lock(m_Mutex);
+
+  ++m_Progress.RowsRejected;
+  if (m_Progress.Rejections.size() < REJECTION_LOG_CAPACITY)
+    m_Progress.Rejections.push_back("line " + std::to_string(_Line) + ": " + _Reason);
+}
+
+void BulkImport::Report(
+    const CsvReader & _Reader,
+    std::uint64_t _Read,
+    std::uint64_t _Inserted,
+    std::uint64_t _Committed
+  )
+{
+  std::scoped_lock Lock(m_Mutex);
+
+  m_Progress.RowsRead = _Read;
+  m_Progress.RowsInserted = _Inserted;
+  m_Progress.RowsCommitted = _Committed;
+  m_Progress.BytesRead = _Reader.GetBytesRead();
+}
+
+void BulkImport::Finish(
+    std::string _Error
+  )
+{
+  {
+    std::scoped_lock Lock(m_Mutex);
+
+    m_Progress.ElapsedSeconds = std::chrono::duration<double>(Clock::now() - m_StartTime).count();
+    m_Progress.IsRunning = false;
+    m_Progress.IsDone = true;
+    m_Progress.Error = std::move(_Error);
+  }
+
+  // The window polls while running, this only saves the wait for its next poll
+  Walnut::Application::PostWakeEvent();
+}
+
+std::optional<ImportOptions> ParseImportArguments(
+    int _Argc,
+    char ** _Argv,
+    std::string & _Error
+  )
+{
+  ImportOptions Options;
+  bool IsImport = false;
+
+  for (int i = 1; i < _Argc; ++i)
+  {
+    const std::string_view Arg = _Argv[i];
+    if (Arg == "--import")
+    {
+      IsImport = true;
+      if (i + 2 >= _Argc)
+      {
+        _Error = "--import expects a table and a file";
+        break;
+      }
+
+      const auto Target = BulkImport::ParseTarget(_Argv[++i]);
+      if (!Target)
+        _Error = std::string("Unknown import table ") + _Argv[i] + ", expected products or inventories";
+      else
+        Options.Target = *Target;
+      Options.Path = _Argv[++i];
+    }
+    else if (Arg == "--batch" || Arg == "--commit")
+    {
+      int & Value = (Arg == "--batch") ? Options.BatchSize : Options.CommitInterval;
+      if (i + 1 >= _Argc || !ParseCount(_Argv[++i], Value))
+        _Error = std::string(Arg) + " expects a positive number of rows";
+    }
+    else if (Arg == "--no-header")
+    {
+      Options.HasHeader = false;
+    }
+  }
+
+  // Other arguments are not ours to judge when there is nothing to import
+  if (!IsImport)
+  {
+    _Error.clear();
+    return std::nullopt;
+  }
+
+  if (!_Error.empty())
+    return std::nullopt;
+
+  return Options;
+}
\ No newline at end of file
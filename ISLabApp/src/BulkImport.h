@@ -0,0 +1,176 @@
+#pragma once
+
+#include "ISLabApp.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+class CsvReader;
+
+enum class EImportTarget
+{
+  PRODUCTS,
+  INVENTORIES
+};
+
+// Columns of the file:
+//   products    - product_name, description, cost, price, category_id
+//   inventories - product_id, warehouse_id, quantity, the quantity of an existing row is replaced
+struct ImportOptions
+{
+  EImportTarget Target = EImportTarget::PRODUCTS;
+  std::string Path;
+  bool HasHeader = true;
+
+  // Rows sent in one array insert
+  int BatchSize = 1000;
+
+  // Rows between commits, rounded up to whole batches
+  int CommitInterval = 50000;
+};
+
+// Keys the imported rows may reference
+struct ImportKeys
+{
+  std::unordered_set<int> Categories;
+  std::unordered_set<int> Products;
+  std::unordered_set<int> Warehouses;
+};
+
+struct ImportProgress
+{
+  std::uint64_t RowsRead = 0;
+  std::uint64_t RowsInserted = 0;
+  std::uint64_t RowsCommitted = 0;
+  std::uint64_t RowsRejected = 0;
+  std::uint64_t BytesRead = 0;
+  std::uint64_t FileSize = 0;
+  double ElapsedSeconds = 0.0;
+  bool IsRunning = false;
+  bool IsDone = false;
+
+  std::string Error;
+
+  // "line N: reason" of the first rejected rows
+  std::vector<std::string> Rejections;
+
+  double GetRowsPerSecond() const;
+};
+
+// Streams a CSV file into products or inventories with array inserts.
+// Rows referencing keys missing from ImportKeys are rejected and reported instead of failing the batch.
+// A database error stops the import, rows committed before it stay.
+class BulkImport
+{
+public:
+
+  static constexpr int MAX_BATCH_SIZE = 10000;
+  static constexpr std::size_t REJECTION_LOG_CAPACITY = 100;
+
+  BulkImport(
+      oci::Environment * _Env,
+      std::string _UserName,
+      std::string _Password,
+      std::string _ConnectString
+    );
+
+  // Cancels the running import and waits for it
+  ~BulkImport();
+
+  BulkImport(const BulkImport &) = delete;
+  BulkImport & operator=(const BulkImport &) = delete;
+
+  // Imports on a worker thread with its own session, the environment must be created with THREADED_MUTEXED
+  void Start(
+      ImportOptions _Options,
+      ImportKeys _Keys
+    );
+
+  // Imports on the calling thread
+  void Run(
+      oci::Connection * _Conn,
+      const ImportOptions & _Options,
+      const ImportKeys & _Keys
+    );
+
+  // Stops after the current batch, rows since the last commit are rolled back
+  void Cancel();
+
+  bool IsRunning() const;
+
+  ImportProgress GetProgress() const;
+
+  // Keys present on the server, for imports without the tables at hand
+  static ImportKeys FetchKeys(
+      oci::Connection * _Conn,
+      EImportTarget _Target
+    );
+
+  static const char * GetTargetName(
+      EImportTarget _Target
+    );
+
+  static std::optional<EImportTarget> ParseTarget(
+      std::string_view _Name
+    );
+
+private:
+
+  template<typename TBatch>
+  void Import(
+      oci::Connection * _Conn,
+      CsvReader & _Reader,
+      const ImportOptions & _Options,
+      const ImportKeys & _Keys
+    );
+
+  // Resets the progress of a new import
+  void Begin();
+
+  void Reject(
+      std::uint64_t _Line,
+      const char * _Reason
+    );
+
+  void Report(
+      const CsvReader & _Reader,
+      std::uint64_t _Read,
+      std::uint64_t _Inserted,
+      std::uint64_t _Committed
+    );
+
+  void Finish(
+      std::string _Error
+    );
+
+  using Clock = std::chrono::steady_clock;
+
+  oci::Environment * m_Env = nullptr;
+  std::string m_UserName;
+  std::string m_Password;
+  std::string m_ConnectString;
+
+  std::future<void> m_Done;
+  std::atomic<bool> m_IsCancelled{ false };
+
+  mutable std::mutex m_Mutex;
+  ImportProgress m_Progress;
+  Clock::time_point m_StartTime;
+};
+
+// Options of a command line import:
+//   --import products|inventories <file.csv> [--batch <rows>] [--commit <rows>] [--no-header]
+// Returns nullopt without --import, or with _Error set if the arguments are malformed.
+std::optional<ImportOptions> ParseImportArguments(
+    int _Argc,
+    char ** _Argv,
+    std::string & _Error
+  );
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "CountriesTableWindow.h"
 
+#include "TableOps.h"
+
 #include <imgui.h>
 #include <algorithm>
 #include <map>
@@ -11,31 +13,35 @@ CountriesTableWindow::CountriesTableWindow(
     m_Env{ _Env },
     m_Conn{ _Conn }
 {
-  m_CreateStmt = m_Conn->createStatement("INSERT INTO countries VALUES(:1,:2)");
-  m_DeleteStmt = m_Conn->createStatement("DELETE FROM countries WHERE country_id = :1");
-  m_UpdateStmt = m_Conn->createStatement("SELECT * FROM countries");
-}
-
-CountriesTableWindow::~CountriesTableWindow()
-{
-  m_Conn->terminateStatement(m_CreateStmt);
-  m_Conn->terminateStatement(m_DeleteStmt);
-  m_Conn->terminateStatement(m_UpdateStmt);
+  m_CreateStmt = DBStatement(m_Conn, "INSERT INTO countries VALUES(:1,:2)");
+  m_DeleteStmt = DBStatement(m_Conn, "DELETE FROM countries WHERE country_id = :1");
+  m_UpdateStmt = DBStatement(m_Conn, UPDATE_QUERY);
 }
 
 void CountriesTableWindow::OnUIRender()
 {
-  ImGui::Begin("Countries");
+  WL_TRACE_SCOPE_CAT("render", __FUNCTION__);
+
+  const bool IsVisible = ImGui::Begin("Countries");
 
   if (ImGui::IsWindowAppearing())
     m_NeedUpdate = true;
 
+  // Collapsed or in a hidden tab, a refresh waits until it is shown
+  if (!IsVisible)
+  {
+    ImGui::End();
+    return;
+  }
+
   if (m_NeedUpdate)
   {
-    UpdateTable();
+    RefreshTable();
     m_NeedUpdate = false;
   }
 
+  m_Refresh.MarkVisible();
+
   if (ImGui::Button("Create"))
     OpenCreateWindow();
   RenderCreateWindow();
@@ -68,7 +74,6 @@ void CountriesTableWindow::RenderCreateWindow()
     if (ButtonCentered("OK"))
     {
       CreateCountry(m_CountryIdBuffer.data(), m_CountryNameBuffer.data());
-      UpdateTable();
       CloseCreateWindow();
     }
 
@@ -98,7 +103,6 @@ void CountriesTableWindow::RenderDeleteWindow()
     if (ButtonCentered("OK"))
     {
       DeleteCountry(m_CountryIdBuffer.data());
-      UpdateTable();
       CloseDeleteWindow();
     }
 
@@ -171,18 +175,16 @@ void CountriesTableWindow::RenderTable()
 
 void CountriesTableWindow::UpdateTable()
 {
+  WL_TRACE_SCOPE_CAT("sql", __FUNCTION__);
+
+  // Superseded by this fetch
+  m_Refresh.Cancel();
+
   m_CountriesTable.clear();
 
   try
   {
-    auto * Result = m_UpdateStmt->executeQuery();
-    Result->next();
-
-    while (Result->status() == oci::ResultSet::DATA_AVAILABLE)
-    {
-      m_CountriesTable.emplace_back(Result->getString(1), Result->getString(2));
-      Result->next();
-    }
+    m_UpdateStmt.FetchInto(m_CountriesTable, &ReadRow);
   }
   catch (const oci::SQLException & ex)
   {
@@ -190,6 +192,41 @@ void CountriesTableWindow::UpdateTable()
     OpenErrorWindow();
   }
 
+  OnTableLoaded();
+}
+
+void CountriesTableWindow::RefreshTable()
+{
+  m_Refresh.Start<Table<std::string, std::string>>(
+      m_UpdateStmt,
+      &ReadRow,
+      [this](Table<std::string, std::string> _Rows)
+      {
+        SetTable(std::move(_Rows));
+      },
+      [this](const oci::SQLException & ex)
+      {
+        m_ErrorMessage = ex.what();
+        OpenErrorWindow();
+      }
+    );
+}
+
+void CountriesTableWindow::SetTable(
+    Table<std::string, std::string> _Table
+  )
+{
+  m_Refresh.Cancel();
+  m_CountriesTable = std::move(_Table);
+  OnTableLoaded();
+  m_NeedUpdate = false;
+  TableChangedSignal.Emit();
+}
+
+void CountriesTableWindow::OnTableLoaded()
+{
+  std::sort(m_CountriesTable.begin(), m_CountriesTable.end(), m_SortPredicate);
+
   if (!m_CountriesTable.empty())
   {
     Copy(std::get<0>(m_CountriesTable.front()), m_CountryIdBuffer);
@@ -197,15 +234,22 @@ void CountriesTableWindow::UpdateTable()
   }
 }
 
+std::tuple<std::string, std::string> CountriesTableWindow::ReadRow(
+    oci::ResultSet * _Result
+  )
+{
+  return std::make_tuple(_Result->getString(1), _Result->getString(2));
+}
+
 void CountriesTableWindow::SortTable(
     int _ColIdx,
     ImGuiSortDirection _SortDir
   )
 {
-  std::sort(
-      m_CountriesTable.begin(), m_CountriesTable.end(),
-      PredicateImpl<std::string, std::string>{ _ColIdx, _SortDir }
-    );
+  WL_TRACE_SCOPE_CAT("sort", __FUNCTION__);
+
+  m_SortPredicate = { _ColIdx, _SortDir };
+  std::sort(m_CountriesTable.begin(), m_CountriesTable.end(), m_SortPredicate);
 }
 
 void CountriesTableWindow::CreateCountry(
@@ -217,8 +261,9 @@ void CountriesTableWindow::CreateCountry(
   {
     m_CreateStmt->setString(1, _ID);
     m_CreateStmt->setString(2, _Name);
-    m_CreateStmt->executeUpdate();
-    m_Conn->commit();
+    m_CreateStmt.ExecuteUpdate();
+    m_CreateStmt.Commit();
+    InsertSorted(m_CountriesTable, std::make_tuple(std::string(_ID), std::string(_Name)), m_SortPredicate);
     TableChangedSignal.Emit();
   }
   catch (const oci::SQLException & ex)
@@ -235,8 +280,12 @@ void CountriesTableWindow::DeleteCountry(
   try
   {
     m_DeleteStmt->setString(1, _ID);
-    m_DeleteStmt->executeUpdate();
-    m_Conn->commit();
+    m_DeleteStmt.ExecuteUpdate();
+    m_DeleteStmt.Commit();
+    EraseByKey<0>(m_CountriesTable, std::string(_ID));
+    if (!m_CountriesTable.empty())
+      Copy(std::get<0>(m_CountriesTable.front()), m_CountryIdBuffer);
+    RowsDeletedSignal.Emit();
     TableChangedSignal.Emit();
   }
   catch (const oci::SQLException & ex)
@@ -2,6 +2,8 @@
 
 #include "ISLabApp.h"
 #include "IWindow.h"
+#include "DBStatement.h"
+#include "IncrementalFetch.h"
 
 #include <imgui.h>
 #include <vector>
@@ -19,8 +21,6 @@ public:
       oci::Connection * _Conn
     );
 
-  ~CountriesTableWindow();
-
   void OnUIRender() override;
 
   void OpenCreateWindow();
@@ -38,6 +38,17 @@ public:
   void RenderTable();
   void UpdateTable();
 
+  void SetTable(
+      Table<std::string, std::string> _Table
+    );
+
+  static constexpr const char * TABLE_NAME = "countries";
+  static constexpr const char * UPDATE_QUERY = "SELECT country_id, country_name FROM countries";
+
+  static std::tuple<std::string, std::string> ReadRow(
+      oci::ResultSet * _Result
+    );
+
   void SortTable(
       int _ColIdx,
       ImGuiSortDirection _SortDir
@@ -57,15 +68,22 @@ public:
 public:
 
   sig::CSignal<> TableChangedSignal;
+  sig::CSignal<> RowsDeletedSignal;
 
 private:
 
+  void OnTableLoaded();
+  // Fetches the table a slice per frame and hands it to SetTable
+  void RefreshTable();
+
   oci::Environment * m_Env = nullptr;
   oci::Connection * m_Conn = nullptr;
 
-  oci::Statement * m_CreateStmt = nullptr;
-  oci::Statement * m_DeleteStmt = nullptr;
-  oci::Statement * m_UpdateStmt = nullptr;
+  DBStatement m_CreateStmt;
+  DBStatement m_DeleteStmt;
+  DBStatement m_UpdateStmt;
+  // Reads m_UpdateStmt, declared after it so it is closed first
+  IncrementalFetch m_Refresh;
 
   std::vector<char> m_CountryIdBuffer = std::vector<char>(2 + 1, '\0');
   std::vector<char> m_CountryNameBuffer = std::vector<char>(40 + 1, '\0');
@@ -78,4 +96,5 @@ private:
   std::string m_ErrorMessage;
 
   Table<std::string, std::string> m_CountriesTable;
+  PredicateImpl<std::string, std::string> m_SortPredicate{ 0, ImGuiSortDirection_Ascending };
 };
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include "CsvReader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+namespace
+{
+
+constexpr std::string_view UTF8_BOM = "\xEF\xBB\xBF";
+
+// Splits the record in place, quoted fields are unescaped over their own characters
+void SplitRecord(
+    char * _Begin,
+    char * _End,
+    std::vector<std::string_view> & _Fields
+  )
+{
+  char * Pos = _Begin;
+  while (true)
+  {
+    if (Pos < _End && *Pos == '"')
+    {
+      char * const FieldBegin = ++Pos;
+      char * Out = Pos;
+      while (Pos < _End)
+      {
+        if (*Pos != '"')
+          *Out++ = *Pos++;
+        else if (Pos + 1 < _End && Pos[1] == '"')
+        {
+          *Out++ = '"';
+          Pos += 2;
+        }
+        else
+        {
+          ++Pos;
+          break;
+        }
+      }
+      _Fields.emplace_back(FieldBegin, static_cast<std::size_t>(Out - FieldBegin));
+
+      // Anything between the closing quote and the separator is dropped
+      Pos = std::find(Pos, _End, ',');
+    }
+    else
+    {
+      char * const FieldBegin = Pos;
+      Pos = std::find(Pos, _End, ',');
+      _Fields.emplace_back(FieldBegin, static_cast<std::size_t>(Pos - FieldBegin));
+    }
+
+    if (Pos == _End)
+      break;
+    ++Pos;
+  }
+}
+
+} // namespace
+
+CsvReader::CsvReader(
+    const std::string & _Path,
+    std::size_t _BufferSize
+  ) :
+    m_File(_Path, std::ios::binary),
+    m_Buffer(std::max<std::size_t>(_BufferSize, 64))
+{
+  std::error_code Error;
+  const auto Size = std::filesystem::file_size(_Path, Error);
+  m_FileSize = Error ? 0 : static_cast<std::uint64_t>(Size);
+
+  if (Fill() && std::string_view(m_Buffer.data(), m_End).substr(0, UTF8_BOM.size()) == UTF8_BOM)
+  {
+    m_Begin = UTF8_BOM.size();
+    m_BytesRead = UTF8_BOM.size();
+  }
+}
+
+bool CsvReader::IsOpen() const
+{
+  return m_File.is_open();
+}
+
+bool CsvReader::Next(
+    std::vector<std::string_view> & _Fields
+  )
+{
+  _Fields.clear();
+
+  while (true)
+  {
+    const char * RecordEnd = FindRecordEnd();
+    if (!RecordEnd)
+    {
+      if (m_End - m_Begin == m_Buffer.size())
+      {
+        m_IsRecordTooLong = true;
+        return false;
+      }
+      if (Fill())
+        continue;
+
+      // The last record of a file without a trailing line break
+      if (m_Begin == m_End)
+        return false;
+      RecordEnd = m_Buffer.data() + m_End;
+    }
+
+    char * const Begin = m_Buffer.data() + m_Begin;
+    const auto Length = static_cast<std::size_t>(RecordEnd - Begin);
+
+    m_Line = m_NextLine;
+    m_NextLine += static_cast<std::uint64_t>(std::count(Begin, Begin + Length, '\n'));
+    m_BytesRead += Length;
+    m_Begin += Length;
+
+    char * End = Begin + Length;
+    while (End > Begin && (End[-1] == '\n' || End[-1] == '\r'))
+      --End;
+
+    if (End == Begin)
+      continue;
+
+    SplitRecord(Begin, End, _Fields);
+    return true;
+  }
+}
+
+bool CsvReader::IsRecordTooLong() const
+{
+  return m_IsRecordTooLong;
+}
+
+std::uint64_t CsvReader::GetLine() const
+{
+  return m_Line;
+}
+
+std::uint64_t CsvReader::GetBytesRead() const
+{
+  return m_BytesRead;
+}
+
+std::uint64_t CsvReader::GetFileSize() const
+{
+  return m_FileSize;
+}
+
+const char * CsvReader::FindRecordEnd() const
+{
+  // A line break inside quotes belongs to the field, doubled quotes toggle twice and cancel out
+  bool IsQuoted = false;
+  for (std::size_t i = m_Begin; i < m_End; ++i)
+  {
+    if (m_Buffer[i] == '"')
+      IsQuoted = !IsQuoted;
+    else if (m_Buffer[i] == '\n' && !IsQuoted)
+      return m_Buffer.data() + i + 1;
+  }
+  return nullptr;
+}
+
+bool CsvReader::Fill()
+{
+  if (m_IsEof || !m_File)
+    return false;
+
+  std::memmove(m_Buffer.data(), m_Buffer.data() + m_Begin, m_End - m_Begin);
+  m_End -= m_Begin;
+  m_Begin = 0;
+
+  m_File.read(m_Buffer.data() + m_End, static_cast<std::streamsize>(m_Buffer.size() - m_End));
+  const auto Count = static_cast<std::size_t>(m_File.gcount());
+  m_End += Count;
+
+  if (Count == 0)
+    m_IsEof = true;
+  return Count != 0;
+}
\ No newline at end of file
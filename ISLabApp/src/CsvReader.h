@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Reads the records of a CSV file through a fixed size buffer, so memory does not grow with the file.
+// Fields are separated by commas and may be quoted, a doubled quote inside quotes stands for one quote.
+// Blank lines are skipped.
+class CsvReader
+{
+public:
+
+  static constexpr std::size_t DEFAULT_BUFFER_SIZE = std::size_t{ 1 } << 20;
+
+  explicit CsvReader(
+      const std::string & _Path,
+      std::size_t _BufferSize = DEFAULT_BUFFER_SIZE
+    );
+
+  bool IsOpen() const;
+
+  // Reads the next record, the fields point into the buffer and stay valid until the next call.
+  // Returns false at the end of the file or if a record does not fit the buffer, see IsRecordTooLong.
+  bool Next(
+      std::vector<std::string_view> & _Fields
+    );
+
+  bool IsRecordTooLong() const;
+
+  // Line the last record started on, counting from 1
+  std::uint64_t GetLine() const;
+
+  std::uint64_t GetBytesRead() const;
+  std::uint64_t GetFileSize() const;
+
+private:
+
+  // End of the record starting at m_Begin, past its line break, or nullptr if the buffer holds only part of it
+  const char * FindRecordEnd() const;
+
+  // Moves the unread part to the front of the buffer and reads more after it, returns false at the end of the file
+  bool Fill();
+
+  std::ifstream m_File;
+  std::vector<char> m_Buffer;
+  std::size_t m_Begin = 0;
+  std::size_t m_End = 0;
+  bool m_IsEof = false;
+  bool m_IsRecordTooLong = false;
+
+  std::uint64_t m_Line = 0;
+  std::uint64_t m_NextLine = 1;
+  std::uint64_t m_BytesRead = 0;
+  std::uint64_t m_FileSize = 0;
+};
\ No newline at end of file
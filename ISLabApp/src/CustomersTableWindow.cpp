@@ -1,6 +1,7 @@
 #include "CustomersTableWindow.h"
 
 #include "CountriesTableWindow.h"
+#include "TableOps.h"
 
 #include <imgui.h>
 #include <algorithm>
@@ -15,21 +16,18 @@ CustomersTableWindow::CustomersTableWindow(
     m_Conn{ _Conn },
     m_Countries{ _Countries }
 {
-  m_CreateStmt = m_Conn->createStatement("INSERT INTO customers(first_name, last_name, address, email, country_id) VALUES(:1,:2,:3,:4,:5)");
-  m_DeleteStmt = m_Conn->createStatement("DELETE FROM customers WHERE customer_id = :1");
-  m_UpdateStmt = m_Conn->createStatement("SELECT * FROM customers");
+  m_CreateStmt = DBStatement(m_Conn, "INSERT INTO customers(first_name, last_name, address, email, country_id) VALUES(:1,:2,:3,:4,:5) RETURNING customer_id INTO :6");
+  m_CreateStmt->registerOutParam(6, oci::OCCIINT);
+  m_DeleteStmt = DBStatement(m_Conn, "DELETE FROM customers WHERE customer_id = :1");
+  m_UpdateStmt = DBStatement(m_Conn, UPDATE_QUERY);
 
-  m_SignalConnection.Attach(m_Countries->TableChangedSignal, this, &CustomersTableWindow::UpdateTable);
+  m_SignalConnection.Attach(m_Countries->RowsDeletedSignal, this, &CustomersTableWindow::OnParentRowsDeleted);
   m_SignalConnection.Connect();
   m_Countries->TableChangedSignal.Connect(&TableChangedSignal, &sig::CSignal<>::Emit);
 }
 
 CustomersTableWindow::~CustomersTableWindow()
 {
-  m_Conn->terminateStatement(m_CreateStmt);
-  m_Conn->terminateStatement(m_DeleteStmt);
-  m_Conn->terminateStatement(m_UpdateStmt);
-
   if (m_SignalConnection.IsConnected())
   {
     m_SignalConnection.Disconnect();
@@ -39,17 +37,28 @@ CustomersTableWindow::~CustomersTableWindow()
 
 void CustomersTableWindow::OnUIRender()
 {
-  ImGui::Begin("Customers");
+  WL_TRACE_SCOPE_CAT("render", __FUNCTION__);
+
+  const bool IsVisible = ImGui::Begin("Customers");
 
   if (ImGui::IsWindowAppearing())
     m_NeedUpdate = true;
 
+  // Collapsed or in a hidden tab, a refresh waits until it is shown
+  if (!IsVisible)
+  {
+    ImGui::End();
+    return;
+  }
+
   if (m_NeedUpdate)
   {
-    UpdateTable();
+    RefreshTable();
     m_NeedUpdate = false;
   }
 
+  m_Refresh.MarkVisible();
+
   if (ImGui::Button("Create"))
     OpenCreateWindow();
   RenderCreateWindow();
@@ -92,7 +101,6 @@ void CustomersTableWindow::RenderCreateWindow()
           m_EmailBuffer.data(),
           m_CountryIdBuffer.data()
         );
-      UpdateTable();
       CloseCreateWindow();
     }
 
@@ -117,12 +125,11 @@ void CustomersTableWindow::RenderDeleteWindow()
 {
   if (ImGui::BeginPopupModal("Delete", &m_IsDeleting, ImGuiWindowFlags_AlwaysAutoResize))
   {
-    DropDown<0>("Customer ID", m_Table, m_CustomerId);
+    DropDown<0>("Customer ID", m_Table.Get(), m_CustomerId);
 
     if (ButtonCentered("OK"))
     {
       Delete(m_CustomerId);
-      UpdateTable();
       CloseDeleteWindow();
     }
 
@@ -187,7 +194,7 @@ void CustomersTableWindow::RenderTable()
       SortSpecs->SpecsDirty = false;
     }
 
-    for (const auto & [Id, FirstName, LastName, Address, Email, CountryId] : m_Table)
+    for (const auto & [Id, FirstName, LastName, Address, Email, CountryId] : m_Table.Get())
     {
       ImGui::TableNextRow();
       ImGui::TableNextColumn();
@@ -210,25 +217,15 @@ void CustomersTableWindow::RenderTable()
 
 void CustomersTableWindow::UpdateTable()
 {
-  m_Table.clear();
+  WL_TRACE_SCOPE_CAT("sql", __FUNCTION__);
+
+  // Superseded by this fetch
+  m_Refresh.Cancel();
 
+  auto Rows = std::make_shared<Table<int, std::string, std::string, std::string, std::string, std::string>>();
   try
   {
-    auto * Result = m_UpdateStmt->executeQuery();
-    Result->next();
-
-    while (Result->status() == oci::ResultSet::DATA_AVAILABLE)
-    {
-      m_Table.emplace_back(
-          Result->getInt(1),
-          Result->getString(2),
-          Result->getString(3),
-          Result->getString(4),
-          Result->getString(5),
-          Result->getString(6)
-        );
-      Result->next();
-    }
+    m_UpdateStmt.FetchInto(*Rows, &ReadRow);
   }
   catch (const oci::SQLException & ex)
   {
@@ -236,15 +233,74 @@ void CustomersTableWindow::UpdateTable()
     OpenErrorWindow();
   }
 
-  if (!m_Table.empty())
+  m_Table.Publish(std::move(Rows));
+  OnTableLoaded();
+}
+
+void CustomersTableWindow::RefreshTable()
+{
+  m_Refresh.Start<Table<int, std::string, std::string, std::string, std::string, std::string>>(
+      m_UpdateStmt,
+      &ReadRow,
+      [this](Table<int, std::string, std::string, std::string, std::string, std::string> _Rows)
+      {
+        SetTable(std::move(_Rows));
+      },
+      [this](const oci::SQLException & ex)
+      {
+        m_ErrorMessage = ex.what();
+        OpenErrorWindow();
+      }
+    );
+}
+
+void CustomersTableWindow::SetTable(
+    Table<int, std::string, std::string, std::string, std::string, std::string> _Table
+  )
+{
+  m_Refresh.Cancel();
+  m_Table.Publish(std::make_shared<Table<int, std::string, std::string, std::string, std::string, std::string>>(std::move(_Table)));
+  OnTableLoaded();
+  m_NeedUpdate = false;
+  TableChangedSignal.Emit();
+}
+
+void CustomersTableWindow::OnTableLoaded()
+{
+  auto & Rows = m_Table.Edit();
+  std::sort(Rows.begin(), Rows.end(), m_SortPredicate);
+
+  if (!Rows.empty())
   {
-    Copy(std::get<0>(m_Table.front()), m_CustomerId);
-    Copy(std::get<1>(m_Table.front()), m_FirstNameBuffer);
-    Copy(std::get<2>(m_Table.front()), m_LastNameBuffer);
-    Copy(std::get<3>(m_Table.front()), m_AddressBuffer);
-    Copy(std::get<4>(m_Table.front()), m_EmailBuffer);
-    Copy(std::get<5>(m_Table.front()), m_CountryIdBuffer);
+    Copy(std::get<0>(Rows.front()), m_CustomerId);
+    Copy(std::get<1>(Rows.front()), m_FirstNameBuffer);
+    Copy(std::get<2>(Rows.front()), m_LastNameBuffer);
+    Copy(std::get<3>(Rows.front()), m_AddressBuffer);
+    Copy(std::get<4>(Rows.front()), m_EmailBuffer);
+    Copy(std::get<5>(Rows.front()), m_CountryIdBuffer);
   }
+
+}
+
+std::tuple<int, std::string, std::string, std::string, std::string, std::string> CustomersTableWindow::ReadRow(
+    oci::ResultSet * _Result
+  )
+{
+  return std::make_tuple(
+      _Result->getInt(1),
+      _Result->getString(2),
+      _Result->getString(3),
+      _Result->getString(4),
+      _Result->getString(5),
+      _Result->getString(6)
+    );
+}
+
+void CustomersTableWindow::OnParentRowsDeleted()
+{
+  UpdateTable();
+  RowsDeletedSignal.Emit();
+  TableChangedSignal.Emit();
 }
 
 void CustomersTableWindow::SortTable(
@@ -252,10 +308,11 @@ void CustomersTableWindow::SortTable(
     ImGuiSortDirection _SortDir
   )
 {
-  std::sort(
-      m_Table.begin(), m_Table.end(),
-      PredicateImpl<decltype(m_Table)>{ _ColIdx, _SortDir }
-    );
+  WL_TRACE_SCOPE_CAT("sort", __FUNCTION__);
+
+  m_SortPredicate = { _ColIdx, _SortDir };
+  auto & Rows = m_Table.Edit();
+  std::sort(Rows.begin(), Rows.end(), m_SortPredicate);
 }
 
 void CustomersTableWindow::Create(
@@ -273,8 +330,20 @@ void CustomersTableWindow::Create(
     m_CreateStmt->setString(3, _Address);
     m_CreateStmt->setString(4, _Email);
     m_CreateStmt->setString(5, _CountryId);
-    m_CreateStmt->executeUpdate();
-    m_Conn->commit();
+    m_CreateStmt.ExecuteUpdate();
+    m_CreateStmt.Commit();
+    InsertSorted(
+        m_Table.Edit(),
+        std::make_tuple(
+            m_CreateStmt->getInt(6),
+            std::string(_FirstName),
+            std::string(_LastName),
+            std::string(_Address),
+            std::string(_Email),
+            std::string(_CountryId)
+          ),
+        m_SortPredicate
+      );
     TableChangedSignal.Emit();
   }
   catch (const oci::SQLException & ex)
@@ -291,8 +360,13 @@ void CustomersTableWindow::Delete(
   try
   {
     m_DeleteStmt->setInt(1, _CustomerID);
-    m_DeleteStmt->executeUpdate();
-    m_Conn->commit();
+    m_DeleteStmt.ExecuteUpdate();
+    m_DeleteStmt.Commit();
+    auto & Rows = m_Table.Edit();
+    EraseByKey<0>(Rows, _CustomerID);
+    if (!Rows.empty())
+      Copy(std::get<0>(Rows.front()), m_CustomerId);
+    RowsDeletedSignal.Emit();
     TableChangedSignal.Emit();
   }
   catch (const oci::SQLException & ex)
@@ -9,9 +9,18 @@
 #include "InventoriesTableWindow.h"
 #include "MakeOrderWindow.h"
 #include "AdminWindow.h"
+#include "DBStatsWindow.h"
+#include "ImportWindow.h"
+#include "ExportWindow.h"
+#include "SnapshotCell.h"
+#include "IncrementalFetch.h"
 
 #include <imgui.h>
+#include <Walnut/Application.h>
+#include <algorithm>
+#include <iostream>
 #include <string_view>
+#include <thread>
 
 namespace
 {
@@ -20,52 +29,412 @@ constexpr std::string_view USER_NAME      = "demouser";
 constexpr std::string_view PASSWORD       = "demouser";
 constexpr std::string_view CONNECT_STRING = "gdn-nt15:1521/XEPDB1";
 
+constexpr const char * SNAPSHOT_PATH = "islab_snapshot.bin";
+
+constexpr auto IMPORT_REPORT_PERIOD = std::chrono::milliseconds(500);
+
+// Loader threads wake the UI when they finish, the wake can land just before the result is ready
+constexpr float LOADER_POLL_INTERVAL = 0.1f;
+
+// Time per frame spent decoding rows of refreshed tables, the rest of a big table waits for the next frames
+constexpr auto FETCH_FRAME_BUDGET = std::chrono::microseconds(2000);
+
+template<typename TWindow>
+bool IsTableComplete(
+    const TWindow &
+  )
+{
+  return true;
+}
+
+bool IsTableComplete(
+    const OrdersTableWindow & _Orders
+  )
+{
+  return !_Orders.IsPaged();
+}
+
 } // namespace
 
+template<typename TWindow, typename TFactory>
+void DBLayer::AddTableWindow(
+    std::string _Title,
+    TFactory && _Factory
+  )
+{
+  const auto Idx = m_Windows.size();
+  AddWindow<TWindow>(std::move(_Title), std::forward<TFactory>(_Factory));
+
+  m_Loader->Load<TWindow>(m_Snapshot.GetSection(TWindow::TABLE_NAME));
+
+  m_Windows[Idx].Handover = [this, Idx](IWindow & _Window, bool _IsParentsDone)
+  {
+    auto & Window = static_cast<TWindow &>(_Window);
+
+    if (auto Rows = m_Loader->TakeCached<TWindow>())
+    {
+      Window.SetTable(std::move(*Rows));
+      m_Windows[Idx].HasRows = true;
+    }
+
+    if (!_IsParentsDone)
+      return false;
+
+    if (auto Rows = m_Loader->Take<TWindow>())
+    {
+      Window.SetTable(std::move(*Rows));
+      m_Windows[Idx].HasRows = true;
+    }
+
+    return !m_Loader->IsLoading(typeid(TWindow));
+  };
+  m_Windows[Idx].Publish = m_Windows[Idx].Handover;
+
+  m_Windows[Idx].WriteSnapshot = [this, Idx](SnapshotWriter & _Writer)
+  {
+    auto * Window = static_cast<TWindow *>(m_Windows[Idx].Window.get());
+    const auto * Version = m_Loader->GetVersion(typeid(TWindow));
+
+    // Tables never loaded in this run keep their previous section, it is still valid for its version
+    if (!Window || !Version || !IsTableComplete(*Window))
+      _Writer.AddSection(TWindow::TABLE_NAME, m_Snapshot.GetSection(TWindow::TABLE_NAME));
+    else
+      _Writer.AddSection(TWindow::TABLE_NAME, EncodeSnapshotTable(Window->GetTable(), *Version));
+  };
+}
+
 void DBLayer::OnAttach()
 {
-  m_Env = oci::Environment::createEnvironment();
-  m_Conn = m_Env->createConnection(USER_NAME.data(), PASSWORD.data(), CONNECT_STRING.data());
+  WL_TRACE_SCOPE_CAT("startup", __FUNCTION__);
+
+  // The startup loader opens sessions from worker threads
+  m_Env = oci::Environment::createEnvironment(oci::Environment::THREADED_MUTEXED);
+  m_Loader = std::make_unique<StartupLoader>(m_Env, std::string(USER_NAME), std::string(PASSWORD), std::string(CONNECT_STRING));
+  m_Snapshot = TableSnapshot(SNAPSHOT_PATH);
+
+  // Windows are listed in dependency order, parents get their tables before the children that read them
+  AddTableWindow<CountriesTableWindow>("Countries", [this]()
+  {
+    return std::make_unique<CountriesTableWindow>(m_Env, m_Conn);
+  });
+  AddTableWindow<WarehousesTableWindow>("Warehouses", [this]()
+  {
+    return std::make_unique<WarehousesTableWindow>(m_Env, m_Conn, GetWindow<CountriesTableWindow>());
+  });
+  AddTableWindow<ProductCategoriesTableWindow>("Product categories", [this]()
+  {
+    return std::make_unique<ProductCategoriesTableWindow>(m_Env, m_Conn);
+  });
+  AddTableWindow<ProductsTableWindow>("Products", [this]()
+  {
+    return std::make_unique<ProductsTableWindow>(m_Env, m_Conn, GetWindow<ProductCategoriesTableWindow>());
+  });
+  AddTableWindow<CustomersTableWindow>("Customers", [this]()
+  {
+    return std::make_unique<CustomersTableWindow>(m_Env, m_Conn, GetWindow<CountriesTableWindow>());
+  });
+  AddTableWindow<OrdersTableWindow>("Orders", [this]()
+  {
+    return std::make_unique<OrdersTableWindow>(m_Env, m_Conn, GetWindow<CustomersTableWindow>(), GetWindow<ProductsTableWindow>());
+  });
+  AddTableWindow<InventoriesTableWindow>("Inventories", [this]()
+  {
+    return std::make_unique<InventoriesTableWindow>(m_Env, m_Conn, GetWindow<WarehousesTableWindow>(), GetWindow<ProductsTableWindow>());
+  });
+  AddWindow<MakeOrderWindow>("Make order", [this]()
+  {
+    return std::make_unique<MakeOrderWindow>(
+        m_Env, m_Conn,
+        GetWindow<ProductsTableWindow>(),
+        GetWindow<CustomersTableWindow>(),
+        GetWindow<ProductCategoriesTableWindow>(),
+        GetWindow<OrdersTableWindow>(),
+        GetWindow<InventoriesTableWindow>(),
+        GetWindow<WarehousesTableWindow>()
+      );
+  });
+  AddWindow<ExportWindow>("Export", [this]()
+  {
+    return std::make_unique<ExportWindow>(m_Env, std::string(USER_NAME), std::string(PASSWORD), std::string(CONNECT_STRING));
+  });
+  AddWindow<AdminWindow>("Admin panel", [this]()
+  {
+    return std::make_unique<AdminWindow>(
+        m_Env, m_Conn,
+        GetWindow<ProductsTableWindow>(),
+        GetWindow<CustomersTableWindow>(),
+        GetWindow<ProductCategoriesTableWindow>(),
+        GetWindow<OrdersTableWindow>(),
+        GetWindow<InventoriesTableWindow>(),
+        GetWindow<WarehousesTableWindow>(),
+        GetWindow<ExportWindow>()
+      );
+  });
+  AddWindow<ImportWindow>("Import", [this]()
+  {
+    return std::make_unique<ImportWindow>(
+        m_Env, std::string(USER_NAME), std::string(PASSWORD), std::string(CONNECT_STRING),
+        GetWindow<ProductCategoriesTableWindow>(),
+        GetWindow<ProductsTableWindow>(),
+        GetWindow<WarehousesTableWindow>(),
+        GetWindow<InventoriesTableWindow>()
+      );
+  });
 
-  auto Countries = std::make_unique<CountriesTableWindow>(m_Env, m_Conn);
-  auto Warehouses = std::make_unique<WarehousesTableWindow>(m_Env, m_Conn, Countries.get());
-  auto Categories = std::make_unique<ProductCategoriesTableWindow>(m_Env, m_Conn);
-  auto Products = std::make_unique<ProductsTableWindow>(m_Env, m_Conn, Categories.get());
-  auto Customers = std::make_unique<CustomersTableWindow>(m_Env, m_Conn, Countries.get());
-  auto Orders = std::make_unique<OrdersTableWindow>(m_Env, m_Conn, Customers.get(), Products.get());
-  auto Inventories = std::make_unique<InventoriesTableWindow>(m_Env, m_Conn, Warehouses.get(), Products.get());
-
-  auto MakeOrder = std::make_unique<MakeOrderWindow>(
-      m_Env, m_Conn,
-      Products.get(), Customers.get(), Categories.get(), Orders.get(), Inventories.get(), Warehouses.get()
-    );
-
-  auto AdminPanel = std::make_unique<AdminWindow>(
-      m_Env, m_Conn,
-      Products.get(), Customers.get(), Categories.get(), Orders.get(), Inventories.get(), Warehouses.get()
-    );
-
-  m_Windows.emplace_back(std::move(Countries));
-  m_Windows.emplace_back(std::move(Warehouses));
-  m_Windows.emplace_back(std::move(Categories));
-  m_Windows.emplace_back(std::move(Products));
-  m_Windows.emplace_back(std::move(Customers));
-  m_Windows.emplace_back(std::move(Orders));
-  m_Windows.emplace_back(std::move(Inventories));
-  m_Windows.emplace_back(std::move(MakeOrder));
-  m_Windows.emplace_back(std::move(AdminPanel));
+  // Needs no connection, built right away
+  m_Windows.push_back(WindowSlot{ "Database stats", nullptr, std::make_unique<DBStatsWindow>() });
 }
 
 void DBLayer::OnDetach()
 {
+  WriteSnapshot();
+
+  // Windows terminate their statements, so they go before the connection
+  m_Loader.reset();
   m_Windows.clear();
+  m_WindowIndex.clear();
 
-  m_Env->terminateConnection(m_Conn);
+  if (m_Conn)
+    m_Env->terminateConnection(m_Conn);
   oci::Environment::terminateEnvironment(m_Env);
 }
 
+void DBLayer::RefreshTables()
+{
+  if (IsRefreshing())
+    return;
+
+  WL_TRACE_SCOPE_CAT("app", __FUNCTION__);
+
+  // Each table is published once the tables it references are, so with all of them fetched
+  // the whole set is handed over in one frame
+  m_Loader->LoadConsistent<
+      CountriesTableWindow,
+      WarehousesTableWindow,
+      ProductCategoriesTableWindow,
+      ProductsTableWindow,
+      CustomersTableWindow,
+      OrdersTableWindow,
+      InventoriesTableWindow
+    >();
+
+  for (auto & Slot : m_Windows)
+    if (Slot.Handover)
+      Slot.Publish = Slot.Handover;
+}
+
+bool DBLayer::IsRefreshing() const
+{
+  return m_Loader->IsFetching() || std::any_of(m_Windows.begin(), m_Windows.end(), [](const WindowSlot & _Slot)
+  {
+    // A window not built yet takes its rows whenever it is
+    return _Slot.Window && _Slot.Publish;
+  });
+}
+
 void DBLayer::OnUIRender()
 {
-  for (auto & Window : m_Windows)
-    Window->OnUIRender();
+  WL_TRACE_SCOPE_CAT("render", __FUNCTION__);
+
+  // Nothing read last frame holds a bare version pointer anymore
+  ReclaimSnapshots();
+
+  // Windows that became visible last frame are built before anything is drawn,
+  // so the frame that first shows them is not held up by the database
+  for (std::size_t i = 0; i < m_Windows.size(); ++i)
+    if (m_Windows[i].IsRequested)
+      Materialize(i);
+
+  // Tables are published after the tables they reference, so a window does not see rows of a parent it does not have yet
+  for (auto & Slot : m_Windows)
+  {
+    if (!Slot.Window || !Slot.Publish)
+      continue;
+
+    const bool IsParentsLoaded = std::all_of(Slot.Dependencies.begin(), Slot.Dependencies.end(), [this](std::size_t _Dependency)
+    {
+      return IsLoaded(_Dependency);
+    });
+    const bool IsParentsDone = std::all_of(Slot.Dependencies.begin(), Slot.Dependencies.end(), [this](std::size_t _Dependency)
+    {
+      return IsDone(_Dependency);
+    });
+
+    if (IsParentsLoaded && Slot.Publish(*Slot.Window, IsParentsDone))
+      Slot.Publish = nullptr;
+  }
+
+  if (m_Loader->IsFetching())
+    Walnut::Application::Get().RequestFrame(LOADER_POLL_INTERVAL);
+
+  for (std::size_t i = 0; i < m_Windows.size(); ++i)
+  {
+    if (IsLoaded(i))
+      m_Windows[i].Window->OnUIRender();
+    else
+      RenderPlaceholder(m_Windows[i]);
+  }
+
+  // After the windows, so the ones visible this frame are known
+  if (FetchScheduler::Get().Run(FETCH_FRAME_BUDGET))
+    Walnut::Application::Get().RequestFrame();
+}
+
+std::optional<int> DBLayer::RunImportCommand(
+    int _Argc,
+    char ** _Argv
+  )
+{
+  std::string Error;
+  const auto Options = ParseImportArguments(_Argc, _Argv, Error);
+  if (!Error.empty())
+  {
+    std::cerr << Error << '\n';
+    return 2;
+  }
+  if (!Options)
+    return std::nullopt;
+
+  auto * Env = oci::Environment::createEnvironment(oci::Environment::THREADED_MUTEXED);
+  std::optional<ImportProgress> Progress;
+
+  try
+  {
+    // No tables are cached without the UI, the keys are read from the server instead
+    auto * Conn = Env->createConnection(USER_NAME.data(), PASSWORD.data(), CONNECT_STRING.data());
+    ImportKeys Keys;
+    try
+    {
+      Keys = BulkImport::FetchKeys(Conn, Options->Target);
+    }
+    catch (const oci::SQLException &)
+    {
+      Env->terminateConnection(Conn);
+      throw;
+    }
+    Env->terminateConnection(Conn);
+
+    BulkImport Import(Env, std::string(USER_NAME), std::string(PASSWORD), std::string(CONNECT_STRING));
+    Import.Start(*Options, std::move(Keys));
+    while (Import.IsRunning())
+    {
+      std::this_thread::sleep_for(IMPORT_REPORT_PERIOD);
+      const auto Current = Import.GetProgress();
+      std::cerr << '\r' << Current.RowsRead << " rows read, " << Current.RowsInserted << " inserted, "
+                << Current.RowsRejected << " rejected, " << static_cast<std::uint64_t>(Current.GetRowsPerSecond()) << " rows/s" << std::flush;
+    }
+    Progress = Import.GetProgress();
+  }
+  catch (const oci::SQLException & ex)
+  {
+    std::cerr << ex.what() << '\n';
+  }
+
+  oci::Environment::terminateEnvironment(Env);
+
+  if (!Progress)
+    return 1;
+
+  std::cerr << '\n';
+  for (const auto & Rejection : Progress->Rejections)
+    std::cerr << Rejection << '\n';
+
+  std::cout << BulkImport::GetTargetName(Options->Target) << ": " << Progress->RowsCommitted << " of "
+            << Progress->RowsRead << " rows imported, " << Progress->RowsRejected << " rejected in "
+            << Progress->ElapsedSeconds << " s (" << static_cast<std::uint64_t>(Progress->GetRowsPerSecond()) << " rows/s)\n";
+
+  if (!Progress->Error.empty())
+  {
+    std::cerr << Progress->Error << '\n';
+    return 1;
+  }
+  return 0;
+}
+
+IWindow * DBLayer::Materialize(
+    std::size_t _Idx
+  )
+{
+  auto & Slot = m_Windows[_Idx];
+
+  if (!m_BuildStack.empty())
+    m_Windows[m_BuildStack.back()].Dependencies.push_back(_Idx);
+
+  if (!Slot.Window)
+  {
+    WL_TRACE_SCOPE_CAT("startup", __FUNCTION__);
+
+    Connect();
+
+    m_BuildStack.push_back(_Idx);
+    Slot.Window = Slot.Factory();
+    m_BuildStack.pop_back();
+  }
+
+  Slot.IsRequested = false;
+  return Slot.Window.get();
+}
+
+bool DBLayer::IsLoaded(
+    std::size_t _Idx
+  ) const
+{
+  const auto & Slot = m_Windows[_Idx];
+  if (!Slot.Window || (Slot.Publish && !Slot.HasRows))
+    return false;
+
+  return std::all_of(Slot.Dependencies.begin(), Slot.Dependencies.end(), [this](std::size_t _Dependency)
+  {
+    return IsLoaded(_Dependency);
+  });
+}
+
+bool DBLayer::IsDone(
+    std::size_t _Idx
+  ) const
+{
+  const auto & Slot = m_Windows[_Idx];
+  if (!Slot.Window || Slot.Publish)
+    return false;
+
+  return std::all_of(Slot.Dependencies.begin(), Slot.Dependencies.end(), [this](std::size_t _Dependency)
+  {
+    return IsDone(_Dependency);
+  });
+}
+
+void DBLayer::WriteSnapshot()
+{
+  WL_TRACE_SCOPE_CAT("app", __FUNCTION__);
+
+  SnapshotWriter Writer;
+  for (auto & Slot : m_Windows)
+    if (Slot.WriteSnapshot)
+      Slot.WriteSnapshot(Writer);
+
+  // The old file is still mapped and is about to be replaced
+  m_Snapshot.Close();
+  Writer.Write(SNAPSHOT_PATH);
+}
+
+void DBLayer::Connect()
+{
+  if (m_Conn)
+    return;
+
+  WL_TRACE_SCOPE_CAT("startup", __FUNCTION__);
+  m_Conn = m_Env->createConnection(USER_NAME.data(), PASSWORD.data(), CONNECT_STRING.data());
+}
+
+void DBLayer::RenderPlaceholder(
+    WindowSlot & _Slot
+  )
+{
+  // Same title as the real window, so it keeps its place in the saved layout
+  if (ImGui::Begin(_Slot.Title.c_str()))
+  {
+    _Slot.IsRequested = true;
+    ImGui::TextDisabled("Loading...");
+  }
+  ImGui::End();
 }
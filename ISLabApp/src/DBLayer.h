@@ -2,9 +2,15 @@
 
 #include "ISLabApp.h"
 #include "IWindow.h"
+#include "StartupLoader.h"
+#include "TableSnapshot.h"
 
 #include <Walnut/Layer.h>
+#include <functional>
+#include <optional>
 #include <string>
+#include <typeindex>
+#include <unordered_map>
 #include <vector>
 #include <memory>
 
@@ -17,11 +23,99 @@ public:
   virtual void OnDetach() override;
   virtual void OnUIRender() override;
 
+  // Builds the window, and the windows it depends on, the first time it is needed
+  template<typename TWindow>
+  TWindow * GetWindow();
+
+  // Reloads every table at one SCN in the background, the windows get the new rows in the same frame.
+  // Ignored while tables are still being handed over.
+  void RefreshTables();
+
+  bool IsRefreshing() const;
+
+  // Runs the import given on the command line without opening the UI, see ParseImportArguments.
+  // Returns the exit code, or nullopt if there is nothing to import.
+  static std::optional<int> RunImportCommand(
+      int _Argc,
+      char ** _Argv
+    );
+
 private:
 
+  struct WindowSlot
+  {
+    std::string Title;
+    std::function<std::unique_ptr<IWindow>()> Factory;
+    std::unique_ptr<IWindow> Window;
+    bool IsRequested = false;
+
+    // Hands over the rows of the startup loader, returns true once there is nothing left to wait for.
+    // Fresh rows are only handed over once the parents are done, snapshot rows as soon as the parents have any.
+    std::function<bool(IWindow &, bool _IsParentsDone)> Publish;
+    // Publish of a table window, armed again by RefreshTables
+    std::function<bool(IWindow &, bool _IsParentsDone)> Handover;
+    std::function<void(SnapshotWriter &)> WriteSnapshot;
+    std::vector<std::size_t> Dependencies;
+    bool HasRows = false;
+  };
+
+  template<typename TWindow, typename TFactory>
+  void AddWindow(
+      std::string _Title,
+      TFactory && _Factory
+    );
+
+  template<typename TWindow, typename TFactory>
+  void AddTableWindow(
+      std::string _Title,
+      TFactory && _Factory
+    );
+
+  IWindow * Materialize(
+      std::size_t _Idx
+    );
+
+  // Built, holding its table and so are the windows it depends on
+  bool IsLoaded(
+      std::size_t _Idx
+    ) const;
+
+  // Built, holding the table revalidated against the server and so are the windows it depends on
+  bool IsDone(
+      std::size_t _Idx
+    ) const;
+
+  void WriteSnapshot();
+
+  void Connect();
+
+  void RenderPlaceholder(
+      WindowSlot & _Slot
+    );
+
   oci::Environment * m_Env = nullptr;
   oci::Connection * m_Conn = nullptr;
 
-  std::vector<std::unique_ptr<IWindow>> m_Windows;
+  std::unique_ptr<StartupLoader> m_Loader;
+  TableSnapshot m_Snapshot;
+
+  std::vector<WindowSlot> m_Windows;
+  std::unordered_map<std::type_index, std::size_t> m_WindowIndex;
+  std::vector<std::size_t> m_BuildStack;
 };
 
+template<typename TWindow>
+TWindow * DBLayer::GetWindow()
+{
+  return static_cast<TWindow *>(Materialize(m_WindowIndex.at(typeid(TWindow))));
+}
+
+template<typename TWindow, typename TFactory>
+void DBLayer::AddWindow(
+    std::string _Title,
+    TFactory && _Factory
+  )
+{
+  m_WindowIndex.emplace(typeid(TWindow), m_Windows.size());
+  m_Windows.push_back(WindowSlot{ std::move(_Title), std::forward<TFactory>(_Factory) });
+}
@@ -0,0 +1,221 @@
+#include "DBStatement.h"
+
+#include <utility>
+
+namespace
+{
+
+// Per thread, the UI session is only used from the UI thread
+thread_local std::uint64_t WriteCount = 0;
+
+} // namespace
+
+DBResultSet::DBResultSet(
+    oci::Statement * _Stmt,
+    oci::ResultSet * _Result
+  ) :
+    m_Stmt{ _Stmt },
+    m_Result{ _Result }
+{
+  if (m_Result)
+    DBStats::Get().GetResultSetHandles().Acquire();
+}
+
+DBResultSet::DBResultSet(
+    DBResultSet && _Other
+  ) noexcept :
+    m_Stmt{ std::exchange(_Other.m_Stmt, nullptr) },
+    m_Result{ std::exchange(_Other.m_Result, nullptr) }
+{
+}
+
+DBResultSet & DBResultSet::operator=(
+    DBResultSet && _Other
+  ) noexcept
+{
+  if (this != &_Other)
+  {
+    Close();
+    m_Stmt = std::exchange(_Other.m_Stmt, nullptr);
+    m_Result = std::exchange(_Other.m_Result, nullptr);
+  }
+  return *this;
+}
+
+DBResultSet::~DBResultSet()
+{
+  Close();
+}
+
+bool DBResultSet::Next()
+{
+  return m_Result->next() == oci::ResultSet::DATA_AVAILABLE;
+}
+
+void DBResultSet::Close()
+{
+  if (!m_Result)
+    return;
+
+  try
+  {
+    m_Stmt->closeResultSet(m_Result);
+  }
+  catch (const oci::SQLException &)
+  {
+    // The cursor is released together with the session anyway
+  }
+
+  DBStats::Get().GetResultSetHandles().Release();
+  m_Result = nullptr;
+}
+
+DBStatement::DBStatement(
+    oci::Connection * _Conn,
+    const std::string & _Sql
+  ) :
+    m_Conn{ _Conn },
+    m_Stmt{ _Conn->createStatement(_Sql) },
+    m_Stats{ DBStats::Get().Register(_Sql) }
+{
+  DBStats::Get().GetStatementHandles().Acquire();
+}
+
+DBStatement::DBStatement(
+    DBStatement && _Other
+  ) noexcept :
+    m_Conn{ std::exchange(_Other.m_Conn, nullptr) },
+    m_Stmt{ std::exchange(_Other.m_Stmt, nullptr) },
+    m_Stats{ std::exchange(_Other.m_Stats, nullptr) }
+{
+}
+
+DBStatement & DBStatement::operator=(
+    DBStatement && _Other
+  ) noexcept
+{
+  if (this != &_Other)
+  {
+    Terminate();
+    m_Conn = std::exchange(_Other.m_Conn, nullptr);
+    m_Stmt = std::exchange(_Other.m_Stmt, nullptr);
+    m_Stats = std::exchange(_Other.m_Stats, nullptr);
+  }
+  return *this;
+}
+
+DBStatement::~DBStatement()
+{
+  Terminate();
+}
+
+unsigned int DBStatement::ExecuteUpdate()
+{
+  ++WriteCount;
+  return ExecuteDml([this]() { return m_Stmt->executeUpdate(); });
+}
+
+unsigned int DBStatement::ExecuteArrayUpdate(
+    unsigned int _Iterations
+  )
+{
+  ++WriteCount;
+  return ExecuteDml([this, _Iterations]()
+  {
+    m_Stmt->executeArrayUpdate(_Iterations);
+    return m_Stmt->getUpdateCount();
+  });
+}
+
+void DBStatement::Commit()
+{
+  WL_TRACE_SCOPE_CAT("sql", "SQL commit");
+  const auto Start = Clock::now();
+
+  m_Conn->commit();
+
+  const auto Duration = Clock::now() - Start;
+  m_Stats->Commit.Record(Duration);
+  DBStats::Get().ReportLatency(*m_Stats, "commit", Duration, 0);
+}
+
+void DBStatement::Rollback()
+{
+  WL_TRACE_SCOPE_CAT("sql", "SQL rollback");
+
+  // Called from error handlers, a failed rollback leaves nothing more to undo
+  try
+  {
+    m_Conn->rollback();
+  }
+  catch (const oci::SQLException &)
+  {
+  }
+}
+
+void DBStatement::Terminate()
+{
+  if (!m_Stmt)
+    return;
+
+  try
+  {
+    m_Conn->terminateStatement(m_Stmt);
+  }
+  catch (const oci::SQLException &)
+  {
+    // The cursor is released together with the session anyway
+  }
+
+  DBStats::Get().GetStatementHandles().Release();
+  m_Stmt = nullptr;
+}
+
+DBResultSet DBStatement::ExecuteQuery()
+{
+  WL_TRACE_SCOPE_CAT("sql", "SQL execute");
+  const auto Start = Clock::now();
+
+  ++m_Stats->Executions;
+
+  try
+  {
+    DBResultSet Result(m_Stmt, m_Stmt->executeQuery());
+    const auto Duration = Clock::now() - Start;
+
+    m_Stats->Execute.Record(Duration);
+    DBStats::Get().ReportLatency(*m_Stats, "execute", Duration, 0);
+
+    return Result;
+  }
+  catch (const oci::SQLException &)
+  {
+    ++m_Stats->Errors;
+    throw;
+  }
+}
+
+DBResultSet DBStatement::GetCursor(
+    unsigned int _Index
+  )
+{
+  return DBResultSet(m_Stmt, m_Stmt->getCursor(_Index));
+}
+
+std::uint64_t DBStatement::GetWriteCount()
+{
+  return WriteCount;
+}
+
+void DBStatement::RecordFetch(
+    Clock::time_point _Start,
+    std::uint64_t _Rows,
+    std::uint64_t _Bytes
+  )
+{
+  const auto Duration = Clock::now() - _Start;
+  m_Stats->Rows += _Rows;
+  m_Stats->Bytes += _Bytes;
+  m_Stats->Fetch.Record(Duration);
+  DBStats::Get().ReportLatency(*m_Stats, "fetch", Duration, _Rows);
+}
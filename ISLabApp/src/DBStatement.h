@@ -0,0 +1,288 @@
+#pragma once
+
+#include "ISLabApp.h"
+#include "DBStats.h"
+
+#include <chrono>
+#include <string>
+#include <tuple>
+#include <utility>
+
+inline std::size_t ValueBytes(int) { return sizeof(int); }
+inline std::size_t ValueBytes(float) { return sizeof(float); }
+inline std::size_t ValueBytes(double) { return sizeof(double); }
+inline std::size_t ValueBytes(EOrderStatus) { return sizeof(EOrderStatus); }
+inline std::size_t ValueBytes(const oci::Date &) { return 7; } // size of Oracle DATE on the wire
+inline std::size_t ValueBytes(const std::string & _Value) { return _Value.size(); }
+
+template<typename ... TArgs>
+std::size_t RowBytes(
+    const std::tuple<TArgs...> & _Row
+  )
+{
+  return std::apply([](const auto & ... _Values) { return (std::size_t{ 0 } + ... + ValueBytes(_Values)); }, _Row);
+}
+
+// Owning result set handle, the cursor is closed when the handle goes out of scope
+class DBResultSet
+{
+public:
+
+  DBResultSet() = default;
+
+  DBResultSet(
+      oci::Statement * _Stmt,
+      oci::ResultSet * _Result
+    );
+
+  DBResultSet(
+      DBResultSet && _Other
+    ) noexcept;
+
+  DBResultSet & operator=(
+      DBResultSet && _Other
+    ) noexcept;
+
+  DBResultSet(const DBResultSet &) = delete;
+  DBResultSet & operator=(const DBResultSet &) = delete;
+
+  ~DBResultSet();
+
+  oci::ResultSet * operator->() const
+  {
+    return m_Result;
+  }
+
+  oci::ResultSet * Get() const
+  {
+    return m_Result;
+  }
+
+  bool Next();
+
+  void Close();
+
+private:
+
+  oci::Statement * m_Stmt = nullptr;
+  oci::ResultSet * m_Result = nullptr;
+};
+
+// Owning prepared statement with execution statistics, see DBStats.
+// The statement is terminated when the handle goes out of scope, so the connection must outlive it.
+class DBStatement
+{
+public:
+
+  DBStatement() = default;
+
+  DBStatement(
+      oci::Connection * _Conn,
+      const std::string & _Sql
+    );
+
+  DBStatement(
+      DBStatement && _Other
+    ) noexcept;
+
+  DBStatement & operator=(
+      DBStatement && _Other
+    ) noexcept;
+
+  DBStatement(const DBStatement &) = delete;
+  DBStatement & operator=(const DBStatement &) = delete;
+
+  ~DBStatement();
+
+  oci::Statement * operator->() const
+  {
+    return m_Stmt;
+  }
+
+  oci::Statement * Get() const
+  {
+    return m_Stmt;
+  }
+
+  StatementStats & GetStats() const
+  {
+    return *m_Stats;
+  }
+
+  unsigned int ExecuteUpdate();
+
+  // Executes the statement once per row of the buffers bound with setDataBuffer, returns the total update count
+  unsigned int ExecuteArrayUpdate(
+      unsigned int _Iterations
+    );
+
+  DBResultSet ExecuteQuery();
+
+  // REF CURSOR out parameter of the last execution
+  DBResultSet GetCursor(
+      unsigned int _Index
+    );
+
+  // Commits the connection, the latency is accounted to this statement
+  void Commit();
+
+  // Rolls back the connection, errors are swallowed so it is safe to call from a catch block
+  void Rollback();
+
+  // Executes the query and appends every row produced by _Reader to _Table
+  template<typename ... TArgs, typename TReader>
+  void FetchInto(
+      Table<TArgs...> & _Table,
+      TReader && _Reader
+    );
+
+  // Appends every remaining row of _Result produced by _Reader to _Table
+  template<typename ... TArgs, typename TReader>
+  void FetchInto(
+      DBResultSet & _Result,
+      Table<TArgs...> & _Table,
+      TReader && _Reader
+    );
+
+  // Appends rows of _Result produced by _Reader to _Table until _Deadline, returns true once no row is left.
+  // At least one row is read per call, so a fetch always makes progress.
+  template<typename ... TArgs, typename TReader>
+  bool FetchSome(
+      DBResultSet & _Result,
+      Table<TArgs...> & _Table,
+      TReader && _Reader,
+      std::chrono::steady_clock::time_point _Deadline
+    );
+
+  void Terminate();
+
+  // Statements executed with ExecuteUpdate or ExecuteArrayUpdate on the calling thread so far
+  static std::uint64_t GetWriteCount();
+
+private:
+
+  using Clock = std::chrono::steady_clock;
+
+  template<typename TExecute>
+  unsigned int ExecuteDml(
+      TExecute && _Execute
+    );
+
+  void RecordFetch(
+      Clock::time_point _Start,
+      std::uint64_t _Rows,
+      std::uint64_t _Bytes
+    );
+
+  oci::Connection * m_Conn = nullptr;
+  oci::Statement * m_Stmt = nullptr;
+  StatementStats * m_Stats = nullptr;
+};
+
+template<typename TExecute>
+unsigned int DBStatement::ExecuteDml(
+    TExecute && _Execute
+  )
+{
+  WL_TRACE_SCOPE_CAT("sql", "SQL execute");
+  const auto Start = Clock::now();
+
+  ++m_Stats->Executions;
+
+  try
+  {
+    const unsigned int Count = _Execute();
+    const auto Duration = Clock::now() - Start;
+
+    m_Stats->Rows += Count;
+    m_Stats->Execute.Record(Duration);
+    DBStats::Get().ReportLatency(*m_Stats, "execute", Duration, Count);
+
+    return Count;
+  }
+  catch (const oci::SQLException &)
+  {
+    ++m_Stats->Errors;
+    throw;
+  }
+}
+
+template<typename ... TArgs, typename TReader>
+void DBStatement::FetchInto(
+    Table<TArgs...> & _Table,
+    TReader && _Reader
+  )
+{
+  auto Result = ExecuteQuery();
+  FetchInto(Result, _Table, std::forward<TReader>(_Reader));
+}
+
+template<typename ... TArgs, typename TReader>
+void DBStatement::FetchInto(
+    DBResultSet & _Result,
+    Table<TArgs...> & _Table,
+    TReader && _Reader
+  )
+{
+  WL_TRACE_SCOPE_CAT("sql", "SQL fetch");
+  const auto Start = Clock::now();
+  std::uint64_t Rows = 0;
+  std::uint64_t Bytes = 0;
+
+  try
+  {
+    while (_Result.Next())
+    {
+      Bytes += RowBytes(_Table.emplace_back(_Reader(_Result.Get())));
+      ++Rows;
+    }
+  }
+  catch (const oci::SQLException &)
+  {
+    ++m_Stats->Errors;
+    RecordFetch(Start, Rows, Bytes);
+    throw;
+  }
+
+  RecordFetch(Start, Rows, Bytes);
+}
+
+template<typename ... TArgs, typename TReader>
+bool DBStatement::FetchSome(
+    DBResultSet & _Result,
+    Table<TArgs...> & _Table,
+    TReader && _Reader,
+    Clock::time_point _Deadline
+  )
+{
+  WL_TRACE_SCOPE_CAT("sql", "SQL fetch slice");
+  const auto Start = Clock::now();
+  std::uint64_t Rows = 0;
+  std::uint64_t Bytes = 0;
+  bool IsDone = false;
+
+  try
+  {
+    do
+    {
+      if (!_Result.Next())
+      {
+        IsDone = true;
+        break;
+      }
+
+      Bytes += RowBytes(_Table.emplace_back(_Reader(_Result.Get())));
+      ++Rows;
+    }
+    while (Clock::now() < _Deadline);
+  }
+  catch (const oci::SQLException &)
+  {
+    ++m_Stats->Errors;
+    RecordFetch(Start, Rows, Bytes);
+    throw;
+  }
+
+  RecordFetch(Start, Rows, Bytes);
+  return IsDone;
+}
\ No newline at end of file
@@ -0,0 +1,298 @@
+#include "DBStats.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+namespace
+{
+
+std::size_t BucketIndex(
+    std::uint64_t _Us
+  )
+{
+  std::size_t Idx = 0;
+  while (_Us > 1 && Idx + 1 < LatencyHistogram::BUCKET_COUNT)
+  {
+    _Us >>= 1;
+    ++Idx;
+  }
+  return Idx;
+}
+
+void WriteHandles(
+    std::ostream & _Out,
+    const char * _Name,
+    const HandleCounter & _Counter
+  )
+{
+  _Out << "  " << _Name
+       << ": open " << _Counter.GetOpen()
+       << ", peak " << _Counter.GetPeak()
+       << ", total " << _Counter.GetTotal() << '\n';
+}
+
+void WriteHistogram(
+    std::ostream & _Out,
+    const char * _Name,
+    const LatencyHistogram & _Histogram
+  )
+{
+  if (_Histogram.GetCount() == 0)
+    return;
+
+  _Out << "  " << _Name
+       << ": count " << _Histogram.GetCount()
+       << ", avg " << _Histogram.GetAverageMs() << " ms"
+       << ", p50 " << _Histogram.GetPercentileMs(0.5) << " ms"
+       << ", p95 " << _Histogram.GetPercentileMs(0.95) << " ms"
+       << ", p99 " << _Histogram.GetPercentileMs(0.99) << " ms"
+       << ", max " << _Histogram.GetMaxMs() << " ms\n";
+}
+
+} // namespace
+
+void LatencyHistogram::Record(
+    std::chrono::nanoseconds _Duration
+  )
+{
+  const auto Us = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(_Duration).count());
+
+  m_Buckets[BucketIndex(Us)].fetch_add(1, std::memory_order_relaxed);
+  m_Count.fetch_add(1, std::memory_order_relaxed);
+  m_TotalUs.fetch_add(Us, std::memory_order_relaxed);
+
+  auto Max = m_MaxUs.load(std::memory_order_relaxed);
+  while (Us > Max && !m_MaxUs.compare_exchange_weak(Max, Us, std::memory_order_relaxed))
+    ;
+}
+
+std::uint64_t LatencyHistogram::GetCount() const
+{
+  return m_Count.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::GetTotalMs() const
+{
+  return m_TotalUs.load(std::memory_order_relaxed) / 1000.0;
+}
+
+double LatencyHistogram::GetAverageMs() const
+{
+  const auto Count = GetCount();
+  return Count == 0 ? 0.0 : GetTotalMs() / Count;
+}
+
+double LatencyHistogram::GetMaxMs() const
+{
+  return m_MaxUs.load(std::memory_order_relaxed) / 1000.0;
+}
+
+double LatencyHistogram::GetPercentileMs(
+    double _Percentile
+  ) const
+{
+  const auto Count = GetCount();
+  if (Count == 0)
+    return 0.0;
+
+  const auto Target = static_cast<std::uint64_t>(_Percentile * Count);
+  std::uint64_t Seen = 0;
+  for (std::size_t i = 0; i < BUCKET_COUNT; ++i)
+  {
+    Seen += m_Buckets[i].load(std::memory_order_relaxed);
+    if (Seen > Target)
+      return std::min(static_cast<double>(std::uint64_t{ 2 } << i), static_cast<double>(m_MaxUs.load())) / 1000.0;
+  }
+  return GetMaxMs();
+}
+
+void LatencyHistogram::Reset()
+{
+  for (auto & Bucket : m_Buckets)
+    Bucket = 0;
+  m_Count = 0;
+  m_TotalUs = 0;
+  m_MaxUs = 0;
+}
+
+StatementStats::StatementStats(
+    std::string _Sql
+  ) :
+    Sql{ std::move(_Sql) }
+{
+}
+
+void StatementStats::Reset()
+{
+  Executions = 0;
+  Rows = 0;
+  Bytes = 0;
+  Errors = 0;
+  Execute.Reset();
+  Fetch.Reset();
+  Commit.Reset();
+}
+
+void HandleCounter::Acquire()
+{
+  const auto Open = m_Open.fetch_add(1, std::memory_order_relaxed) + 1;
+  m_Total.fetch_add(1, std::memory_order_relaxed);
+
+  auto Peak = m_Peak.load(std::memory_order_relaxed);
+  while (Open > Peak && !m_Peak.compare_exchange_weak(Peak, Open, std::memory_order_relaxed))
+    ;
+}
+
+void HandleCounter::Release()
+{
+  m_Open.fetch_sub(1, std::memory_order_relaxed);
+}
+
+std::uint64_t HandleCounter::GetOpen() const
+{
+  return m_Open.load(std::memory_order_relaxed);
+}
+
+std::uint64_t HandleCounter::GetPeak() const
+{
+  return m_Peak.load(std::memory_order_relaxed);
+}
+
+std::uint64_t HandleCounter::GetTotal() const
+{
+  return m_Total.load(std::memory_order_relaxed);
+}
+
+void HandleCounter::Reset()
+{
+  m_Peak = GetOpen();
+  m_Total = 0;
+}
+
+DBStats & DBStats::Get()
+{
+  static DBStats Instance;
+  return Instance;
+}
+
+StatementStats * DBStats::Register(
+    const std::string & _Sql
+  )
+{
+  std::scoped_lock Lock(m_Mutex);
+
+  auto & Stats = m_Statements[_Sql];
+  if (!Stats)
+    Stats = std::make_unique<StatementStats>(_Sql);
+
+  return Stats.get();
+}
+
+std::vector<StatementStats *> DBStats::GetStatements() const
+{
+  std::scoped_lock Lock(m_Mutex);
+
+  std::vector<StatementStats *> Result;
+  Result.reserve(m_Statements.size());
+  for (const auto & [Sql, Stats] : m_Statements)
+    Result.push_back(Stats.get());
+
+  return Result;
+}
+
+void DBStats::ReportLatency(
+    const StatementStats & _Stats,
+    const char * _Phase,
+    std::chrono::nanoseconds _Duration,
+    std::uint64_t _Rows
+  )
+{
+  const double DurationMs = std::chrono::duration<double, std::milli>(_Duration).count();
+  if (DurationMs < GetSlowQueryThresholdMs())
+    return;
+
+  std::scoped_lock Lock(m_Mutex);
+
+  m_SlowQueries.push_back(SlowQueryEntry{ _Stats.Sql, _Phase, DurationMs, _Rows, std::time(nullptr) });
+  if (m_SlowQueries.size() > SLOW_LOG_CAPACITY)
+    m_SlowQueries.pop_front();
+}
+
+std::vector<SlowQueryEntry> DBStats::GetSlowQueries() const
+{
+  std::scoped_lock Lock(m_Mutex);
+  return { m_SlowQueries.begin(), m_SlowQueries.end() };
+}
+
+HandleCounter & DBStats::GetStatementHandles()
+{
+  return m_StatementHandles;
+}
+
+HandleCounter & DBStats::GetResultSetHandles()
+{
+  return m_ResultSetHandles;
+}
+
+void DBStats::SetSlowQueryThresholdMs(
+    double _ThresholdMs
+  )
+{
+  m_SlowQueryThresholdMs = std::max(0.0, _ThresholdMs);
+}
+
+double DBStats::GetSlowQueryThresholdMs() const
+{
+  return m_SlowQueryThresholdMs;
+}
+
+bool DBStats::Dump(
+    const std::string & _Path
+  ) const
+{
+  std::ofstream Out(_Path);
+  if (!Out)
+    return false;
+
+  Out << std::fixed << std::setprecision(3);
+  Out << "== Handles ==\n";
+  WriteHandles(Out, "statements", m_StatementHandles);
+  WriteHandles(Out, "result sets", m_ResultSetHandles);
+
+  Out << "\n== Statements ==\n";
+  for (const auto * Stats : GetStatements())
+  {
+    Out << Stats->Sql << '\n'
+        << "  executions " << Stats->Executions
+        << ", rows " << Stats->Rows
+        << ", bytes " << Stats->Bytes
+        << ", errors " << Stats->Errors << '\n';
+    WriteHistogram(Out, "execute", Stats->Execute);
+    WriteHistogram(Out, "fetch", Stats->Fetch);
+    WriteHistogram(Out, "commit", Stats->Commit);
+  }
+
+  Out << "\n== Slow queries (>= " << GetSlowQueryThresholdMs() << " ms) ==\n";
+  for (const auto & Entry : GetSlowQueries())
+  {
+    char Time[32] = {};
+    std::strftime(Time, sizeof(Time), "%Y-%m-%d %H:%M:%S", std::localtime(&Entry.Timestamp));
+    Out << Time << "  " << Entry.Phase << "  " << Entry.DurationMs << " ms  "
+        << Entry.Rows << " rows  " << Entry.Sql << '\n';
+  }
+
+  return static_cast<bool>(Out);
+}
+
+void DBStats::Reset()
+{
+  for (auto * Stats : GetStatements())
+    Stats->Reset();
+
+  m_StatementHandles.Reset();
+  m_ResultSetHandles.Reset();
+
+  std::scoped_lock Lock(m_Mutex);
+  m_SlowQueries.clear();
+}
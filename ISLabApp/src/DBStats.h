@@ -0,0 +1,143 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class LatencyHistogram
+{
+public:
+
+  // Bucket i holds samples in [2^i, 2^(i+1)) microseconds, the last one is open-ended
+  static constexpr std::size_t BUCKET_COUNT = 24;
+
+  void Record(
+      std::chrono::nanoseconds _Duration
+    );
+
+  std::uint64_t GetCount() const;
+  double GetTotalMs() const;
+  double GetAverageMs() const;
+  double GetMaxMs() const;
+
+  double GetPercentileMs(
+      double _Percentile
+    ) const;
+
+  void Reset();
+
+private:
+
+  std::array<std::atomic<std::uint64_t>, BUCKET_COUNT> m_Buckets{};
+  std::atomic<std::uint64_t> m_Count{ 0 };
+  std::atomic<std::uint64_t> m_TotalUs{ 0 };
+  std::atomic<std::uint64_t> m_MaxUs{ 0 };
+};
+
+struct StatementStats
+{
+  explicit StatementStats(
+      std::string _Sql
+    );
+
+  void Reset();
+
+  const std::string Sql;
+
+  std::atomic<std::uint64_t> Executions{ 0 };
+  std::atomic<std::uint64_t> Rows{ 0 };
+  std::atomic<std::uint64_t> Bytes{ 0 };
+  std::atomic<std::uint64_t> Errors{ 0 };
+
+  LatencyHistogram Execute;
+  LatencyHistogram Fetch;
+  LatencyHistogram Commit;
+};
+
+// Number of live OCI handles of one kind, used to spot cursor leaks
+class HandleCounter
+{
+public:
+
+  void Acquire();
+  void Release();
+
+  std::uint64_t GetOpen() const;
+  std::uint64_t GetPeak() const;
+  std::uint64_t GetTotal() const;
+
+  // Peak restarts from the current open count
+  void Reset();
+
+private:
+
+  std::atomic<std::uint64_t> m_Open{ 0 };
+  std::atomic<std::uint64_t> m_Peak{ 0 };
+  std::atomic<std::uint64_t> m_Total{ 0 };
+};
+
+struct SlowQueryEntry
+{
+  std::string Sql;
+  std::string Phase;
+  double DurationMs;
+  std::uint64_t Rows;
+  std::time_t Timestamp;
+};
+
+class DBStats
+{
+public:
+
+  static constexpr std::size_t SLOW_LOG_CAPACITY = 256;
+
+  static DBStats & Get();
+
+  // Statements with the same SQL text share one entry, the returned pointer stays valid for the program lifetime
+  StatementStats * Register(
+      const std::string & _Sql
+    );
+
+  std::vector<StatementStats *> GetStatements() const;
+
+  void ReportLatency(
+      const StatementStats & _Stats,
+      const char * _Phase,
+      std::chrono::nanoseconds _Duration,
+      std::uint64_t _Rows
+    );
+
+  std::vector<SlowQueryEntry> GetSlowQueries() const;
+
+  HandleCounter & GetStatementHandles();
+  HandleCounter & GetResultSetHandles();
+
+  void SetSlowQueryThresholdMs(
+      double _ThresholdMs
+    );
+  double GetSlowQueryThresholdMs() const;
+
+  bool Dump(
+      const std::string & _Path
+    ) const;
+
+  void Reset();
+
+private:
+
+  mutable std::mutex m_Mutex;
+  std::map<std::string, std::unique_ptr<StatementStats>> m_Statements;
+  std::deque<SlowQueryEntry> m_SlowQueries;
+  std::atomic<double> m_SlowQueryThresholdMs{ 100.0 };
+
+  HandleCounter m_StatementHandles;
+  HandleCounter m_ResultSetHandles;
+};
@@ -0,0 +1,222 @@
+#include "DBStatsWindow.h"
+
+#include <imgui.h>
+#include <algorithm>
+#include <ctime>
+
+namespace
+{
+
+constexpr const char * DEFAULT_DUMP_PATH = "db_stats.txt";
+
+void LatencyColumns(
+    const LatencyHistogram & _Histogram
+  )
+{
+  ImGui::TableNextColumn();
+  ImGui::Text("%.3f", _Histogram.GetAverageMs());
+  ImGui::TableNextColumn();
+  ImGui::Text("%.3f", _Histogram.GetPercentileMs(0.95));
+  ImGui::TableNextColumn();
+  ImGui::Text("%.3f", _Histogram.GetMaxMs());
+}
+
+void HandleRow(
+    const char * _Name,
+    const HandleCounter & _Counter
+  )
+{
+  ImGui::TableNextRow();
+  ImGui::TableNextColumn();
+  ImGui::TextUnformatted(_Name);
+  ImGui::TableNextColumn();
+  ImGui::Text("%llu", static_cast<unsigned long long>(_Counter.GetOpen()));
+  ImGui::TableNextColumn();
+  ImGui::Text("%llu", static_cast<unsigned long long>(_Counter.GetPeak()));
+  ImGui::TableNextColumn();
+  ImGui::Text("%llu", static_cast<unsigned long long>(_Counter.GetTotal()));
+}
+
+} // namespace
+
+DBStatsWindow::DBStatsWindow()
+{
+  Copy(DEFAULT_DUMP_PATH, m_DumpPathBuffer);
+}
+
+void DBStatsWindow::OnUIRender()
+{
+  WL_TRACE_SCOPE_CAT("render", __FUNCTION__);
+
+  const bool IsVisible = ImGui::Begin("Database stats");
+
+  // Nothing to show while collapsed or in a hidden tab
+  if (!IsVisible)
+  {
+    ImGui::End();
+    return;
+  }
+
+  float Threshold = static_cast<float>(DBStats::Get().GetSlowQueryThresholdMs());
+  ImGui::SetNextItemWidth(120.0f);
+  if (ImGui::InputFloat("Slow query threshold, ms", &Threshold, 10.0f, 100.0f, "%.1f"))
+    DBStats::Get().SetSlowQueryThresholdMs(Threshold);
+
+  ImGui::SetNextItemWidth(240.0f);
+  ImGui::InputText("##DumpPath", m_DumpPathBuffer.data(), m_DumpPathBuffer.size());
+  ImGui::SameLine();
+  if (ImGui::Button("Dump to file") && !DBStats::Get().Dump(m_DumpPathBuffer.data()))
+  {
+    m_ErrorMessage = "Failed to write " + std::string(m_DumpPathBuffer.data());
+    OpenErrorWindow();
+  }
+
+  ImGui::SameLine();
+
+  if (ImGui::Button("Reset"))
+    DBStats::Get().Reset();
+
+  if (ImGui::CollapsingHeader("Open handles", ImGuiTreeNodeFlags_DefaultOpen))
+    RenderHandlesTable();
+
+  if (ImGui::CollapsingHeader("Statements", ImGuiTreeNodeFlags_DefaultOpen))
+    RenderStatementsTable();
+
+  if (ImGui::CollapsingHeader("Slow queries", ImGuiTreeNodeFlags_DefaultOpen))
+    RenderSlowQueriesTable();
+
+  RenderErrorWindow();
+
+  ImGui::End();
+}
+
+void DBStatsWindow::RenderHandlesTable()
+{
+  constexpr auto TableFlags = ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit;
+
+  if (ImGui::BeginTable("HandlesTable", 4, TableFlags))
+  {
+    ImGui::TableSetupColumn("Handle");
+    ImGui::TableSetupColumn("Open");
+    ImGui::TableSetupColumn("Peak");
+    ImGui::TableSetupColumn("Total");
+    ImGui::TableHeadersRow();
+
+    HandleRow("Statements", DBStats::Get().GetStatementHandles());
+    HandleRow("Result sets", DBStats::Get().GetResultSetHandles());
+
+    ImGui::EndTable();
+  }
+}
+
+void DBStatsWindow::RenderStatementsTable()
+{
+  constexpr auto TableFlags = ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable |
+                              ImGuiTableFlags_ScrollX | ImGuiTableFlags_ScrollY |
+                              ImGuiTableFlags_SizingFixedFit;
+
+  if (ImGui::BeginTable("StatementsTable", 14, TableFlags, ImVec2(-1, ImGui::GetContentRegionAvail().y * 0.6f)))
+  {
+    ImGui::TableSetupScrollFreeze(1, 1);
+    ImGui::TableSetupColumn("SQL");
+    ImGui::TableSetupColumn("Executions");
+    ImGui::TableSetupColumn("Errors");
+    ImGui::TableSetupColumn("Rows");
+    ImGui::TableSetupColumn("Bytes");
+    ImGui::TableSetupColumn("Exec avg, ms");
+    ImGui::TableSetupColumn("Exec p95, ms");
+    ImGui::TableSetupColumn("Exec max, ms");
+    ImGui::TableSetupColumn("Fetch avg, ms");
+    ImGui::TableSetupColumn("Fetch p95, ms");
+    ImGui::TableSetupColumn("Fetch max, ms");
+    ImGui::TableSetupColumn("Commit avg, ms");
+    ImGui::TableSetupColumn("Commit p95, ms");
+    ImGui::TableSetupColumn("Commit max, ms");
+    ImGui::TableHeadersRow();
+
+    for (const auto * Stats : DBStats::Get().GetStatements())
+    {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(Stats->Sql.c_str());
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", static_cast<unsigned long long>(Stats->Executions));
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", static_cast<unsigned long long>(Stats->Errors));
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", static_cast<unsigned long long>(Stats->Rows));
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", static_cast<unsigned long long>(Stats->Bytes));
+      LatencyColumns(Stats->Execute);
+      LatencyColumns(Stats->Fetch);
+      LatencyColumns(Stats->Commit);
+    }
+
+    ImGui::EndTable();
+  }
+}
+
+void DBStatsWindow::RenderSlowQueriesTable()
+{
+  constexpr auto TableFlags = ImGuiTableFlags_Borders | ImGuiTableFlags_Resizable |
+                              ImGuiTableFlags_ScrollX | ImGuiTableFlags_ScrollY |
+                              ImGuiTableFlags_SizingFixedFit;
+
+  if (ImGui::BeginTable("SlowQueriesTable", 5, TableFlags, ImVec2(-1, -1)))
+  {
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Time");
+    ImGui::TableSetupColumn("Phase");
+    ImGui::TableSetupColumn("Duration, ms");
+    ImGui::TableSetupColumn("Rows");
+    ImGui::TableSetupColumn("SQL");
+    ImGui::TableHeadersRow();
+
+    auto SlowQueries = DBStats::Get().GetSlowQueries();
+    std::reverse(SlowQueries.begin(), SlowQueries.end());
+
+    for (const auto & Entry : SlowQueries)
+    {
+      char Time[32] = {};
+      std::strftime(Time, sizeof(Time), "%H:%M:%S", std::localtime(&Entry.Timestamp));
+
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(Time);
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(Entry.Phase.c_str());
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3f", Entry.DurationMs);
+      ImGui::TableNextColumn();
+      ImGui::Text("%llu", static_cast<unsigned long long>(Entry.Rows));
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(Entry.Sql.c_str());
+    }
+
+    ImGui::EndTable();
+  }
+}
+
+void DBStatsWindow::OpenErrorWindow()
+{
+  m_IsError = true;
+  ImGui::OpenPopup("Error");
+}
+
+void DBStatsWindow::RenderErrorWindow()
+{
+  if (ImGui::BeginPopupModal("Error", &m_IsError, ImGuiWindowFlags_AlwaysAutoResize))
+  {
+    ImGui::TextUnformatted(m_ErrorMessage.c_str());
+
+    if (ButtonCentered("OK"))
+      CloseErrorWindow();
+
+    ImGui::EndPopup();
+  }
+}
+
+void DBStatsWindow::CloseErrorWindow()
+{
+  m_IsError = false;
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "ISLabApp.h"
+#include "IWindow.h"
+#include "DBStats.h"
+
+#include <imgui.h>
+#include <string>
+#include <vector>
+
+class DBStatsWindow
+  : public IWindow
+{
+public:
+
+  DBStatsWindow();
+
+  void OnUIRender() override;
+
+  void RenderHandlesTable();
+  void RenderStatementsTable();
+  void RenderSlowQueriesTable();
+
+  void OpenErrorWindow();
+  void RenderErrorWindow();
+  void CloseErrorWindow();
+
+private:
+
+  std::vector<char> m_DumpPathBuffer = std::vector<char>(260 + 1, '\0');
+
+  bool m_IsError = false;
+
+  std::string m_ErrorMessage;
+};
\ No newline at end of file
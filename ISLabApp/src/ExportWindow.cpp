@@ -0,0 +1,200 @@
+#include "ExportWindow.h"
+
+#include "CountriesTableWindow.h"
+#include "WarehousesTableWindow.h"
+#include "ProductCategoriesTableWindow.h"
+#include "ProductsTableWindow.h"
+#include "CustomersTableWindow.h"
+#include "OrdersTableWindow.h"
+#include "InventoriesTableWindow.h"
+
+#include <imgui.h>
+#include <Walnut/Application.h>
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+
+struct ExportSource
+{
+  const char * Name;
+  const char * Sql;
+};
+
+const ExportSource TABLE_SOURCES[] = {
+    { CountriesTableWindow::TABLE_NAME, CountriesTableWindow::UPDATE_QUERY },
+    { WarehousesTableWindow::TABLE_NAME, WarehousesTableWindow::UPDATE_QUERY },
+    { ProductCategoriesTableWindow::TABLE_NAME, ProductCategoriesTableWindow::UPDATE_QUERY },
+    // The window loads descriptions on demand, an export wants them all
+    { ProductsTableWindow::TABLE_NAME, "SELECT product_id, product_name, description, cost, price, category_id FROM products" },
+    { CustomersTableWindow::TABLE_NAME, CustomersTableWindow::UPDATE_QUERY },
+    { OrdersTableWindow::TABLE_NAME, OrdersTableWindow::UPDATE_QUERY },
+    { InventoriesTableWindow::TABLE_NAME, InventoriesTableWindow::UPDATE_QUERY },
+  };
+
+constexpr int TABLE_SOURCE_COUNT = static_cast<int>(std::size(TABLE_SOURCES));
+
+constexpr float PROGRESS_REFRESH_INTERVAL = 0.25f;
+
+} // namespace
+
+ExportWindow::ExportWindow(
+    oci::Environment * _Env,
+    std::string _UserName,
+    std::string _Password,
+    std::string _ConnectString
+  ) :
+    m_Export(_Env, std::move(_UserName), std::move(_Password), std::move(_ConnectString))
+{
+  ResetPath();
+}
+
+void ExportWindow::OnUIRender()
+{
+  WL_TRACE_SCOPE_CAT("render", __FUNCTION__);
+
+  const bool IsVisible = ImGui::Begin("Export");
+
+  // A running export goes on, only its progress is not drawn
+  if (!IsVisible)
+  {
+    ImGui::End();
+    return;
+  }
+
+  const bool IsRunning = m_Export.IsRunning();
+  const auto Progress = m_Export.GetProgress();
+
+  ImGui::BeginDisabled(IsRunning);
+
+  const char * SourceName = m_Source < TABLE_SOURCE_COUNT ? TABLE_SOURCES[m_Source].Name : m_ViewName.c_str();
+  if (ImGui::BeginCombo("Source", SourceName))
+  {
+    for (int i = 0; i < TABLE_SOURCE_COUNT; ++i)
+      if (ImGui::Selectable(TABLE_SOURCES[i].Name, m_Source == i))
+      {
+        m_Source = i;
+        ResetPath();
+      }
+
+    if (m_ViewQuery && ImGui::Selectable(m_ViewName.c_str(), m_Source == TABLE_SOURCE_COUNT))
+    {
+      m_Source = TABLE_SOURCE_COUNT;
+      ResetPath();
+    }
+    ImGui::EndCombo();
+  }
+
+  if (ImGui::RadioButton("CSV", &m_Format, static_cast<int>(EExportFormat::CSV)))
+    ResetPath();
+  ImGui::SameLine();
+  if (ImGui::RadioButton("JSON lines", &m_Format, static_cast<int>(EExportFormat::JSONL)))
+    ResetPath();
+
+  ImGui::InputText("File", m_PathBuffer.data(), m_PathBuffer.size());
+
+  ImGui::SetNextItemWidth(120.0f);
+  ImGui::InputInt("Rows per round trip", &m_BatchSize, 100, 1000);
+  m_BatchSize = std::clamp(m_BatchSize, 1, TableExport::MAX_BATCH_SIZE);
+
+  if (ImGui::Button("Export"))
+    StartExport();
+
+  ImGui::EndDisabled();
+
+  if (IsRunning)
+  {
+    ImGui::SameLine();
+    if (ImGui::Button("Cancel"))
+      m_Export.Cancel();
+
+    Walnut::Application::Get().RequestFrame(PROGRESS_REFRESH_INTERVAL);
+  }
+
+  if (Progress.IsRunning || Progress.IsDone)
+    RenderProgress(Progress);
+
+  RenderErrorWindow();
+
+  ImGui::End();
+}
+
+void ExportWindow::RenderProgress(
+    const ExportProgress & _Progress
+  )
+{
+  ImGui::Separator();
+
+  ImGui::Text("%s %llu rows, %.1f MB in %.1f s, %.0f rows/s",
+      _Progress.IsRunning ? "Exporting" : "Exported",
+      static_cast<unsigned long long>(_Progress.Rows),
+      _Progress.Bytes / (1024.0 * 1024.0),
+      _Progress.ElapsedSeconds,
+      _Progress.GetRowsPerSecond());
+
+  if (!_Progress.Error.empty())
+    ImGui::TextWrapped("Stopped: %s", _Progress.Error.c_str());
+}
+
+void ExportWindow::SetViewSource(
+    std::string _Name,
+    QueryBuilder _Query
+  )
+{
+  m_ViewName = std::move(_Name);
+  m_ViewQuery = std::move(_Query);
+
+  if (!m_Export.IsRunning())
+  {
+    m_Source = TABLE_SOURCE_COUNT;
+    ResetPath();
+  }
+}
+
+void ExportWindow::OpenErrorWindow()
+{
+  m_IsError = true;
+  ImGui::OpenPopup("Error");
+}
+
+void ExportWindow::RenderErrorWindow()
+{
+  if (ImGui::BeginPopupModal("Error", &m_IsError, ImGuiWindowFlags_AlwaysAutoResize))
+  {
+    ImGui::TextUnformatted(m_ErrorMessage.c_str());
+
+    if (ButtonCentered("OK"))
+      CloseErrorWindow();
+
+    ImGui::EndPopup();
+  }
+}
+
+void ExportWindow::CloseErrorWindow()
+{
+  m_IsError = false;
+}
+
+void ExportWindow::StartExport()
+{
+  ExportOptions Options;
+  Options.Query = m_Source < TABLE_SOURCE_COUNT ? QueryBuilder(TABLE_SOURCES[m_Source].Sql) : *m_ViewQuery;
+  Options.Path = m_PathBuffer.data();
+  Options.Format = static_cast<EExportFormat>(m_Format);
+  Options.BatchSize = m_BatchSize;
+
+  if (Options.Path.empty())
+  {
+    m_ErrorMessage = "Choose a file to export to";
+    return OpenErrorWindow();
+  }
+
+  m_Export.Start(std::move(Options));
+}
+
+void ExportWindow::ResetPath()
+{
+  const std::string Name = m_Source < TABLE_SOURCE_COUNT ? TABLE_SOURCES[m_Source].Name : m_ViewName;
+  Copy(Name + TableExport::GetExtension(static_cast<EExportFormat>(m_Format)), m_PathBuffer);
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "ISLabApp.h"
+#include "IWindow.h"
+#include "TableExport.h"
+
+#include <imgui.h>
+#include <optional>
+#include <string>
+#include <vector>
+
+class ExportWindow
+  : public IWindow
+{
+public:
+
+  ExportWindow(
+      oci::Environment * _Env,
+      std::string _UserName,
+      std::string _Password,
+      std::string _ConnectString
+    );
+
+  void OnUIRender() override;
+
+  void RenderProgress(
+      const ExportProgress & _Progress
+    );
+
+  // Offers the rows another window shows as a source next to the tables, the previous view is replaced
+  void SetViewSource(
+      std::string _Name,
+      QueryBuilder _Query
+    );
+
+  void OpenErrorWindow();
+  void RenderErrorWindow();
+  void CloseErrorWindow();
+
+private:
+
+  void StartExport();
+
+  void ResetPath();
+
+  TableExport m_Export;
+
+  std::string m_ViewName;
+  std::optional<QueryBuilder> m_ViewQuery;
+
+  // Index into the tables, one past the last selects the view
+  int m_Source = 0;
+  int m_Format = static_cast<int>(EExportFormat::CSV);
+  std::vector<char> m_PathBuffer = std::vector<char>(260 + 1, '\0');
+  int m_BatchSize = ExportOptions().BatchSize;
+
+  bool m_IsError = false;
+
+  std::string m_ErrorMessage;
+};
\ No newline at end of file
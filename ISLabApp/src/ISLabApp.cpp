@@ -3,18 +3,33 @@
 #include <Walnut/Application.h>
 #include <Walnut/EntryPoint.h>
 #include <Walnut/Image.h>
+#include <Walnut/Trace.h>
+#include <cstdlib>
 
 Walnut::Application* Walnut::CreateApplication(int argc, char** argv)
 {
+  // --import runs headless, see ParseImportArguments
+  if (const auto ExitCode = DBLayer::RunImportCommand(argc, argv))
+    std::exit(*ExitCode);
+
   Walnut::ApplicationSpecification spec;
   spec.Name = "IS lab work";
+  spec.IdleRendering = true;
+  spec.MaxFrameRate = 60;
 
   Walnut::Application * app = new Walnut::Application(spec);
-  app->PushLayer<DBLayer>();
-  app->SetMenubarCallback([app]()
+  auto Layer = std::make_shared<DBLayer>();
+  app->PushLayer(Layer);
+  app->SetMenubarCallback([app, Layer]()
     {
       if (ImGui::BeginMenu("File"))
       {
+        if (ImGui::MenuItem("Refresh tables", nullptr, false, !Layer->IsRefreshing()))
+          Layer->RefreshTables();
+#ifdef WL_ENABLE_TRACING
+        if (ImGui::MenuItem("Write trace"))
+          Walnut::Trace::WriteChromeJson("islab_trace.json");
+#endif
         if (ImGui::MenuItem("Exit"))
         {
           app->Close();
@@ -6,6 +6,7 @@
 #include <imgui.h>
 #include <tuple>
 #include <signals/Signal.h>
+#include <Walnut/Trace.h>
 
 namespace oci = oracle::occi;
 
@@ -0,0 +1,216 @@
+#include "ImportWindow.h"
+
+#include "ProductCategoriesTableWindow.h"
+#include "ProductsTableWindow.h"
+#include "WarehousesTableWindow.h"
+#include "InventoriesTableWindow.h"
+
+#include <imgui.h>
+#include <Walnut/Application.h>
+#include <algorithm>
+
+namespace
+{
+
+constexpr float PROGRESS_REFRESH_INTERVAL = 0.25f;
+
+template<typename TTable>
+void CollectKeys(
+    const TTable & _Table,
+    std::unordered_set<int> & _Keys
+  )
+{
+  _Keys.reserve(_Table.size());
+  for (const auto & Row : _Table)
+    _Keys.insert(std::get<0>(Row));
+}
+
+} // namespace
+
+ImportWindow::ImportWindow(
+    oci::Environment * _Env,
+    std::string _UserName,
+    std::string _Password,
+    std::string _ConnectString,
+    ProductCategoriesTableWindow * _Categories,
+    ProductsTableWindow * _Products,
+    WarehousesTableWindow * _Warehouses,
+    InventoriesTableWindow * _Inventories
+  ) :
+    m_Import(_Env, std::move(_UserName), std::move(_Password), std::move(_ConnectString)),
+    m_Categories{ _Categories },
+    m_Products{ _Products },
+    m_Warehouses{ _Warehouses },
+    m_Inventories{ _Inventories }
+{
+}
+
+void ImportWindow::OnUIRender()
+{
+  WL_TRACE_SCOPE_CAT("render", __FUNCTION__);
+
+  const bool IsVisible = ImGui::Begin("Import");
+
+  const bool IsRunning = m_Import.IsRunning();
+  const auto Progress = m_Import.GetProgress();
+
+  // Watched even while hidden, the finished import reloads the tables it wrote
+  if (m_IsImporting && !IsRunning)
+    OnImportFinished(Progress);
+
+  if (IsRunning)
+    Walnut::Application::Get().RequestFrame(PROGRESS_REFRESH_INTERVAL);
+
+  // Collapsed or in a hidden tab
+  if (!IsVisible)
+  {
+    ImGui::End();
+    return;
+  }
+
+  ImGui::BeginDisabled(IsRunning);
+
+  ImGui::RadioButton("Products", &m_Target, static_cast<int>(EImportTarget::PRODUCTS));
+  ImGui::SameLine();
+  ImGui::RadioButton("Inventories", &m_Target, static_cast<int>(EImportTarget::INVENTORIES));
+
+  ImGui::TextDisabled(m_Target == static_cast<int>(EImportTarget::PRODUCTS)
+      ? "Columns: product_name, description, cost, price, category_id"
+      : "Columns: product_id, warehouse_id, quantity");
+
+  ImGui::InputText("CSV file", m_PathBuffer.data(), m_PathBuffer.size());
+  ImGui::Checkbox("First line is a header", &m_HasHeader);
+
+  ImGui::SetNextItemWidth(120.0f);
+  ImGui::InputInt("Rows per batch", &m_BatchSize, 100, 1000);
+  ImGui::SetNextItemWidth(120.0f);
+  ImGui::InputInt("Rows per commit", &m_CommitInterval, 1000, 10000);
+
+  m_BatchSize = std::clamp(m_BatchSize, 1, BulkImport::MAX_BATCH_SIZE);
+  m_CommitInterval = std::max(m_CommitInterval, 1);
+
+  if (ImGui::Button("Import"))
+    StartImport();
+
+  ImGui::EndDisabled();
+
+  if (IsRunning)
+  {
+    ImGui::SameLine();
+    if (ImGui::Button("Cancel"))
+      m_Import.Cancel();
+  }
+
+  if (Progress.IsRunning || Progress.IsDone)
+    RenderProgress(Progress);
+
+  RenderErrorWindow();
+
+  ImGui::End();
+}
+
+void ImportWindow::RenderProgress(
+    const ImportProgress & _Progress
+  )
+{
+  ImGui::Separator();
+
+  const float Fraction = _Progress.FileSize == 0 ? 0.0f : static_cast<float>(_Progress.BytesRead) / _Progress.FileSize;
+  const auto Overlay = std::to_string(_Progress.BytesRead >> 20) + " / " + std::to_string(_Progress.FileSize >> 20) + " MB";
+  ImGui::ProgressBar(Fraction, ImVec2(-1.0f, 0.0f), Overlay.c_str());
+
+  ImGui::Text("Read %llu rows in %.1f s, %.0f rows/s",
+      static_cast<unsigned long long>(_Progress.RowsRead), _Progress.ElapsedSeconds, _Progress.GetRowsPerSecond());
+  ImGui::Text("Inserted %llu, committed %llu, rejected %llu",
+      static_cast<unsigned long long>(_Progress.RowsInserted),
+      static_cast<unsigned long long>(_Progress.RowsCommitted),
+      static_cast<unsigned long long>(_Progress.RowsRejected));
+
+  if (!_Progress.Error.empty())
+    ImGui::TextWrapped("Stopped: %s", _Progress.Error.c_str());
+
+  if (!_Progress.Rejections.empty() && ImGui::CollapsingHeader("Rejected rows"))
+  {
+    for (const auto & Rejection : _Progress.Rejections)
+      ImGui::TextUnformatted(Rejection.c_str());
+    if (_Progress.RowsRejected > _Progress.Rejections.size())
+      ImGui::TextDisabled("...");
+  }
+}
+
+void ImportWindow::OpenErrorWindow()
+{
+  m_IsError = true;
+  ImGui::OpenPopup("Error");
+}
+
+void ImportWindow::RenderErrorWindow()
+{
+  if (ImGui::BeginPopupModal("Error", &m_IsError, ImGuiWindowFlags_AlwaysAutoResize))
+  {
+    ImGui::TextUnformatted(m_ErrorMessage.c_str());
+
+    if (ButtonCentered("OK"))
+      CloseErrorWindow();
+
+    ImGui::EndPopup();
+  }
+}
+
+void ImportWindow::CloseErrorWindow()
+{
+  m_IsError = false;
+}
+
+void ImportWindow::StartImport()
+{
+  ImportOptions Options;
+  Options.Target = static_cast<EImportTarget>(m_Target);
+  Options.Path = m_PathBuffer.data();
+  Options.HasHeader = m_HasHeader;
+  Options.BatchSize = m_BatchSize;
+  Options.CommitInterval = m_CommitInterval;
+
+  if (Options.Path.empty())
+  {
+    m_ErrorMessage = "Choose a CSV file to import";
+    return OpenErrorWindow();
+  }
+
+  // Rows are checked against the tables as loaded, a parent row deleted meanwhile fails its batch on the server
+  ImportKeys Keys;
+  if (Options.Target == EImportTarget::PRODUCTS)
+  {
+    CollectKeys(m_Categories->GetTable(), Keys.Categories);
+  }
+  else
+  {
+    CollectKeys(m_Products->GetTable(), Keys.Products);
+    CollectKeys(m_Warehouses->GetTable(), Keys.Warehouses);
+  }
+
+  m_ImportingTarget = Options.Target;
+  m_IsImporting = true;
+  m_Import.Start(std::move(Options), std::move(Keys));
+}
+
+void ImportWindow::OnImportFinished(
+    const ImportProgress & _Progress
+  )
+{
+  m_IsImporting = false;
+
+  if (_Progress.RowsCommitted == 0)
+    return;
+
+  if (m_ImportingTarget == EImportTarget::PRODUCTS)
+  {
+    m_Products->UpdateTable();
+    m_Products->TableChangedSignal.Emit();
+  }
+  else
+  {
+    m_Inventories->UpdateTable();
+    m_Inventories->TableChangedSignal.Emit();
+  }
+}
\ No newline at end of file
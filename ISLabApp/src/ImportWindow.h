@@ -0,0 +1,70 @@
+#pragma once
+
+#include "ISLabApp.h"
+#include "IWindow.h"
+#include "BulkImport.h"
+
+#include <imgui.h>
+#include <string>
+#include <vector>
+
+class ProductCategoriesTableWindow;
+class ProductsTableWindow;
+class WarehousesTableWindow;
+class InventoriesTableWindow;
+
+class ImportWindow
+  : public IWindow
+{
+public:
+
+  ImportWindow(
+      oci::Environment * _Env,
+      std::string _UserName,
+      std::string _Password,
+      std::string _ConnectString,
+      ProductCategoriesTableWindow * _Categories,
+      ProductsTableWindow * _Products,
+      WarehousesTableWindow * _Warehouses,
+      InventoriesTableWindow * _Inventories
+    );
+
+  void OnUIRender() override;
+
+  void RenderProgress(
+      const ImportProgress & _Progress
+    );
+
+  void OpenErrorWindow();
+  void RenderErrorWindow();
+  void CloseErrorWindow();
+
+private:
+
+  void StartImport();
+
+  // Reloads the imported table once the worker is done
+  void OnImportFinished(
+      const ImportProgress & _Progress
+    );
+
+  BulkImport m_Import;
+
+  int m_Target = static_cast<int>(EImportTarget::PRODUCTS);
+  std::vector<char> m_PathBuffer = std::vector<char>(260 + 1, '\0');
+  int m_BatchSize = ImportOptions().BatchSize;
+  int m_CommitInterval = ImportOptions().CommitInterval;
+  bool m_HasHeader = true;
+
+  bool m_IsImporting = false;
+  EImportTarget m_ImportingTarget = EImportTarget::PRODUCTS;
+
+  bool m_IsError = false;
+
+  std::string m_ErrorMessage;
+
+  ProductCategoriesTableWindow * m_Categories = nullptr;
+  ProductsTableWindow * m_Products = nullptr;
+  WarehousesTableWindow * m_Warehouses = nullptr;
+  InventoriesTableWindow * m_Inventories = nullptr;
+};
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "IncrementalFetch.h"
+
+#include <algorithm>
+
+IncrementalFetch::~IncrementalFetch()
+{
+  Cancel();
+}
+
+void IncrementalFetch::Cancel()
+{
+  m_Step = nullptr;
+  FetchScheduler::Get().Remove(this);
+}
+
+bool IncrementalFetch::Step(
+    Clock::time_point _Deadline
+  )
+{
+  // Moved out, the callbacks of a finished fetch may start the next one
+  auto CurrentStep = std::move(m_Step);
+  m_Step = nullptr;
+
+  if (CurrentStep(_Deadline))
+    return !m_Step;
+
+  m_Step = std::move(CurrentStep);
+  return false;
+}
+
+void IncrementalFetch::Register()
+{
+  FetchScheduler::Get().Add(this);
+}
+
+FetchScheduler & FetchScheduler::Get()
+{
+  static FetchScheduler Instance;
+  return Instance;
+}
+
+bool FetchScheduler::Run(
+    std::chrono::microseconds _Budget
+  )
+{
+  if (m_Fetches.empty())
+    return false;
+
+  WL_TRACE_SCOPE_CAT("sql", __FUNCTION__);
+
+  const auto Deadline = IncrementalFetch::Clock::now() + _Budget;
+
+  // Visible first, the order is kept otherwise so no fetch waits behind one started later
+  auto Fetches = m_Fetches;
+  std::stable_partition(Fetches.begin(), Fetches.end(), [](const IncrementalFetch * _Fetch)
+  {
+    return _Fetch->m_IsVisible;
+  });
+
+  for (auto * Fetch : Fetches)
+  {
+    // Cancelled by the callbacks of a fetch stepped before it
+    if (std::find(m_Fetches.begin(), m_Fetches.end(), Fetch) == m_Fetches.end())
+      continue;
+
+    if (IncrementalFetch::Clock::now() >= Deadline)
+      break;
+
+    if (Fetch->Step(Deadline))
+      Remove(Fetch);
+  }
+
+  for (auto * Fetch : m_Fetches)
+    Fetch->m_IsVisible = false;
+
+  return !m_Fetches.empty();
+}
+
+void FetchScheduler::Add(
+    IncrementalFetch * _Fetch
+  )
+{
+  if (std::find(m_Fetches.begin(), m_Fetches.end(), _Fetch) == m_Fetches.end())
+    m_Fetches.push_back(_Fetch);
+}
+
+void FetchScheduler::Remove(
+    IncrementalFetch * _Fetch
+  )
+{
+  m_Fetches.erase(std::remove(m_Fetches.begin(), m_Fetches.end(), _Fetch), m_Fetches.end());
+}
\ No newline at end of file
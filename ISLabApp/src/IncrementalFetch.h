@@ -0,0 +1,163 @@
+#pragma once
+
+#include "ISLabApp.h"
+#include "DBStatement.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// One round trip of a fetch refills at most this many rows or bytes, a slice never waits on a long one
+inline constexpr unsigned int FETCH_PREFETCH_ROWS = 128;
+inline constexpr unsigned int FETCH_PREFETCH_BYTES = 64 * 1024;
+
+// A query whose rows are decoded a slice per frame on the UI thread instead of all at once.
+// The result set stays open between frames, the rows are handed over once the last one is read.
+class IncrementalFetch
+{
+public:
+
+  using Clock = std::chrono::steady_clock;
+
+  IncrementalFetch() = default;
+  ~IncrementalFetch();
+
+  IncrementalFetch(const IncrementalFetch &) = delete;
+  IncrementalFetch & operator=(const IncrementalFetch &) = delete;
+
+  // Executes the query of _Stmt, FetchScheduler then reads its rows. A fetch already running is dropped.
+  // _OnDone gets the whole table, _OnError the error of a failed fetch, both are called on the UI thread.
+  // _Stmt must not be executed again before the fetch ends.
+  template<typename TTable, typename TReader, typename TDone, typename TError>
+  void Start(
+      DBStatement & _Stmt,
+      TReader _Reader,
+      TDone _OnDone,
+      TError _OnError
+    );
+
+  void Cancel();
+
+  bool IsActive() const
+  {
+    return static_cast<bool>(m_Step);
+  }
+
+  // Called by the owner in the frames it is visible, visible fetches use the budget first
+  void MarkVisible()
+  {
+    m_IsVisible = true;
+  }
+
+private:
+
+  friend class FetchScheduler;
+
+  // Returns true once the fetch ended
+  bool Step(
+      Clock::time_point _Deadline
+    );
+
+  void Register();
+
+  std::function<bool(Clock::time_point)> m_Step;
+  bool m_IsVisible = false;
+};
+
+// Shares a time budget per frame among the running fetches, UI thread only
+class FetchScheduler
+{
+public:
+
+  static FetchScheduler & Get();
+
+  // Returns true while some fetch is still running
+  bool Run(
+      std::chrono::microseconds _Budget
+    );
+
+private:
+
+  friend class IncrementalFetch;
+
+  void Add(
+      IncrementalFetch * _Fetch
+    );
+
+  void Remove(
+      IncrementalFetch * _Fetch
+    );
+
+  std::vector<IncrementalFetch *> m_Fetches;
+};
+
+template<typename TTable, typename TReader, typename TDone, typename TError>
+void IncrementalFetch::Start(
+    DBStatement & _Stmt,
+    TReader _Reader,
+    TDone _OnDone,
+    TError _OnError
+  )
+{
+  WL_TRACE_SCOPE_CAT("sql", __FUNCTION__);
+
+  Cancel();
+
+  struct State
+  {
+    DBStatement * Stmt = nullptr;
+    DBResultSet Result;
+    TTable Rows;
+    std::uint64_t WriteCount = 0;
+
+    void Execute()
+    {
+      Result.Close();
+      Rows.clear();
+      WriteCount = DBStatement::GetWriteCount();
+      Result = Stmt->ExecuteQuery();
+    }
+  };
+
+  auto FetchState = std::make_shared<State>();
+  FetchState->Stmt = &_Stmt;
+
+  try
+  {
+    _Stmt->setPrefetchRowCount(FETCH_PREFETCH_ROWS);
+    _Stmt->setPrefetchMemorySize(FETCH_PREFETCH_BYTES);
+    FetchState->Execute();
+  }
+  catch (const oci::SQLException & ex)
+  {
+    _OnError(ex);
+    return;
+  }
+
+  m_Step = [FetchState, _Reader, _OnDone, _OnError](Clock::time_point _Deadline) mutable
+  {
+    try
+    {
+      // The query reads as of its execution, rows written on this session since then would be missing
+      if (DBStatement::GetWriteCount() != FetchState->WriteCount)
+        FetchState->Execute();
+
+      if (!FetchState->Stmt->FetchSome(FetchState->Result, FetchState->Rows, _Reader, _Deadline))
+        return false;
+
+      FetchState->Result.Close();
+    }
+    catch (const oci::SQLException & ex)
+    {
+      FetchState->Result.Close();
+      _OnError(ex);
+      return true;
+    }
+
+    _OnDone(std::move(FetchState->Rows));
+    return true;
+  };
+
+  Register();
+}
\ No newline at end of file
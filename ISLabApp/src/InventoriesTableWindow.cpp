@@ -2,6 +2,7 @@
 
 #include "WarehousesTableWindow.h"
 #include "ProductsTableWindow.h"
+#include "TableOps.h"
 
 #include <imgui.h>
 #include <algorithm>
@@ -19,38 +20,43 @@ InventoriesTableWindow::InventoriesTableWindow(
     m_Warehouses{ _Warehouses },
     m_Products{ _Products }
 {
-  m_CreateStmt = m_Conn->createStatement("INSERT INTO inventories(product_id,warehouse_id,quantity) VALUES(:1,:2,:3)");
-  m_DeleteStmt = m_Conn->createStatement("DELETE FROM inventories WHERE product_id = :1 AND warehouse_id = :2");
-  m_DecreaseStmt = m_Conn->createStatement("UPDATE inventories SET quantity = :1 WHERE product_id = :2 AND warehouse_id = :3");
-  m_UpdateStmt = m_Conn->createStatement("SELECT * FROM inventories");
+  m_CreateStmt = DBStatement(m_Conn, "INSERT INTO inventories(product_id,warehouse_id,quantity) VALUES(:1,:2,:3)");
+  m_DeleteStmt = DBStatement(m_Conn, "DELETE FROM inventories WHERE product_id = :1 AND warehouse_id = :2");
+  m_UpdateStmt = DBStatement(m_Conn, UPDATE_QUERY);
 
-  m_SignalConnections.AddConnection(m_Warehouses->TableChangedSignal, this, &InventoriesTableWindow::UpdateTable);
-  m_SignalConnections.AddConnection(m_Products->TableChangedSignal, this, &InventoriesTableWindow::UpdateTable);
+  m_SignalConnections.AddConnection(m_Warehouses->RowsDeletedSignal, this, &InventoriesTableWindow::OnParentRowsDeleted);
+  m_SignalConnections.AddConnection(m_Products->RowsDeletedSignal, this, &InventoriesTableWindow::OnParentRowsDeleted);
 }
 
 InventoriesTableWindow::~InventoriesTableWindow()
 {
-  m_Conn->terminateStatement(m_CreateStmt);
-  m_Conn->terminateStatement(m_DeleteStmt);
-  m_Conn->terminateStatement(m_DecreaseStmt);
-  m_Conn->terminateStatement(m_UpdateStmt);
-
   m_SignalConnections.Disconnect();
 }
 
 void InventoriesTableWindow::OnUIRender()
 {
-  ImGui::Begin("Inventories");
+  WL_TRACE_SCOPE_CAT("render", __FUNCTION__);
+
+  const bool IsVisible = ImGui::Begin("Inventories");
 
   if (ImGui::IsWindowAppearing())
     m_NeedUpdate = true;
 
+  // Collapsed or in a hidden tab, a refresh waits until it is shown
+  if (!IsVisible)
+  {
+    ImGui::End();
+    return;
+  }
+
   if (m_NeedUpdate)
   {
-    UpdateTable();
+    RefreshTable();
     m_NeedUpdate = false;
   }
 
+  m_Refresh.MarkVisible();
+
   if (ImGui::Button("Create"))
     OpenCreateWindow();
   RenderCreateWindow();
@@ -90,7 +96,6 @@ void InventoriesTableWindow::RenderCreateWindow()
           m_WarehouseId,
           m_Quantity
         );
-      UpdateTable();
       CloseCreateWindow();
     }
 
@@ -127,7 +132,6 @@ void InventoriesTableWindow::RenderDeleteWindow()
     if (ButtonCentered("OK"))
     {
       Delete(m_ProductId, m_WarehouseId);
-      UpdateTable();
       CloseDeleteWindow();
     }
 
@@ -206,22 +210,16 @@ void InventoriesTableWindow::RenderTable()
 
 void InventoriesTableWindow::UpdateTable()
 {
+  WL_TRACE_SCOPE_CAT("sql", __FUNCTION__);
+
+  // Superseded by this fetch
+  m_Refresh.Cancel();
+
   m_Table.clear();
 
   try
   {
-    auto * Result = m_UpdateStmt->executeQuery();
-    Result->next();
-
-    while (Result->status() == oci::ResultSet::DATA_AVAILABLE)
-    {
-      m_Table.emplace_back(
-          Result->getInt(1),
-          Result->getInt(2),
-          Result->getInt(3)
-        );
-      Result->next();
-    }
+    m_UpdateStmt.FetchInto(m_Table, &ReadRow);
   }
   catch (const oci::SQLException & ex)
   {
@@ -229,6 +227,45 @@ void InventoriesTableWindow::UpdateTable()
     OpenErrorWindow();
   }
 
+  OnTableLoaded();
+}
+
+void InventoriesTableWindow::RefreshTable()
+{
+  m_Refresh.Start<Table<int, int, int>>(
+      m_UpdateStmt,
+      &ReadRow,
+      [this](Table<int, int, int> _Rows)
+      {
+        SetTable(std::move(_Rows));
+      },
+      [this](const oci::SQLException & ex)
+      {
+        m_ErrorMessage = ex.what();
+        OpenErrorWindow();
+      }
+    );
+}
+
+void InventoriesTableWindow::SetTable(
+    Table<int, int, int> _Table
+  )
+{
+  m_Refresh.Cancel();
+  m_Table = std::move(_Table);
+  OnTableLoaded();
+  m_NeedUpdate = false;
+  TableChangedSignal.Emit();
+}
+
+void InventoriesTableWindow::OnTableLoaded()
+{
+  std::sort(m_Table.begin(), m_Table.end(), m_SortPredicate);
+
+  m_StockIndex.clear();
+  for (const auto & [ProductId, WarehouseId, Quantity] : m_Table)
+    m_StockIndex[ProductId][WarehouseId] = Quantity;
+
   if (!m_Table.empty())
   {
     Copy(std::get<0>(m_Table.front()), m_ProductId);
@@ -237,15 +274,33 @@ void InventoriesTableWindow::UpdateTable()
   }
 }
 
+std::tuple<int, int, int> InventoriesTableWindow::ReadRow(
+    oci::ResultSet * _Result
+  )
+{
+  return std::make_tuple(
+      _Result->getInt(1),
+      _Result->getInt(2),
+      _Result->getInt(3)
+    );
+}
+
+void InventoriesTableWindow::OnParentRowsDeleted()
+{
+  UpdateTable();
+  RowsDeletedSignal.Emit();
+  TableChangedSignal.Emit();
+}
+
 void InventoriesTableWindow::SortTable(
     int _ColIdx,
     ImGuiSortDirection _SortDir
   )
 {
-  std::sort(
-      m_Table.begin(), m_Table.end(),
-      PredicateImpl<decltype(m_Table)>{ _ColIdx, _SortDir }
-    );
+  WL_TRACE_SCOPE_CAT("sort", __FUNCTION__);
+
+  m_SortPredicate = { _ColIdx, _SortDir };
+  std::sort(m_Table.begin(), m_Table.end(), m_SortPredicate);
 }
 
 void InventoriesTableWindow::Create(
@@ -259,8 +314,10 @@ void InventoriesTableWindow::Create(
     m_CreateStmt->setInt(1, _ProductId);
     m_CreateStmt->setInt(2, _WarehouseId);
     m_CreateStmt->setInt(3, _Quantity);
-    m_CreateStmt->executeUpdate();
-    m_Conn->commit();
+    m_CreateStmt.ExecuteUpdate();
+    m_CreateStmt.Commit();
+    InsertSorted(m_Table, std::make_tuple(_ProductId, _WarehouseId, _Quantity), m_SortPredicate);
+    m_StockIndex[_ProductId][_WarehouseId] = _Quantity;
     TableChangedSignal.Emit();
   }
   catch (const oci::SQLException & ex)
@@ -279,8 +336,9 @@ void InventoriesTableWindow::Delete(
   {
     m_DeleteStmt->setInt(1, _ProductId);
     m_DeleteStmt->setInt(2, _WarehouseId);
-    m_DeleteStmt->executeUpdate();
-    m_Conn->commit();
+    m_DeleteStmt.ExecuteUpdate();
+    m_DeleteStmt.Commit();
+    EraseRow(_ProductId, _WarehouseId);
     TableChangedSignal.Emit();
   }
   catch (const oci::SQLException & ex)
@@ -290,29 +348,23 @@ void InventoriesTableWindow::Delete(
   }
 }
 
-void InventoriesTableWindow::Decrease(
+std::vector<StockAllocation> InventoriesTableWindow::PlanAllocation(
     const int _ProductId,
     const std::string & _CountryId,
     const int _Quantity
-  )
+  ) const
 {
   std::set<int> CountryWarehouses;
   for (const auto & [WarehouseId, WarehouseName, CountryId] : m_Warehouses->GetTable())
     if (CountryId == _CountryId)
       CountryWarehouses.insert(WarehouseId);
 
-  struct DecreaseEntry
-  {
-    int WarehouseId;
-    int Quantity;
-  };
-  std::vector<DecreaseEntry> ToDecrease;
-
-  for (const auto & [ProductId, WarehouseId, Quantity] : m_Table)
-    if (ProductId == _ProductId)
-      ToDecrease.emplace_back(DecreaseEntry{ WarehouseId, Quantity });
+  std::vector<StockAllocation> Stock;
+  for (const auto & [WarehouseId, Quantity] : GetStock(_ProductId))
+    if (Quantity > 0)
+      Stock.emplace_back(StockAllocation{ WarehouseId, Quantity });
 
-  std::sort(ToDecrease.begin(), ToDecrease.end(), [&](const DecreaseEntry & lhs, const DecreaseEntry & rhs){
+  std::sort(Stock.begin(), Stock.end(), [&](const StockAllocation & lhs, const StockAllocation & rhs){
       const bool IsInCountryL = CountryWarehouses.find(lhs.WarehouseId) != CountryWarehouses.end();
       const bool IsInCountryR = CountryWarehouses.find(rhs.WarehouseId) != CountryWarehouses.end();
 
@@ -325,40 +377,89 @@ void InventoriesTableWindow::Decrease(
       return lhs.WarehouseId < rhs.WarehouseId;
     });
 
+  std::vector<StockAllocation> Plan;
   int Left = _Quantity;
-  for (auto & Entry : ToDecrease)
+  for (const auto & Entry : Stock)
   {
-    if (Left > 0)
-    {
-      const int Available = Entry.Quantity;
-      Entry.Quantity = std::max(0, Available - Left);
-      Left = std::max(0, Left - Available);
-    }
-    else break;
+    if (Left <= 0)
+      break;
+
+    const int Take = std::min(Left, Entry.Quantity);
+    Plan.emplace_back(StockAllocation{ Entry.WarehouseId, Take });
+    Left -= Take;
   }
 
-  try
+  if (Left > 0)
+    Plan.clear();
+
+  return Plan;
+}
+
+void InventoriesTableWindow::ApplyRows(
+    const Table<int, int, int> & _Rows
+  )
+{
+  // O(n) per row, see TableOps.h. Checkouts patch a handful of rows.
+  for (const auto & [ProductId, WarehouseId, Quantity] : _Rows)
   {
-    for (const auto & Entry : ToDecrease)
+    auto It = std::find_if(m_Table.begin(), m_Table.end(), [&](const auto & _Row)
     {
-      m_DecreaseStmt->setInt(1, Entry.Quantity);
-      m_DecreaseStmt->setInt(2, _ProductId);
-      m_DecreaseStmt->setInt(3, Entry.WarehouseId);
-      m_DecreaseStmt->executeUpdate();
-    }
-    m_Conn->commit();
-    UpdateTable();
-    TableChangedSignal.Emit();
+      return std::get<0>(_Row) == ProductId && std::get<1>(_Row) == WarehouseId;
+    });
+
+    if (It != m_Table.end())
+      m_Table.erase(It);
+
+    InsertSorted(m_Table, std::make_tuple(ProductId, WarehouseId, Quantity), m_SortPredicate);
+    m_StockIndex[ProductId][WarehouseId] = Quantity;
   }
-  catch (const oci::SQLException & ex)
+
+  TableChangedSignal.Emit();
+}
+
+void InventoriesTableWindow::EraseRow(
+    const int _ProductId,
+    const int _WarehouseId
+  )
+{
+  const auto It = std::find_if(m_Table.begin(), m_Table.end(), [&](const auto & _Row)
   {
-    m_Conn->cancel();
-    m_ErrorMessage = ex.what();
-    OpenErrorWindow();
+    return std::get<0>(_Row) == _ProductId && std::get<1>(_Row) == _WarehouseId;
+  });
+
+  if (It != m_Table.end())
+    m_Table.erase(It);
+
+  const auto StockIt = m_StockIndex.find(_ProductId);
+  if (StockIt != m_StockIndex.end())
+  {
+    StockIt->second.erase(_WarehouseId);
+    if (StockIt->second.empty())
+      m_StockIndex.erase(StockIt);
   }
 }
 
 const Table<int, int, int> & InventoriesTableWindow::GetTable() const
 {
   return m_Table;
+}
+
+const std::map<int, int> & InventoriesTableWindow::GetStock(
+    const int _ProductId
+  ) const
+{
+  static const std::map<int, int> EMPTY_STOCK;
+
+  const auto It = m_StockIndex.find(_ProductId);
+  return It != m_StockIndex.end() ? It->second : EMPTY_STOCK;
+}
+
+int InventoriesTableWindow::GetAvailable(
+    const int _ProductId
+  ) const
+{
+  int Available = 0;
+  for (const auto & [WarehouseId, Quantity] : GetStock(_ProductId))
+    Available += Quantity;
+  return Available;
 }
\ No newline at end of file
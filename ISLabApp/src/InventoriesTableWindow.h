@@ -2,16 +2,26 @@
 
 #include "ISLabApp.h"
 #include "IWindow.h"
+#include "DBStatement.h"
+#include "IncrementalFetch.h"
 
 #include <imgui.h>
 #include <vector>
 #include <tuple>
 #include <functional>
+#include <map>
+#include <unordered_map>
 #include <signals/Connection.h>
 
 class WarehousesTableWindow;
 class ProductsTableWindow;
 
+struct StockAllocation
+{
+  int WarehouseId;
+  int Quantity;
+};
+
 class InventoriesTableWindow
   : public IWindow
 {
@@ -43,6 +53,19 @@ public:
   void RenderTable();
   void UpdateTable();
 
+  void SetTable(
+      Table<int, int, int> _Table
+    );
+
+  static constexpr const char * TABLE_NAME = "inventories";
+  static constexpr const char * UPDATE_QUERY = "SELECT product_id, warehouse_id, quantity FROM inventories";
+
+  static std::tuple<int, int, int> ReadRow(
+      oci::ResultSet * _Result
+    );
+
+  void OnParentRowsDeleted();
+
   void SortTable(
       int _ColIdx,
       ImGuiSortDirection _SortDir
@@ -59,27 +82,54 @@ public:
       const int _WarehouseId
     );
 
-  void Decrease(
+  // Splits _Quantity items of the product over warehouses, the customer's country first, then the fullest.
+  // Returns an empty plan if the known stock is insufficient.
+  std::vector<StockAllocation> PlanAllocation(
       const int _ProductId,
       const std::string & _CountryId,
       const int _Quantity
+    ) const;
+
+  // Replaces quantities of the given (product, warehouse) rows without reloading the table
+  void ApplyRows(
+      const Table<int, int, int> & _Rows
+    );
+
+  void EraseRow(
+      const int _ProductId,
+      const int _WarehouseId
     );
 
   const Table<int, int, int> & GetTable() const;
 
+  // Quantities of the product per warehouse
+  const std::map<int, int> & GetStock(
+      const int _ProductId
+    ) const;
+
+  int GetAvailable(
+      const int _ProductId
+    ) const;
+
 public:
 
   sig::CSignal<> TableChangedSignal;
+  sig::CSignal<> RowsDeletedSignal;
 
 private:
 
+  void OnTableLoaded();
+  // Fetches the table a slice per frame and hands it to SetTable
+  void RefreshTable();
+
   oci::Environment * m_Env = nullptr;
   oci::Connection * m_Conn = nullptr;
 
-  oci::Statement * m_CreateStmt = nullptr;
-  oci::Statement * m_DeleteStmt = nullptr;
-  oci::Statement * m_DecreaseStmt = nullptr;
-  oci::Statement * m_UpdateStmt = nullptr;
+  DBStatement m_CreateStmt;
+  DBStatement m_DeleteStmt;
+  DBStatement m_UpdateStmt;
+  // Reads m_UpdateStmt, declared after it so it is closed first
+  IncrementalFetch m_Refresh;
 
   int m_ProductId = 0;
   int m_WarehouseId = 0;
@@ -93,6 +143,8 @@ private:
   std::string m_ErrorMessage;
 
   Table<int, int, int> m_Table;
+  PredicateImpl<int, int, int> m_SortPredicate{ 0, ImGuiSortDirection_Ascending };
+  std::unordered_map<int, std::map<int, int>> m_StockIndex;
   WarehousesTableWindow * m_Warehouses = nullptr;
   ProductsTableWindow * m_Products = nullptr;
   sig::CMultiConnection m_SignalConnections;
@@ -11,6 +11,18 @@
 #include <algorithm>
 #include <map>
 #include <set>
+#include <cstdio>
+
+namespace
+{
+
+constexpr float PRODUCT_CARD_HEIGHT = 300.0f;
+
+constexpr const char * PRODUCT_IMAGES_DIRECTORY = "product_images";
+constexpr int THUMBNAIL_SIZE = 192;
+constexpr std::size_t THUMBNAIL_BUDGET_BYTES = 64 * 1024 * 1024;
+
+} // namespace
 
 MakeOrderWindow::MakeOrderWindow(
     oci::Environment * _Env,
@@ -29,38 +41,86 @@ MakeOrderWindow::MakeOrderWindow(
     m_Categories{ _Categories },
     m_Orders{ _Orders },
     m_Inventories{ _Inventories },
-    m_Warehouses{ _Warehouses }
+    m_Warehouses{ _Warehouses },
+    m_Thumbnails(PRODUCT_IMAGES_DIRECTORY, THUMBNAIL_SIZE, THUMBNAIL_BUDGET_BYTES)
 {
-  m_MakeOrderStmt = m_Conn->createStatement("SELECT * FROM inventories");
-
-  m_SignalConnections.AddConnection(m_Products->TableChangedSignal, this, &MakeOrderWindow::UpdateData);
-  m_SignalConnections.AddConnection(m_Customers->TableChangedSignal, this, &MakeOrderWindow::UpdateData);
-  m_SignalConnections.AddConnection(m_Categories->TableChangedSignal, this, &MakeOrderWindow::UpdateData);
-  m_SignalConnections.AddConnection(m_Orders->TableChangedSignal, this, &MakeOrderWindow::UpdateData);
-  m_SignalConnections.AddConnection(m_Inventories->TableChangedSignal, this, &MakeOrderWindow::UpdateData);
-  m_SignalConnections.AddConnection(m_Warehouses->TableChangedSignal, this, &MakeOrderWindow::UpdateData);
+  m_PlaceOrderStmt = DBStatement(m_Conn, "BEGIN place_order(:1, :2, :3, :4, :5, :6, :7); END;");
+  m_PlaceOrderStmt->registerOutParam(5, oci::OCCIINT);
+  m_PlaceOrderStmt->registerOutParam(6, oci::OCCIDATE);
+  m_PlaceOrderStmt->registerOutParam(7, oci::OCCICURSOR);
+  // The procedure is a single transaction, commit it in the same round trip
+  m_PlaceOrderStmt->setAutoCommit(true);
+
+  // One round trip for the whole cart. The decrements are checked on the server and the block
+  // returns the resulting stock and the ids of the new orders, so nothing is derived from local data.
+  m_CheckoutStmt = DBStatement(
+      m_Conn,
+      "DECLARE "
+      "  OrderDate DATE := SYSDATE; "
+      "BEGIN "
+      "  SAVEPOINT checkout; "
+      "  FORALL i IN 1 .. :1 "
+      "    UPDATE inventories SET quantity = quantity - :2(i) "
+      "    WHERE product_id = :3(i) AND warehouse_id = :4(i) AND quantity >= :2(i) "
+      "    RETURNING quantity BULK COLLECT INTO :5; "
+      "  IF SQL%ROWCOUNT < :1 THEN "
+      "    ROLLBACK TO checkout; "
+      "    :6 := 0; "
+      "    RETURN; "
+      "  END IF; "
+      "  FORALL i IN 1 .. :7 "
+      "    INSERT INTO orders(customer_id, status, order_date, product_id, quantity) "
+      "    VALUES(:8, :9, OrderDate, :10(i), :11(i)) "
+      "    RETURNING order_id BULK COLLECT INTO :12; "
+      "  COMMIT; "
+      "  :6 := 1; "
+      "  :13 := OrderDate; "
+      "END;"
+    );
+  m_CheckoutStmt->registerOutParam(6, oci::OCCIINT);
+  m_CheckoutStmt->registerOutParam(13, oci::OCCIDATE);
+
+  m_SignalConnections.AddConnection(m_Products->TableChangedSignal, this, &MakeOrderWindow::OnTableChanged);
+  m_SignalConnections.AddConnection(m_Customers->TableChangedSignal, this, &MakeOrderWindow::OnTableChanged);
+  m_SignalConnections.AddConnection(m_Categories->TableChangedSignal, this, &MakeOrderWindow::OnTableChanged);
+  m_SignalConnections.AddConnection(m_Orders->TableChangedSignal, this, &MakeOrderWindow::OnTableChanged);
+  m_SignalConnections.AddConnection(m_Inventories->TableChangedSignal, this, &MakeOrderWindow::OnTableChanged);
+  m_SignalConnections.AddConnection(m_Warehouses->TableChangedSignal, this, &MakeOrderWindow::OnTableChanged);
 }
 
 MakeOrderWindow::~MakeOrderWindow()
 {
-  m_Conn->terminateStatement(m_MakeOrderStmt);
-
   m_SignalConnections.Disconnect();
 }
 
 void MakeOrderWindow::OnUIRender()
 {
-  ImGui::Begin("Make order");
+  WL_TRACE_SCOPE_CAT("render", __FUNCTION__);
+
+  const bool IsVisible = ImGui::Begin("Make order");
 
   if (ImGui::IsWindowAppearing())
     m_NeedUpdate = true;
 
+  // Table changes are only marked while hidden, see OnTableChanged
+  if (!IsVisible)
+  {
+    ImGui::End();
+    return;
+  }
+
+  m_ProductRows = m_Products->GetSnapshot();
+  m_CustomerRows = m_Customers->GetSnapshot();
+  m_WarehouseRows = m_Warehouses->GetSnapshot();
+
   if (m_NeedUpdate)
   {
     UpdateData();
     m_NeedUpdate = false;
   }
 
+  m_Thumbnails.Update();
+
   if (m_CustomerData.has_value())
     RenderProductsWindow();
   else
@@ -68,6 +128,11 @@ void MakeOrderWindow::OnUIRender()
 
   RenderErrorWindow();
   ImGui::End();
+
+  // Released for the rest of the frame, the owners edit their tables in place while no one holds them
+  m_ProductRows.reset();
+  m_CustomerRows.reset();
+  m_WarehouseRows.reset();
 }
 
 void MakeOrderWindow::OpenErrorWindow(
@@ -100,15 +165,280 @@ void MakeOrderWindow::CloseErrorWindow()
   m_IsError = false;
 }
 
+void MakeOrderWindow::OnTableChanged()
+{
+  m_NeedUpdate = true;
+}
+
 void MakeOrderWindow::UpdateData()
 {
+  WL_TRACE_SCOPE_CAT("app", __FUNCTION__);
+
   m_ProductQuantitiesCache.clear();
 }
 
+void MakeOrderWindow::PlaceOrder(
+    int _ProductId,
+    int _Quantity
+  )
+{
+  WL_TRACE_SCOPE_CAT("sql", __FUNCTION__);
+
+  try
+  {
+    m_PlaceOrderStmt->setInt(1, m_CustomerData->ID);
+    m_PlaceOrderStmt->setInt(2, _ProductId);
+    m_PlaceOrderStmt->setInt(3, _Quantity);
+    m_PlaceOrderStmt->setString(4, ORDER_STATUS_TO_STRING.at(EOrderStatus::CREATED));
+    m_PlaceOrderStmt.ExecuteUpdate();
+
+    const int OrderId = m_PlaceOrderStmt->getInt(5);
+    const oci::Date OrderDate = m_PlaceOrderStmt->getDate(6);
+
+    Table<int, int, int> ChangedInventories;
+    auto Cursor = m_PlaceOrderStmt.GetCursor(7);
+    m_PlaceOrderStmt.FetchInto(Cursor, ChangedInventories, [](oci::ResultSet * _Result)
+    {
+      return std::make_tuple(_Result->getInt(1), _Result->getInt(2), _Result->getInt(3));
+    });
+
+    m_Orders->AddRow(OrderId, m_CustomerData->ID, EOrderStatus::CREATED, OrderDate, _ProductId, static_cast<float>(_Quantity));
+    m_Inventories->ApplyRows(ChangedInventories);
+  }
+  catch (const oci::SQLException & ex)
+  {
+    m_PlaceOrderStmt.Rollback();
+    OpenErrorWindow(ex.what());
+  }
+}
+
+void MakeOrderWindow::AddToCart(
+    int _ProductId,
+    int _Quantity
+  )
+{
+  auto & InCart = m_Cart[_ProductId];
+  if (InCart + _Quantity > m_Inventories->GetAvailable(_ProductId))
+  {
+    if (InCart == 0)
+      m_Cart.erase(_ProductId);
+    return OpenErrorWindow("Not enough items in stock");
+  }
+
+  InCart += _Quantity;
+  m_ProductQuantitiesCache[_ProductId] = 0;
+}
+
+void MakeOrderWindow::RenderCart()
+{
+  char Header[64] = {};
+  std::snprintf(Header, sizeof(Header), "Cart (%d)###Cart", static_cast<int>(m_Cart.size()));
+  if (!ImGui::CollapsingHeader(Header))
+    return;
+
+  std::unordered_map<int, std::pair<const std::string *, float>> CartProducts;
+  for (const auto & [ID, Name, Cost, Price, Category] : *m_ProductRows)
+    if (m_Cart.find(ID) != m_Cart.end())
+      CartProducts.emplace(ID, std::make_pair(&Name, Price));
+
+  constexpr auto TableFlags = ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY | ImGuiTableFlags_SizingStretchProp;
+
+  float Total = 0.0f;
+  int RemovedProductId = -1;
+  bool IsOutOfStock = false;
+  if (ImGui::BeginTable("CartTable", 4, TableFlags, ImVec2(-1, 200)))
+  {
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn("Product");
+    ImGui::TableSetupColumn("Quantity");
+    ImGui::TableSetupColumn("Sum");
+    ImGui::TableSetupColumn("");
+    ImGui::TableHeadersRow();
+
+    for (auto & [ProductId, Quantity] : m_Cart)
+    {
+      const auto It = CartProducts.find(ProductId);
+      const float Price = It != CartProducts.end() ? It->second.second : 0.0f;
+      Total += Price * Quantity;
+
+      ImGui::PushID(ProductId);
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(It != CartProducts.end() ? It->second.first->c_str() : "<removed>");
+      ImGui::TableNextColumn();
+      // Sold out since it was added, the line has to be removed before checkout
+      const int Available = m_Inventories->GetAvailable(ProductId);
+      if (Available <= 0)
+      {
+        ImGui::TextDisabled("Out of stock");
+        IsOutOfStock = true;
+      }
+      else
+      {
+        ImGui::SetNextItemWidth(-1);
+        if (ImGui::InputInt("##CartQuantity", &Quantity))
+          Quantity = std::clamp(Quantity, 1, Available);
+      }
+      ImGui::TableNextColumn();
+      ImGui::Text("%.2f", Price * Quantity);
+      ImGui::TableNextColumn();
+      if (ImGui::SmallButton("Remove"))
+        RemovedProductId = ProductId;
+      ImGui::PopID();
+    }
+
+    ImGui::EndTable();
+  }
+
+  if (RemovedProductId != -1)
+    m_Cart.erase(RemovedProductId);
+
+  ImGui::Text("Total: %.2f", Total);
+  ImGui::SameLine();
+  ImGui::BeginDisabled(m_Cart.empty() || IsOutOfStock);
+  if (ImGui::Button("Checkout"))
+    Checkout();
+  ImGui::EndDisabled();
+  ImGui::SameLine();
+  ImGui::BeginDisabled(m_Cart.empty());
+  if (ImGui::Button("Clear"))
+    m_Cart.clear();
+  ImGui::EndDisabled();
+
+  ImGui::Separator();
+}
+
+void MakeOrderWindow::Checkout()
+{
+  WL_TRACE_SCOPE_CAT("sql", __FUNCTION__);
+
+  // Decrements of every line, planned against the local stock index and checked again by the server
+  std::vector<int> DecreaseQuantities;
+  std::vector<int> DecreaseProductIds;
+  std::vector<int> DecreaseWarehouseIds;
+
+  for (const auto & [ProductId, Quantity] : m_Cart)
+  {
+    const auto Plan = m_Inventories->PlanAllocation(ProductId, m_CustomerData->CountryID, Quantity);
+    if (Plan.empty())
+      return OpenErrorWindow("Not enough items in stock");
+
+    for (const auto & Entry : Plan)
+    {
+      DecreaseQuantities.push_back(Entry.Quantity);
+      DecreaseProductIds.push_back(ProductId);
+      DecreaseWarehouseIds.push_back(Entry.WarehouseId);
+    }
+  }
+
+  const auto DecreaseCount = static_cast<unsigned int>(DecreaseQuantities.size());
+  const auto LineCount = static_cast<unsigned int>(m_Cart.size());
+
+  std::vector<int> OrderProductIds;
+  std::vector<float> OrderQuantities;
+  for (const auto & [ProductId, Quantity] : m_Cart)
+  {
+    OrderProductIds.push_back(ProductId);
+    OrderQuantities.push_back(static_cast<float>(Quantity));
+  }
+
+  std::vector<int> NewStock(DecreaseCount);
+  std::vector<int> NewOrderIds(LineCount);
+
+  // Current element counts of the PL/SQL array binds, the out binds get the count returned
+  unsigned int DecreaseQuantityCount = DecreaseCount;
+  unsigned int DecreaseProductCount = DecreaseCount;
+  unsigned int DecreaseWarehouseCount = DecreaseCount;
+  unsigned int NewStockCount = 0;
+  unsigned int OrderProductCount = LineCount;
+  unsigned int OrderQuantityCount = LineCount;
+  unsigned int NewOrderIdCount = 0;
+
+  std::vector<unsigned short> IntLengths(std::max(DecreaseCount, LineCount), sizeof(int));
+  std::vector<unsigned short> NewStockLengths(DecreaseCount, sizeof(int));
+  std::vector<unsigned short> NewOrderIdLengths(LineCount, sizeof(int));
+  std::vector<unsigned short> FloatLengths(LineCount, sizeof(float));
+
+  oci::Date OrderDate;
+  try
+  {
+    m_CheckoutStmt->setInt(1, static_cast<int>(DecreaseCount));
+    m_CheckoutStmt->setDataBufferArray(2, DecreaseQuantities.data(), oci::OCCIINT, DecreaseCount, &DecreaseQuantityCount, sizeof(int), IntLengths.data());
+    m_CheckoutStmt->setDataBufferArray(3, DecreaseProductIds.data(), oci::OCCIINT, DecreaseCount, &DecreaseProductCount, sizeof(int), IntLengths.data());
+    m_CheckoutStmt->setDataBufferArray(4, DecreaseWarehouseIds.data(), oci::OCCIINT, DecreaseCount, &DecreaseWarehouseCount, sizeof(int), IntLengths.data());
+    m_CheckoutStmt->setDataBufferArray(5, NewStock.data(), oci::OCCIINT, DecreaseCount, &NewStockCount, sizeof(int), NewStockLengths.data());
+    m_CheckoutStmt->setInt(7, static_cast<int>(LineCount));
+    m_CheckoutStmt->setInt(8, m_CustomerData->ID);
+    m_CheckoutStmt->setString(9, ORDER_STATUS_TO_STRING.at(EOrderStatus::CREATED));
+    m_CheckoutStmt->setDataBufferArray(10, OrderProductIds.data(), oci::OCCIINT, LineCount, &OrderProductCount, sizeof(int), IntLengths.data());
+    m_CheckoutStmt->setDataBufferArray(11, OrderQuantities.data(), oci::OCCIFLOAT, LineCount, &OrderQuantityCount, sizeof(float), FloatLengths.data());
+    m_CheckoutStmt->setDataBufferArray(12, NewOrderIds.data(), oci::OCCIINT, LineCount, &NewOrderIdCount, sizeof(int), NewOrderIdLengths.data());
+    m_CheckoutStmt.ExecuteUpdate();
+
+    if (m_CheckoutStmt->getInt(6) == 0)
+    {
+      m_Inventories->UpdateTable();
+      m_Inventories->TableChangedSignal.Emit();
+      return OpenErrorWindow("Stock has changed since it was loaded, please review the cart");
+    }
+
+    OrderDate = m_CheckoutStmt->getDate(13);
+  }
+  catch (const oci::SQLException & ex)
+  {
+    m_CheckoutStmt.Rollback();
+    return OpenErrorWindow(ex.what());
+  }
+
+  // Every decrement updated exactly one row, so the returned quantities are in the order of the binds
+  Table<int, int, int> ChangedInventories;
+  for (unsigned int i = 0; i < NewStockCount; ++i)
+    ChangedInventories.emplace_back(DecreaseProductIds[i], DecreaseWarehouseIds[i], NewStock[i]);
+
+  Table<int, int, EOrderStatus, oci::Date, int, float> NewOrders;
+  for (unsigned int i = 0; i < NewOrderIdCount; ++i)
+    NewOrders.emplace_back(NewOrderIds[i], m_CustomerData->ID, EOrderStatus::CREATED, OrderDate, OrderProductIds[i], OrderQuantities[i]);
+
+  m_Cart.clear();
+  m_Orders->AddRows(NewOrders);
+  m_Inventories->ApplyRows(ChangedInventories);
+}
+
+void MakeOrderWindow::RenderThumbnail(
+    const int _ProductID
+  )
+{
+  const ImVec2 Origin = ImGui::GetCursorScreenPos();
+  const ImVec2 Size(THUMBNAIL_SIZE, THUMBNAIL_SIZE);
+
+  const auto Image = m_Thumbnails.Get(_ProductID);
+  if (!Image)
+  {
+    auto * DrawList = ImGui::GetWindowDrawList();
+    DrawList->AddRectFilled(Origin, ImVec2(Origin.x + Size.x, Origin.y + Size.y), ImGui::GetColorU32(ImGuiCol_TextDisabled));
+
+    const char * Label = m_Thumbnails.IsMissing(_ProductID) ? "No image" : "Loading...";
+    const ImVec2 LabelSize = ImGui::CalcTextSize(Label);
+    DrawList->AddText(
+        ImVec2(Origin.x + (Size.x - LabelSize.x) / 2, Origin.y + (Size.y - LabelSize.y) / 2),
+        ImGui::GetColorU32(ImGuiCol_Text),
+        Label
+      );
+
+    ImGui::Dummy(Size);
+    return;
+  }
+
+  // Centered in the square, keeping the aspect ratio of the picture
+  const float Scale = std::min(Size.x / Image->Size.x, Size.y / Image->Size.y);
+  const ImVec2 ImageSize(Image->Size.x * Scale, Image->Size.y * Scale);
+  ImGui::SetCursorScreenPos(ImVec2(Origin.x + (Size.x - ImageSize.x) / 2, Origin.y + (Size.y - ImageSize.y) / 2));
+  ImGui::Image(Image->Texture, ImageSize, Image->UV0, Image->UV1);
+}
+
 void MakeOrderWindow::RenderProductEntry(
     const int _ProductID,
     const std::string & _ProductName,
-    const std::string & _Description,
     const float _Cost,
     const float _Price,
     const int _CategoryID
@@ -121,10 +451,15 @@ void MakeOrderWindow::RenderProductEntry(
   ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.57f, 0.68f, 0.77f, 1.0f));
   ImGui::PushStyleColor(ImGuiCol_ButtonActive, ImVec4(0.37f, 0.71f, 0.97f, 1.0f));
 
-  ImGui::BeginChild(_ProductID, ImVec2(-1, 300), true);
+  ImGui::BeginChild(_ProductID, ImVec2(-1, PRODUCT_CARD_HEIGHT), true);
   const auto WindowPadding = ImGui::GetStyle().WindowPadding;
   ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0, 0));
 
+  ImGui::BeginChild("ThumbnailBlock", ImVec2(THUMBNAIL_SIZE, -1));
+  RenderThumbnail(_ProductID);
+  ImGui::EndChild();
+  ImGui::SameLine();
+
   ImGui::BeginChild("DescriptionBlock", ImVec2(-200, -1));
 
   ImGui::PushFont(GetFontL());
@@ -133,26 +468,29 @@ void MakeOrderWindow::RenderProductEntry(
   ImGui::PushFont(GetFontS());
   ImGui::TextDisabled(m_Categories->GetCategoryName(_CategoryID).data());
   ImGui::PopFont();
-  ImGui::TextUnformatted(_Description.c_str());
+  if (const auto * Description = m_Products->GetDescription(_ProductID))
+    ImGui::TextUnformatted(Description->c_str());
+  else
+    ImGui::TextDisabled("Loading description...");
 
   std::set<int> Warehouses;
-  for (const auto & [WarehouseId, WarehouseName, CountryId] : m_Warehouses->GetTable())
+  for (const auto & [WarehouseId, WarehouseName, CountryId] : *m_WarehouseRows)
     if (m_CustomerData->CountryID == CountryId)
       Warehouses.insert(WarehouseId);
 
   int AvailableCount = 0;
   int FastDeliveryThreshold = 0;
-  for (const auto & [ProductId, WarehouseId, Quantity] : m_Inventories->GetTable())
+  for (const auto & [WarehouseId, Quantity] : m_Inventories->GetStock(_ProductID))
   {
-    if (ProductId != _ProductID)
-      continue;
-
     AvailableCount += Quantity;
 
     if (Warehouses.find(WarehouseId) != Warehouses.end())
       FastDeliveryThreshold += Quantity;
   }
 
+  const auto CartIt = m_Cart.find(_ProductID);
+  const int InCart = CartIt != m_Cart.end() ? CartIt->second : 0;
+
   ImGui::TextDisabled("\nAvailable: %d\nFast delivery up to %d items", AvailableCount, FastDeliveryThreshold);
 
   ImGui::EndChild();
@@ -164,13 +502,17 @@ void MakeOrderWindow::RenderProductEntry(
   ImGui::Text("%.2f", _Price * std::max(1, q));
   ImGui::SetNextItemWidth(200 - WindowPadding.x);
   ImGui::InputInt("##Quantity", &q);
-  m_ProductQuantitiesCache[_ProductID] = q = std::clamp(q, 0, AvailableCount);
+  // The cart may hold more than is left once stock is reloaded, nothing more can be added then
+  m_ProductQuantitiesCache[_ProductID] = q = std::clamp(q, 0, std::max(0, AvailableCount - InCart));
   ImGui::PushStyleColor(ImGuiCol_Text, 0xFFFFFFFF);
   ImGui::BeginDisabled(q < 1);
+  if (ImGui::Button("Add to cart", ImVec2(-1, 0)))
+  {
+    AddToCart(_ProductID, q);
+  }
   if (ImGui::Button("Buy", ImVec2(-1, -1)))
   {
-    m_Orders->Create(m_CustomerData->ID, EOrderStatus::CREATED, oci::Date::getSystemDate(m_Env), _ProductID, q);
-    m_Inventories->Decrease(_ProductID, m_CustomerData->CountryID, q);
+    PlaceOrder(_ProductID, q);
   }
   ImGui::EndDisabled();
   ImGui::PopStyleColor();
@@ -196,14 +538,28 @@ void MakeOrderWindow::RenderProductsWindow()
     );
 
   if (ImGui::Button("logout"))
+  {
+    m_Cart.clear();
     return m_CustomerData.reset();
+  }
 
   ImGui::Separator();
 
+  RenderCart();
+
   ImGui::BeginChild("ProductsList", ImVec2(-1, -1), true);
 
-  for (const auto & [ID, Name, Description, Cost, Price, Category] : m_Products->GetTable())
-    RenderProductEntry(ID, Name, Description, Cost, Price, Category);
+  for (const auto & [ID, Name, Cost, Price, Category] : *m_ProductRows)
+  {
+    // Cards out of view only reserve their space, so their descriptions and images are never requested
+    if (!ImGui::IsRectVisible(ImVec2(ImGui::GetContentRegionAvail().x, PRODUCT_CARD_HEIGHT)))
+    {
+      ImGui::Dummy(ImVec2(0, PRODUCT_CARD_HEIGHT));
+      continue;
+    }
+
+    RenderProductEntry(ID, Name, Cost, Price, Category);
+  }
 
   ImGui::EndChild();
 }
@@ -223,7 +579,7 @@ void MakeOrderWindow::RenderLoginWindow()
 
   if (ImGui::Button("Log in") || Accept)
   {
-    for (const auto & [Id, FirstName, LastName, Address, Email, Country] : m_Customers->GetTable())
+    for (const auto & [Id, FirstName, LastName, Address, Email, Country] : *m_CustomerRows)
     {
       if (FirstName != m_FirstNameBuffer.data() ||
           LastName != m_LastNameBuffer.data() ||
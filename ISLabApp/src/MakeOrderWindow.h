@@ -2,6 +2,9 @@
 
 #include "ISLabApp.h"
 #include "IWindow.h"
+#include "DBStatement.h"
+#include "ThumbnailCache.h"
+#include "SnapshotCell.h"
 
 #include <imgui.h>
 #include <vector>
@@ -9,6 +12,7 @@
 #include <functional>
 #include <signals/Connection.h>
 #include <optional>
+#include <map>
 
 class ProductsTableWindow;
 class CustomersTableWindow;
@@ -54,11 +58,27 @@ public:
   void CloseErrorWindow();
 
   void UpdateData();
+  // Defers UpdateData to the next frame the window is visible, any number of changes rebuild it once
+  void OnTableChanged();
 
+  void PlaceOrder(
+      int _ProductId,
+      int _Quantity
+    );
+
+  void AddToCart(
+      int _ProductId,
+      int _Quantity
+    );
+  void RenderCart();
+  void Checkout();
+
+  void RenderThumbnail(
+      const int _ProductID
+    );
   void RenderProductEntry(
       const int _ProductID,
       const std::string & _ProductName,
-      const std::string & _Description,
       const float _Cost,
       const float _Price,
       const int _CategoryID
@@ -71,7 +91,8 @@ private:
   oci::Environment * m_Env = nullptr;
   oci::Connection * m_Conn = nullptr;
 
-  oci::Statement * m_MakeOrderStmt = nullptr;
+  DBStatement m_PlaceOrderStmt;
+  DBStatement m_CheckoutStmt;
 
   bool m_IsError = false;
   bool m_NeedUpdate = true;
@@ -85,6 +106,11 @@ private:
   InventoriesTableWindow * m_Inventories = nullptr;
   WarehousesTableWindow * m_Warehouses = nullptr;
 
+  // One version of each table for the whole frame, pinned during OnUIRender only
+  Snapshot<Table<int, std::string, float, float, int>> m_ProductRows;
+  Snapshot<Table<int, std::string, std::string, std::string, std::string, std::string>> m_CustomerRows;
+  Snapshot<Table<int, std::string, std::string>> m_WarehouseRows;
+
   sig::CMultiConnection m_SignalConnections;
 
   std::vector<char> m_FirstNameBuffer = std::vector<char>(255 + 1, '\0');
@@ -92,4 +118,6 @@ private:
   std::vector<char> m_EmailBuffer = std::vector<char>(255 + 1, '\0');
   std::optional<CustomerData> m_CustomerData;
   std::unordered_map<int, int> m_ProductQuantitiesCache;
+  std::map<int, int> m_Cart;
+  ThumbnailCache m_Thumbnails;
 };
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(
+    const std::string & _Path
+  )
+{
+#ifdef _WIN32
+  m_File = CreateFileA(_Path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (m_File == INVALID_HANDLE_VALUE)
+  {
+    m_File = nullptr;
+    return;
+  }
+
+  LARGE_INTEGER Size{};
+  if (!GetFileSizeEx(m_File, &Size) || Size.QuadPart == 0)
+  {
+    Close();
+    return;
+  }
+
+  m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!m_Mapping)
+  {
+    Close();
+    return;
+  }
+
+  m_Data = static_cast<const char *>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+  m_Size = m_Data ? static_cast<std::size_t>(Size.QuadPart) : 0;
+#else
+  m_File = open(_Path.c_str(), O_RDONLY);
+  if (m_File < 0)
+    return;
+
+  struct stat Stat{};
+  if (fstat(m_File, &Stat) != 0 || Stat.st_size == 0)
+  {
+    Close();
+    return;
+  }
+
+  void * Data = mmap(nullptr, static_cast<std::size_t>(Stat.st_size), PROT_READ, MAP_PRIVATE, m_File, 0);
+  if (Data == MAP_FAILED)
+  {
+    Close();
+    return;
+  }
+
+  m_Data = static_cast<const char *>(Data);
+  m_Size = static_cast<std::size_t>(Stat.st_size);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+  Close();
+}
+
+bool MappedFile::IsOpen() const
+{
+  return m_Data != nullptr;
+}
+
+const char * MappedFile::GetData() const
+{
+  return m_Data;
+}
+
+std::size_t MappedFile::GetSize() const
+{
+  return m_Size;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+  if (m_Data)
+    UnmapViewOfFile(m_Data);
+  if (m_Mapping)
+    CloseHandle(m_Mapping);
+  if (m_File)
+    CloseHandle(m_File);
+  m_Mapping = nullptr;
+  m_File = nullptr;
+#else
+  if (m_Data)
+    munmap(const_cast<char *>(m_Data), m_Size);
+  if (m_File >= 0)
+    close(m_File);
+  m_File = -1;
+#endif
+
+  m_Data = nullptr;
+  m_Size = 0;
+}
\ No newline at end of file
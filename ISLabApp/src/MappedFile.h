@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+
+  explicit MappedFile(
+      const std::string & _Path
+    );
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile & operator=(const MappedFile &) = delete;
+
+  bool IsOpen() const;
+
+  const char * GetData() const;
+  std::size_t GetSize() const;
+
+  void Close();
+
+private:
+
+  const char * m_Data = nullptr;
+  std::size_t m_Size = 0;
+
+#ifdef _WIN32
+  void * m_File = nullptr;
+  void * m_Mapping = nullptr;
+#else
+  int m_File = -1;
+#endif
+};
\ No newline at end of file
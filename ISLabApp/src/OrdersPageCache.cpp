@@ -0,0 +1,249 @@
+#include "OrdersPageCache.h"
+
+#include "QueryBuilder.h"
+
+#include <algorithm>
+
+namespace
+{
+
+constexpr int QUANTITY_COLUMN = 5;
+
+const std::string SELECT_ORDERS = "SELECT order_id, customer_id, status, order_date, product_id, quantity FROM orders ";
+
+} // namespace
+
+OrdersPageCache::OrdersPageCache(
+    oci::Connection * _Conn
+  ) :
+    m_Conn{ _Conn }
+{
+  m_EstimateStmt = DBStatement(m_Conn, "SELECT NVL(num_rows, 0) FROM user_tables WHERE table_name = 'ORDERS'");
+  Prepare();
+}
+
+void OrdersPageCache::SetSort(
+    int _ColIdx,
+    ImGuiSortDirection _SortDir
+  )
+{
+  if (_ColIdx == m_SortColumn && _SortDir == m_SortDir)
+    return;
+
+  m_SortColumn = std::clamp(_ColIdx, 0, static_cast<int>(ORDERS_SORT_COLUMNS.size()) - 1);
+  m_SortDir = _SortDir;
+
+  Prepare();
+  Invalidate();
+}
+
+void OrdersPageCache::Invalidate()
+{
+  m_Pages.clear();
+  m_Lru.clear();
+  m_Boundaries.clear();
+  m_IsSuspended = false;
+
+  RefreshEstimate();
+}
+
+void OrdersPageCache::Clear()
+{
+  m_Pages.clear();
+  m_Lru.clear();
+  m_Boundaries.clear();
+  m_RowCount = 0;
+  m_IsExactCount = false;
+}
+
+int OrdersPageCache::GetRowCount() const
+{
+  return m_RowCount;
+}
+
+bool OrdersPageCache::IsExactCount() const
+{
+  return m_IsExactCount;
+}
+
+std::size_t OrdersPageCache::GetCachedPageCount() const
+{
+  return m_Pages.size();
+}
+
+const OrdersPageCache::Row * OrdersPageCache::GetRow(
+    int _Index
+  )
+{
+  if (_Index < 0 || _Index >= m_RowCount)
+    return nullptr;
+
+  const int PageIdx = _Index / PAGE_SIZE;
+  auto It = m_Pages.find(PageIdx);
+
+  Page * Found = nullptr;
+  if (It != m_Pages.end())
+  {
+    Found = &It->second;
+    m_Lru.splice(m_Lru.begin(), m_Lru, Found->LruIt);
+  }
+  else
+  {
+    // A failed fetch is reported once, paging resumes after the next invalidation
+    if (m_IsSuspended)
+      return nullptr;
+
+    try
+    {
+      Found = &LoadPage(PageIdx);
+    }
+    catch (const oci::SQLException &)
+    {
+      m_IsSuspended = true;
+      throw;
+    }
+  }
+
+  const auto RowIdx = static_cast<std::size_t>(_Index % PAGE_SIZE);
+  return RowIdx < Found->Rows.size() ? &Found->Rows[RowIdx] : nullptr;
+}
+
+void OrdersPageCache::Prepare()
+{
+  if (!m_Conn)
+    return;
+
+  const bool IsAscending = m_SortDir != ImGuiSortDirection_Descending;
+  const std::string & Column = ORDERS_SORT_COLUMNS[m_SortColumn];
+  const std::string Direction = IsAscending ? " ASC" : " DESC";
+  const std::string Compare = IsAscending ? " > " : " < ";
+
+  std::string OrderBy = " ORDER BY " + Column + Direction;
+  if (m_SortColumn != 0)
+    OrderBy += ", order_id" + Direction;
+
+  const std::string FetchFirst = " FETCH FIRST " + std::to_string(PAGE_SIZE) + " ROWS ONLY";
+
+  // Oracle has no row value comparison, (key, order_id) > (:k, :id) is spelled out
+  std::string Seek;
+  if (m_SortColumn == 0)
+    Seek = "WHERE order_id" + Compare + ":1";
+  else
+    Seek = "WHERE " + Column + Compare + ":1 OR (" + Column + " = :2 AND order_id" + Compare + ":3)";
+
+  m_FirstPageStmt = DBStatement(m_Conn, SELECT_ORDERS + OrderBy + FetchFirst);
+  m_KeysetStmt = DBStatement(m_Conn, SELECT_ORDERS + Seek + OrderBy + FetchFirst);
+  m_OffsetStmt = DBStatement(m_Conn, SELECT_ORDERS + OrderBy + " OFFSET :1 ROWS FETCH NEXT " + std::to_string(PAGE_SIZE) + " ROWS ONLY");
+}
+
+void OrdersPageCache::RefreshEstimate()
+{
+  m_IsExactCount = false;
+
+  Table<int> Estimate;
+  m_EstimateStmt.FetchInto(Estimate, [](oci::ResultSet * _Result)
+  {
+    return std::make_tuple(_Result->getInt(1));
+  });
+
+  // Statistics may be missing or stale, keep at least one page reachable so the real end gets discovered
+  m_RowCount = std::max(Estimate.empty() ? 0 : std::get<0>(Estimate.front()), PAGE_SIZE);
+}
+
+OrdersPageCache::Page & OrdersPageCache::LoadPage(
+    int _PageIdx
+  )
+{
+  WL_TRACE_SCOPE_CAT("sql", __FUNCTION__);
+
+  DBStatement * Stmt = &m_FirstPageStmt;
+  if (_PageIdx > 0)
+  {
+    const auto PrevIt = m_Boundaries.find(_PageIdx - 1);
+    if (PrevIt != m_Boundaries.end())
+    {
+      Stmt = &m_KeysetStmt;
+      BindBoundary(PrevIt->second);
+    }
+    else
+    {
+      // Jumped past pages that were never fetched, no key to seek from
+      Stmt = &m_OffsetStmt;
+      m_OffsetStmt->setInt(1, _PageIdx * PAGE_SIZE);
+    }
+  }
+
+  std::vector<Row> Rows;
+  std::string LastQuantityText;
+  const bool IsQuantitySort = m_SortColumn == QUANTITY_COLUMN;
+
+  Stmt->FetchInto(Rows, [&](oci::ResultSet * _Result)
+  {
+    if (IsQuantitySort)
+      LastQuantityText = _Result->getString(6);
+
+    return std::make_tuple(
+        _Result->getInt(1),
+        _Result->getInt(2),
+        STRING_TO_ORDER_STATUS.at(_Result->getString(3)),
+        _Result->getDate(4),
+        _Result->getInt(5),
+        _Result->getFloat(6)
+      );
+  });
+
+  const int RowsBefore = _PageIdx * PAGE_SIZE;
+  const int Fetched = static_cast<int>(Rows.size());
+
+  if (Fetched < PAGE_SIZE)
+  {
+    m_RowCount = RowsBefore + Fetched;
+    m_IsExactCount = true;
+  }
+  else if (!m_IsExactCount && RowsBefore + Fetched >= m_RowCount)
+  {
+    m_RowCount = RowsBefore + Fetched + PAGE_SIZE;
+  }
+
+  if (!Rows.empty())
+    m_Boundaries[_PageIdx] = PageBoundary{ Rows.back(), LastQuantityText };
+
+  while (m_Pages.size() >= PAGE_CAPACITY)
+  {
+    m_Pages.erase(m_Lru.back());
+    m_Lru.pop_back();
+  }
+
+  m_Lru.push_front(_PageIdx);
+  auto & Loaded = m_Pages[_PageIdx];
+  Loaded.Rows = std::move(Rows);
+  Loaded.LruIt = m_Lru.begin();
+  return Loaded;
+}
+
+void OrdersPageCache::BindBoundary(
+    const PageBoundary & _Boundary
+  )
+{
+  const auto & [OrderId, CustomerId, Status, Date, ProductId, Quantity] = _Boundary.LastRow;
+
+  if (m_SortColumn == 0)
+  {
+    m_KeysetStmt->setInt(1, OrderId);
+    return;
+  }
+
+  for (unsigned int Idx : { 1u, 2u })
+  {
+    switch (m_SortColumn)
+    {
+    case 1: m_KeysetStmt->setInt(Idx, CustomerId); break;
+    case 2: m_KeysetStmt->setString(Idx, ORDER_STATUS_TO_STRING.at(Status)); break;
+    case 3: m_KeysetStmt->setDate(Idx, Date); break;
+    case 4: m_KeysetStmt->setInt(Idx, ProductId); break;
+    // The decimal text compares exactly with NUMBER(8,2), a float would not
+    case QUANTITY_COLUMN: m_KeysetStmt->setString(Idx, _Boundary.QuantityText); break;
+    }
+  }
+  m_KeysetStmt->setInt(3, OrderId);
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "ISLabApp.h"
+#include "DBStatement.h"
+
+#include <imgui.h>
+#include <list>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+// Server-backed view of the orders table.
+// Rows are fetched in pages by keyset as they become visible, only the most recently used pages stay in memory.
+class OrdersPageCache
+{
+public:
+
+  using Row = std::tuple<int, int, EOrderStatus, oci::Date, int, float>;
+
+  static constexpr int PAGE_SIZE = 256;
+  static constexpr std::size_t PAGE_CAPACITY = 16;
+
+  OrdersPageCache() = default;
+
+  explicit OrdersPageCache(
+      oci::Connection * _Conn
+    );
+
+  void SetSort(
+      int _ColIdx,
+      ImGuiSortDirection _SortDir
+    );
+
+  // Drops the cached pages after the table was modified
+  void Invalidate();
+
+  // Releases the cached pages and boundary keys
+  void Clear();
+
+  // Estimated from the optimizer statistics until the end of the table has been fetched
+  int GetRowCount() const;
+  bool IsExactCount() const;
+
+  std::size_t GetCachedPageCount() const;
+
+  // Loads the page of the row if needed, returns nullptr past the end of the table
+  const Row * GetRow(
+      int _Index
+    );
+
+private:
+
+  struct Page
+  {
+    std::vector<Row> Rows;
+    std::list<int>::iterator LruIt;
+  };
+
+  // Sort key of the last row of a page, used to seek to the next one
+  struct PageBoundary
+  {
+    Row LastRow;
+    std::string QuantityText;
+  };
+
+  void Prepare();
+  void RefreshEstimate();
+
+  Page & LoadPage(
+      int _PageIdx
+    );
+
+  void BindBoundary(
+      const PageBoundary & _Boundary
+    );
+
+  oci::Connection * m_Conn = nullptr;
+
+  int m_SortColumn = 0;
+  ImGuiSortDirection m_SortDir = ImGuiSortDirection_Ascending;
+
+  DBStatement m_FirstPageStmt;
+  DBStatement m_KeysetStmt;
+  DBStatement m_OffsetStmt;
+  DBStatement m_EstimateStmt;
+
+  std::unordered_map<int, Page> m_Pages;
+  std::list<int> m_Lru;
+  std::unordered_map<int, PageBoundary> m_Boundaries;
+
+  int m_RowCount = 0;
+  bool m_IsExactCount = false;
+  bool m_IsSuspended = false;
+};
\ No newline at end of file
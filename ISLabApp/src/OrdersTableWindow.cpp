@@ -2,6 +2,7 @@
 
 #include "CustomersTableWindow.h"
 #include "ProductsTableWindow.h"
+#include "TableOps.h"
 
 #include <imgui.h>
 #include <algorithm>
@@ -15,40 +16,49 @@ OrdersTableWindow::OrdersTableWindow(
   ) :
     m_Env{ _Env },
     m_Conn{ _Conn },
+    m_Pages{ _Conn },
     m_Customers{ _Customers },
     m_Products{ _Products }
 {
-  m_CreateStmt = m_Conn->createStatement("INSERT INTO orders(customer_id, status, order_date, product_id, quantity) VALUES(:1,:2,:3,:4,:5)");
-  m_DeleteStmt = m_Conn->createStatement("DELETE FROM orders WHERE order_id = :1");
-  m_UpdateStatusStmt = m_Conn->createStatement("UPDATE orders SET status = :1 WHERE order_id = :2");
-  m_UpdateStmt = m_Conn->createStatement("SELECT * FROM orders");
-
-  m_SignalConnections.AddConnection(m_Customers->TableChangedSignal, this, &OrdersTableWindow::UpdateTable);
-  m_SignalConnections.AddConnection(m_Products->TableChangedSignal, this, &OrdersTableWindow::UpdateTable);
+  m_CreateStmt = DBStatement(m_Conn, "INSERT INTO orders(customer_id, status, order_date, product_id, quantity) VALUES(:1,:2,:3,:4,:5) RETURNING order_id INTO :6");
+  m_CreateStmt->registerOutParam(6, oci::OCCIINT);
+  m_DeleteStmt = DBStatement(m_Conn, "DELETE FROM orders WHERE order_id = :1");
+  m_UpdateStatusStmt = DBStatement(m_Conn, "UPDATE orders SET status = :1 WHERE order_id = :2");
+  m_UpdateStmt = DBStatement(m_Conn, UPDATE_QUERY);
+
+  m_SignalConnections.AddConnection(m_Customers->RowsDeletedSignal, this, &OrdersTableWindow::OnParentRowsDeleted);
+  m_SignalConnections.AddConnection(m_Products->RowsDeletedSignal, this, &OrdersTableWindow::OnParentRowsDeleted);
 }
 
 OrdersTableWindow::~OrdersTableWindow()
 {
-  m_Conn->terminateStatement(m_CreateStmt);
-  m_Conn->terminateStatement(m_DeleteStmt);
-  m_Conn->terminateStatement(m_UpdateStmt);
-
   m_SignalConnections.Disconnect();
 }
 
 void OrdersTableWindow::OnUIRender()
 {
-  ImGui::Begin("Orders");
+  WL_TRACE_SCOPE_CAT("render", __FUNCTION__);
+
+  const bool IsVisible = ImGui::Begin("Orders");
 
   if (ImGui::IsWindowAppearing())
     m_NeedUpdate = true;
 
+  // Collapsed or in a hidden tab, a refresh waits until it is shown
+  if (!IsVisible)
+  {
+    ImGui::End();
+    return;
+  }
+
   if (m_NeedUpdate)
   {
-    UpdateTable();
+    RefreshTable();
     m_NeedUpdate = false;
   }
 
+  m_Refresh.MarkVisible();
+
   if (ImGui::Button("Create"))
     OpenCreateWindow();
   RenderCreateWindow();
@@ -59,6 +69,22 @@ void OrdersTableWindow::OnUIRender()
     OpenDeleteWindow();
   RenderDeleteWindow();
 
+  ImGui::SameLine();
+
+  bool IsPaged = m_IsPaged;
+  if (ImGui::Checkbox("Paged", &IsPaged))
+    SetPaged(IsPaged);
+
+  if (m_IsPaged)
+  {
+    ImGui::SameLine();
+    ImGui::TextDisabled("%s%d rows, %zu of %zu pages cached",
+        m_Pages.IsExactCount() ? "" : "~",
+        m_Pages.GetRowCount(),
+        m_Pages.GetCachedPageCount(),
+        OrdersPageCache::PAGE_CAPACITY);
+  }
+
   RenderTable();
   RenderErrorWindow();
 
@@ -123,7 +149,10 @@ void OrdersTableWindow::RenderDeleteWindow()
 {
   if (ImGui::BeginPopupModal("Delete", &m_IsDeleting, ImGuiWindowFlags_AlwaysAutoResize))
   {
-    DropDown<0>("Order ID", m_Table, m_OrderId);
+    if (m_IsPaged)
+      ImGui::InputInt("Order ID", &m_OrderId);
+    else
+      DropDown<0>("Order ID", m_Table.Get(), m_OrderId);
 
     if (ButtonCentered("OK"))
     {
@@ -192,51 +221,120 @@ void OrdersTableWindow::RenderTable()
       SortSpecs->SpecsDirty = false;
     }
 
-    for (const auto & [Id, CustomerId, Status, Date, ProductId, Quantity] : m_Table)
+    if (m_IsPaged)
     {
-      ImGui::TableNextRow();
-      ImGui::TableNextColumn();
-      ImGui::Text("%d", Id);
-      ImGui::TableNextColumn();
-      ImGui::Text("%d", CustomerId);
-      ImGui::TableNextColumn();
-      ImGui::TextUnformatted(ORDER_STATUS_TO_STRING.at(Status).c_str());
-      ImGui::TableNextColumn();
-
-      const auto DateStr = Date.toText("DD-MM-RR");
-      ImGui::TextUnformatted(DateStr.c_str());
-
-      ImGui::TableNextColumn();
-      ImGui::Text("%d", ProductId);
-      ImGui::TableNextColumn();
-      ImGui::Text("%.2f", Quantity);
+      RenderPagedRows();
+    }
+    else
+    {
+      for (const auto & Row : m_Table.Get())
+        RenderRow(Row);
     }
 
     ImGui::EndTable();
   }
 }
 
-void OrdersTableWindow::UpdateTable()
+void OrdersTableWindow::RenderRow(
+    const OrdersPageCache::Row & _Row
+  )
 {
-  m_Table.clear();
+  const auto & [Id, CustomerId, Status, Date, ProductId, Quantity] = _Row;
+
+  ImGui::TableNextRow();
+  ImGui::TableNextColumn();
+  ImGui::Text("%d", Id);
+  ImGui::TableNextColumn();
+  ImGui::Text("%d", CustomerId);
+  ImGui::TableNextColumn();
+  ImGui::TextUnformatted(ORDER_STATUS_TO_STRING.at(Status).c_str());
+  ImGui::TableNextColumn();
+
+  const auto DateStr = Date.toText("DD-MM-RR");
+  ImGui::TextUnformatted(DateStr.c_str());
+
+  ImGui::TableNextColumn();
+  ImGui::Text("%d", ProductId);
+  ImGui::TableNextColumn();
+  ImGui::Text("%.2f", Quantity);
+}
+
+void OrdersTableWindow::RenderPagedRows()
+{
+  ImGuiListClipper Clipper;
+  Clipper.Begin(m_Pages.GetRowCount());
 
   try
   {
-    auto * Result = m_UpdateStmt->executeQuery();
-    Result->next();
+    while (Clipper.Step())
+    {
+      for (int Idx = Clipper.DisplayStart; Idx < Clipper.DisplayEnd; ++Idx)
+      {
+        const auto * Row = m_Pages.GetRow(Idx);
+        if (!Row)
+          break;
+
+        RenderRow(*Row);
+      }
+    }
+  }
+  catch (const oci::SQLException & ex)
+  {
+    Clipper.End();
+    m_ErrorMessage = ex.what();
+    OpenErrorWindow();
+  }
+}
+
+void OrdersTableWindow::SetPaged(
+    bool _IsPaged
+  )
+{
+  if (_IsPaged == m_IsPaged)
+    return;
+
+  m_IsPaged = _IsPaged;
+
+  if (m_IsPaged)
+  {
+    m_Table.Publish(std::make_shared<Table<int, int, EOrderStatus, oci::Date, int, float>>());
 
-    while (Result->status() == oci::ResultSet::DATA_AVAILABLE)
+    try
     {
-      m_Table.emplace_back(
-          Result->getInt(1),
-          Result->getInt(2),
-          STRING_TO_ORDER_STATUS.at(Result->getString(3)),
-          Result->getDate(4),
-          Result->getInt(5),
-          Result->getFloat(6)
-        );
-      Result->next();
+      m_Pages.SetSort(m_SortPredicate.m_ColIdx, m_SortPredicate.m_SortDir);
     }
+    catch (const oci::SQLException & ex)
+    {
+      m_ErrorMessage = ex.what();
+      OpenErrorWindow();
+    }
+  }
+  else
+  {
+    m_Pages.Clear();
+  }
+
+  UpdateTable();
+  TableChangedSignal.Emit();
+}
+
+void OrdersTableWindow::UpdateTable()
+{
+  WL_TRACE_SCOPE_CAT("sql", __FUNCTION__);
+
+  // Superseded by this fetch
+  m_Refresh.Cancel();
+
+  if (m_IsPaged)
+  {
+    InvalidatePages();
+    return;
+  }
+
+  auto Rows = std::make_shared<Table<int, int, EOrderStatus, oci::Date, int, float>>();
+  try
+  {
+    m_UpdateStmt.FetchInto(*Rows, &ReadRow);
   }
   catch (const oci::SQLException & ex)
   {
@@ -244,26 +342,111 @@ void OrdersTableWindow::UpdateTable()
     OpenErrorWindow();
   }
 
-  if (!m_Table.empty())
+  m_Table.Publish(std::move(Rows));
+  OnTableLoaded();
+}
+
+void OrdersTableWindow::RefreshTable()
+{
+  if (m_IsPaged)
+  {
+    UpdateTable();
+    return;
+  }
+
+  m_Refresh.Start<Table<int, int, EOrderStatus, oci::Date, int, float>>(
+      m_UpdateStmt,
+      &ReadRow,
+      [this](Table<int, int, EOrderStatus, oci::Date, int, float> _Rows)
+      {
+        SetTable(std::move(_Rows));
+      },
+      [this](const oci::SQLException & ex)
+      {
+        m_ErrorMessage = ex.what();
+        OpenErrorWindow();
+      }
+    );
+}
+
+void OrdersTableWindow::SetTable(
+    Table<int, int, EOrderStatus, oci::Date, int, float> _Table
+  )
+{
+  m_Refresh.Cancel();
+
+  // The paged view has its own data source
+  if (m_IsPaged)
+    return;
+
+  m_Table.Publish(std::make_shared<Table<int, int, EOrderStatus, oci::Date, int, float>>(std::move(_Table)));
+  OnTableLoaded();
+  m_NeedUpdate = false;
+  TableChangedSignal.Emit();
+}
+
+void OrdersTableWindow::OnTableLoaded()
+{
+  auto & Rows = m_Table.Edit();
+  std::sort(Rows.begin(), Rows.end(), m_SortPredicate);
+
+  if (!Rows.empty())
   {
-    Copy(std::get<0>(m_Table.front()), m_OrderId);
-    Copy(std::get<1>(m_Table.front()), m_CustomerId);
-    Copy(std::get<2>(m_Table.front()), m_OrderStatus);
-    //Copy(std::get<3>(m_Table.front()), m_Date);
-    Copy(std::get<4>(m_Table.front()), m_ProductId);
-    Copy(std::get<5>(m_Table.front()), m_Quantity);
+    Copy(std::get<0>(Rows.front()), m_OrderId);
+    Copy(std::get<1>(Rows.front()), m_CustomerId);
+    Copy(std::get<2>(Rows.front()), m_OrderStatus);
+    //Copy(std::get<3>(Rows.front()), m_Date);
+    Copy(std::get<4>(Rows.front()), m_ProductId);
+    Copy(std::get<5>(Rows.front()), m_Quantity);
   }
 }
 
+std::tuple<int, int, EOrderStatus, oci::Date, int, float> OrdersTableWindow::ReadRow(
+    oci::ResultSet * _Result
+  )
+{
+  return std::make_tuple(
+      _Result->getInt(1),
+      _Result->getInt(2),
+      STRING_TO_ORDER_STATUS.at(_Result->getString(3)),
+      _Result->getDate(4),
+      _Result->getInt(5),
+      _Result->getFloat(6)
+    );
+}
+
+void OrdersTableWindow::OnParentRowsDeleted()
+{
+  UpdateTable();
+  RowsDeletedSignal.Emit();
+  TableChangedSignal.Emit();
+}
+
 void OrdersTableWindow::SortTable(
     int _ColIdx,
     ImGuiSortDirection _SortDir
   )
 {
-  std::sort(
-      m_Table.begin(), m_Table.end(),
-      PredicateImpl<decltype(m_Table)>{ _ColIdx, _SortDir }
-    );
+  WL_TRACE_SCOPE_CAT("sort", __FUNCTION__);
+
+  m_SortPredicate = { _ColIdx, _SortDir };
+
+  if (!m_IsPaged)
+  {
+    auto & Rows = m_Table.Edit();
+    std::sort(Rows.begin(), Rows.end(), m_SortPredicate);
+    return;
+  }
+
+  try
+  {
+    m_Pages.SetSort(_ColIdx, _SortDir);
+  }
+  catch (const oci::SQLException & ex)
+  {
+    m_ErrorMessage = ex.what();
+    OpenErrorWindow();
+  }
 }
 
 void OrdersTableWindow::Create(
@@ -281,10 +464,9 @@ void OrdersTableWindow::Create(
     m_CreateStmt->setDate(3, _Date);
     m_CreateStmt->setInt(4, _ProductId);
     m_CreateStmt->setFloat(5, _Quantity);
-    m_CreateStmt->executeUpdate();
-    m_Conn->commit();
-    UpdateTable();
-    TableChangedSignal.Emit();
+    m_CreateStmt.ExecuteUpdate();
+    m_CreateStmt.Commit();
+    AddRow(m_CreateStmt->getInt(6), _CustomerId, _Status, _Date, _ProductId, _Quantity);
   }
   catch (const oci::SQLException & ex)
   {
@@ -302,9 +484,26 @@ void OrdersTableWindow::UpdateStatus(
   {
     m_UpdateStatusStmt->setString(1, ORDER_STATUS_TO_STRING.at(_Status));
     m_UpdateStatusStmt->setInt(2, _OrderId);
-    m_UpdateStatusStmt->executeUpdate();
-    m_Conn->commit();
-    UpdateTable();
+    m_UpdateStatusStmt.ExecuteUpdate();
+    m_UpdateStatusStmt.Commit();
+
+    if (m_IsPaged)
+    {
+      m_Pages.Invalidate();
+      TableChangedSignal.Emit();
+      return;
+    }
+
+    // The row moves to its place under the new status, O(n) as any patch, see TableOps.h
+    auto & Rows = m_Table.Edit();
+    const auto It = std::find_if(Rows.begin(), Rows.end(), [&](const auto & _Row) { return std::get<0>(_Row) == _OrderId; });
+    if (It != Rows.end())
+    {
+      auto Row = *It;
+      std::get<2>(Row) = _Status;
+      Rows.erase(It);
+      InsertSorted(Rows, std::move(Row), m_SortPredicate);
+    }
     TableChangedSignal.Emit();
   }
   catch (const oci::SQLException & ex)
@@ -321,9 +520,16 @@ void OrdersTableWindow::Delete(
   try
   {
     m_DeleteStmt->setInt(1, _OrderID);
-    m_DeleteStmt->executeUpdate();
-    m_Conn->commit();
-    UpdateTable();
+    m_DeleteStmt.ExecuteUpdate();
+    m_DeleteStmt.Commit();
+
+    if (m_IsPaged)
+      m_Pages.Invalidate();
+
+    auto & Rows = m_Table.Edit();
+    EraseByKey<0>(Rows, _OrderID);
+    if (!Rows.empty())
+      Copy(std::get<0>(Rows.front()), m_OrderId);
     TableChangedSignal.Emit();
   }
   catch (const oci::SQLException & ex)
@@ -331,4 +537,56 @@ void OrdersTableWindow::Delete(
     m_ErrorMessage = ex.what();
     OpenErrorWindow();
   }
+}
+
+void OrdersTableWindow::AddRow(
+    int _OrderId,
+    int _CustomerId,
+    EOrderStatus _Status,
+    const oci::Date & _Date,
+    int _ProductId,
+    float _Quantity
+  )
+{
+  if (m_IsPaged)
+    InvalidatePages();
+  else
+    InsertSorted(m_Table.Edit(), std::make_tuple(_OrderId, _CustomerId, _Status, _Date, _ProductId, _Quantity), m_SortPredicate);
+
+  TableChangedSignal.Emit();
+}
+
+void OrdersTableWindow::AddRows(
+    const Table<int, int, EOrderStatus, oci::Date, int, float> & _Rows
+  )
+{
+  if (m_IsPaged)
+  {
+    InvalidatePages();
+  }
+  else
+  {
+    for (const auto & Row : _Rows)
+      InsertSorted(m_Table.Edit(), Row, m_SortPredicate);
+  }
+
+  TableChangedSignal.Emit();
+}
+
+std::size_t OrdersTableWindow::GetRowCount() const
+{
+  return m_IsPaged ? static_cast<std::size_t>(m_Pages.GetRowCount()) : m_Table.Get().size();
+}
+
+void OrdersTableWindow::InvalidatePages()
+{
+  try
+  {
+    m_Pages.Invalidate();
+  }
+  catch (const oci::SQLException & ex)
+  {
+    m_ErrorMessage = ex.what();
+    OpenErrorWindow();
+  }
 }
\ No newline at end of file
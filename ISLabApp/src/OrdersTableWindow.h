@@ -2,6 +2,10 @@
 
 #include "ISLabApp.h"
 #include "IWindow.h"
+#include "DBStatement.h"
+#include "IncrementalFetch.h"
+#include "SnapshotCell.h"
+#include "OrdersPageCache.h"
 
 #include <imgui.h>
 #include <vector>
@@ -43,6 +47,29 @@ public:
   void RenderTable();
   void UpdateTable();
 
+  void SetTable(
+      Table<int, int, EOrderStatus, oci::Date, int, float> _Table
+    );
+
+  static constexpr const char * TABLE_NAME = "orders";
+  static constexpr const char * UPDATE_QUERY = "SELECT order_id, customer_id, status, order_date, product_id, quantity FROM orders";
+
+  static std::tuple<int, int, EOrderStatus, oci::Date, int, float> ReadRow(
+      oci::ResultSet * _Result
+    );
+
+  // Paged mode keeps only the visible pages of the orders table in memory, see OrdersPageCache
+  void SetPaged(
+      bool _IsPaged
+    );
+
+  bool IsPaged() const
+  {
+    return m_IsPaged;
+  }
+
+  void OnParentRowsDeleted();
+
   void SortTable(
       int _ColIdx,
       ImGuiSortDirection _SortDir
@@ -65,24 +92,66 @@ public:
       int _OrderID
     );
 
+  // Adds an order written elsewhere in this session without reloading the table
+  void AddRow(
+      int _OrderId,
+      int _CustomerId,
+      EOrderStatus _Status,
+      const oci::Date & _Date,
+      int _ProductId,
+      float _Quantity
+    );
+
+  void AddRows(
+      const Table<int, int, EOrderStatus, oci::Date, int, float> & _Rows
+    );
+
+  // Estimated while paged and the end of the table has not been fetched
+  std::size_t GetRowCount() const;
+
+  const auto & GetSortPredicate() const
+  {
+    return m_SortPredicate;
+  }
+
+  // Empty in paged mode
   const auto & GetTable()
   {
-    return m_Table;
+    return m_Table.Get();
+  }
+
+  // Dependent windows read this instead of GetTable, it stays the same while they hold it
+  Snapshot<Table<int, int, EOrderStatus, oci::Date, int, float>> GetSnapshot() const
+  {
+    return m_Table.Read();
   }
 
 public:
 
   sig::CSignal<> TableChangedSignal;
+  sig::CSignal<> RowsDeletedSignal;
 
 private:
 
+  void OnTableLoaded();
+  // Fetches the table a slice per frame and hands it to SetTable
+  void RefreshTable();
+  void RenderRow(
+      const OrdersPageCache::Row & _Row
+    );
+
+  void RenderPagedRows();
+  void InvalidatePages();
+
   oci::Environment * m_Env = nullptr;
   oci::Connection * m_Conn = nullptr;
 
-  oci::Statement * m_CreateStmt = nullptr;
-  oci::Statement * m_DeleteStmt = nullptr;
-  oci::Statement* m_UpdateStatusStmt = nullptr;
-  oci::Statement * m_UpdateStmt = nullptr;
+  DBStatement m_CreateStmt;
+  DBStatement m_DeleteStmt;
+  DBStatement m_UpdateStatusStmt;
+  DBStatement m_UpdateStmt;
+  // Reads m_UpdateStmt, declared after it so it is closed first
+  IncrementalFetch m_Refresh;
 
   int m_OrderId = 0;
   int m_CustomerId = 0;
@@ -97,10 +166,14 @@ private:
   bool m_IsDeleting = false;
   bool m_IsError = false;
   bool m_NeedUpdate = true;
+  bool m_IsPaged = false;
 
   std::string m_ErrorMessage;
 
-  Table<int, int, EOrderStatus, oci::Date, int, float> m_Table;
+  // Edited in place while no other window holds it, the loaded version is published as is
+  SnapshotCell<Table<int, int, EOrderStatus, oci::Date, int, float>> m_Table;
+  PredicateImpl<int, int, EOrderStatus, oci::Date, int, float> m_SortPredicate{ 0, ImGuiSortDirection_Ascending };
+  OrdersPageCache m_Pages;
   CustomersTableWindow * m_Customers = nullptr;
   ProductsTableWindow * m_Products = nullptr;
   sig::CMultiConnection m_SignalConnections;
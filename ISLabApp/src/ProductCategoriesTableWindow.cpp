@@ -1,6 +1,7 @@
 #include "ProductCategoriesTableWindow.h"
 
 #include "CountriesTableWindow.h"
+#include "TableOps.h"
 
 #include <imgui.h>
 #include <algorithm>
@@ -13,31 +14,36 @@ ProductCategoriesTableWindow::ProductCategoriesTableWindow(
     m_Env{ _Env },
     m_Conn{ _Conn }
 {
-  m_CreateStmt = m_Conn->createStatement("INSERT INTO product_categories(category_name) VALUES(:1)");
-  m_DeleteStmt = m_Conn->createStatement("DELETE FROM product_categories WHERE category_id = :1");
-  m_UpdateStmt = m_Conn->createStatement("SELECT * FROM product_categories");
-}
-
-ProductCategoriesTableWindow::~ProductCategoriesTableWindow()
-{
-  m_Conn->terminateStatement(m_CreateStmt);
-  m_Conn->terminateStatement(m_DeleteStmt);
-  m_Conn->terminateStatement(m_UpdateStmt);
+  m_CreateStmt = DBStatement(m_Conn, "INSERT INTO product_categories(category_name) VALUES(:1) RETURNING category_id INTO :2");
+  m_CreateStmt->registerOutParam(2, oci::OCCIINT);
+  m_DeleteStmt = DBStatement(m_Conn, "DELETE FROM product_categories WHERE category_id = :1");
+  m_UpdateStmt = DBStatement(m_Conn, UPDATE_QUERY);
 }
 
 void ProductCategoriesTableWindow::OnUIRender()
 {
-  ImGui::Begin("Product categories");
+  WL_TRACE_SCOPE_CAT("render", __FUNCTION__);
+
+  const bool IsVisible = ImGui::Begin("Product categories");
 
   if (ImGui::IsWindowAppearing())
     m_NeedUpdate = true;
 
+  // Collapsed or in a hidden tab, a refresh waits until it is shown
+  if (!IsVisible)
+  {
+    ImGui::End();
+    return;
+  }
+
   if (m_NeedUpdate)
   {
-    UpdateTable();
+    RefreshTable();
     m_NeedUpdate = false;
   }
 
+  m_Refresh.MarkVisible();
+
   if (ImGui::Button("Create"))
     OpenCreateWindow();
   RenderCreateWindow();
@@ -69,7 +75,6 @@ void ProductCategoriesTableWindow::RenderCreateWindow()
     if (ButtonCentered("OK"))
     {
       Create(m_CategoryNameBuffer.data());
-      UpdateTable();
       CloseCreateWindow();
     }
 
@@ -99,7 +104,6 @@ void ProductCategoriesTableWindow::RenderDeleteWindow()
     if (ButtonCentered("OK"))
     {
       Delete(m_CategoryId);
-      UpdateTable();
       CloseDeleteWindow();
     }
 
@@ -172,18 +176,16 @@ void ProductCategoriesTableWindow::RenderTable()
 
 void ProductCategoriesTableWindow::UpdateTable()
 {
+  WL_TRACE_SCOPE_CAT("sql", __FUNCTION__);
+
+  // Superseded by this fetch
+  m_Refresh.Cancel();
+
   m_Table.clear();
 
   try
   {
-    auto * Result = m_UpdateStmt->executeQuery();
-    Result->next();
-
-    while (Result->status() == oci::ResultSet::DATA_AVAILABLE)
-    {
-      m_Table.emplace_back(Result->getInt(1), Result->getString(2));
-      Result->next();
-    }
+    m_UpdateStmt.FetchInto(m_Table, &ReadRow);
   }
   catch (const oci::SQLException & ex)
   {
@@ -191,6 +193,41 @@ void ProductCategoriesTableWindow::UpdateTable()
     OpenErrorWindow();
   }
 
+  OnTableLoaded();
+}
+
+void ProductCategoriesTableWindow::RefreshTable()
+{
+  m_Refresh.Start<Table<int, std::string>>(
+      m_UpdateStmt,
+      &ReadRow,
+      [this](Table<int, std::string> _Rows)
+      {
+        SetTable(std::move(_Rows));
+      },
+      [this](const oci::SQLException & ex)
+      {
+        m_ErrorMessage = ex.what();
+        OpenErrorWindow();
+      }
+    );
+}
+
+void ProductCategoriesTableWindow::SetTable(
+    Table<int, std::string> _Table
+  )
+{
+  m_Refresh.Cancel();
+  m_Table = std::move(_Table);
+  OnTableLoaded();
+  m_NeedUpdate = false;
+  TableChangedSignal.Emit();
+}
+
+void ProductCategoriesTableWindow::OnTableLoaded()
+{
+  std::sort(m_Table.begin(), m_Table.end(), m_SortPredicate);
+
   if (!m_Table.empty())
   {
     Copy(std::get<0>(m_Table.front()), m_CategoryId);
@@ -198,15 +235,22 @@ void ProductCategoriesTableWindow::UpdateTable()
   }
 }
 
+std::tuple<int, std::string> ProductCategoriesTableWindow::ReadRow(
+    oci::ResultSet * _Result
+  )
+{
+  return std::make_tuple(_Result->getInt(1), _Result->getString(2));
+}
+
 void ProductCategoriesTableWindow::SortTable(
     int _ColIdx,
     ImGuiSortDirection _SortDir
   )
 {
-  std::sort(
-      m_Table.begin(), m_Table.end(),
-      PredicateImpl<int, std::string>{ _ColIdx, _SortDir }
-    );
+  WL_TRACE_SCOPE_CAT("sort", __FUNCTION__);
+
+  m_SortPredicate = { _ColIdx, _SortDir };
+  std::sort(m_Table.begin(), m_Table.end(), m_SortPredicate);
 }
 
 void ProductCategoriesTableWindow::Create(
@@ -216,8 +260,9 @@ void ProductCategoriesTableWindow::Create(
   try
   {
     m_CreateStmt->setString(1, _CategoryName);
-    m_CreateStmt->executeUpdate();
-    m_Conn->commit();
+    m_CreateStmt.ExecuteUpdate();
+    m_CreateStmt.Commit();
+    InsertSorted(m_Table, std::make_tuple(m_CreateStmt->getInt(2), std::string(_CategoryName)), m_SortPredicate);
     TableChangedSignal.Emit();
   }
   catch (const oci::SQLException & ex)
@@ -234,8 +279,12 @@ void ProductCategoriesTableWindow::Delete(
   try
   {
     m_DeleteStmt->setInt(1, _CategoryID);
-    m_DeleteStmt->executeUpdate();
-    m_Conn->commit();
+    m_DeleteStmt.ExecuteUpdate();
+    m_DeleteStmt.Commit();
+    EraseByKey<0>(m_Table, _CategoryID);
+    if (!m_Table.empty())
+      Copy(std::get<0>(m_Table.front()), m_CategoryId);
+    RowsDeletedSignal.Emit();
     TableChangedSignal.Emit();
   }
   catch (const oci::SQLException & ex)
@@ -2,6 +2,8 @@
 
 #include "ISLabApp.h"
 #include "IWindow.h"
+#include "DBStatement.h"
+#include "IncrementalFetch.h"
 
 #include <imgui.h>
 #include <vector>
@@ -18,8 +20,6 @@ public:
       oci::Connection * _Conn
     );
 
-  ~ProductCategoriesTableWindow();
-
   void OnUIRender() override;
 
   void OpenCreateWindow();
@@ -37,6 +37,17 @@ public:
   void RenderTable();
   void UpdateTable();
 
+  void SetTable(
+      Table<int, std::string> _Table
+    );
+
+  static constexpr const char * TABLE_NAME = "product_categories";
+  static constexpr const char * UPDATE_QUERY = "SELECT category_id, category_name FROM product_categories";
+
+  static std::tuple<int, std::string> ReadRow(
+      oci::ResultSet * _Result
+    );
+
   void SortTable(
       int _ColIdx,
       ImGuiSortDirection _SortDir
@@ -58,15 +69,22 @@ public:
 public:
 
   sig::CSignal<> TableChangedSignal;
+  sig::CSignal<> RowsDeletedSignal;
 
 private:
 
+  void OnTableLoaded();
+  // Fetches the table a slice per frame and hands it to SetTable
+  void RefreshTable();
+
   oci::Environment * m_Env = nullptr;
   oci::Connection * m_Conn = nullptr;
 
-  oci::Statement * m_CreateStmt = nullptr;
-  oci::Statement * m_DeleteStmt = nullptr;
-  oci::Statement * m_UpdateStmt = nullptr;
+  DBStatement m_CreateStmt;
+  DBStatement m_DeleteStmt;
+  DBStatement m_UpdateStmt;
+  // Reads m_UpdateStmt, declared after it so it is closed first
+  IncrementalFetch m_Refresh;
 
   int m_CategoryId = 0;
   std::vector<char> m_CategoryNameBuffer = std::vector<char>(255 + 1, '\0');
@@ -79,4 +97,5 @@ private:
   std::string m_ErrorMessage;
 
   Table<int, std::string> m_Table;
+  PredicateImpl<int, std::string> m_SortPredicate{ 0, ImGuiSortDirection_Ascending };
 };
\ No newline at end of file
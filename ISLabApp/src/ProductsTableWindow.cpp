@@ -1,11 +1,20 @@
 #include "ProductsTableWindow.h"
 
 #include "ProductCategoriesTableWindow.h"
+#include "TableOps.h"
 
 #include <imgui.h>
 #include <algorithm>
 #include <map>
 
+namespace
+{
+
+constexpr int DESCRIPTION_BATCH_SIZE = 16;
+constexpr int DESCRIPTION_COLUMN = 2;
+
+} // namespace
+
 ProductsTableWindow::ProductsTableWindow(
     oci::Environment * _Env,
     oci::Connection * _Conn,
@@ -15,37 +24,53 @@ ProductsTableWindow::ProductsTableWindow(
     m_Conn{ _Conn },
     m_Categories{ _Categories }
 {
-  m_CreateStmt = m_Conn->createStatement("INSERT INTO products(product_name, description, cost, price, category_id) VALUES(:1,:2,:3,:4,:5)");
-  m_DeleteStmt = m_Conn->createStatement("DELETE FROM products WHERE product_id = :1");
-  m_UpdateStmt = m_Conn->createStatement("SELECT * FROM products");
+  m_CreateStmt = DBStatement(m_Conn, "INSERT INTO products(product_name, description, cost, price, category_id) VALUES(:1,:2,:3,:4,:5) RETURNING product_id INTO :6");
+  m_CreateStmt->registerOutParam(6, oci::OCCIINT);
+  m_DeleteStmt = DBStatement(m_Conn, "DELETE FROM products WHERE product_id = :1");
+  m_UpdateStmt = DBStatement(m_Conn, UPDATE_QUERY);
 
-  m_SignalConnection.Attach(m_Categories->TableChangedSignal, this, &ProductsTableWindow::UpdateTable);
+  std::string DescriptionSql = "SELECT product_id, description FROM products WHERE product_id IN (:1";
+  for (int i = 2; i <= DESCRIPTION_BATCH_SIZE; ++i)
+    DescriptionSql += ", :" + std::to_string(i);
+  m_DescriptionStmt = DBStatement(m_Conn, DescriptionSql + ")");
+
+  m_SignalConnection.Attach(m_Categories->RowsDeletedSignal, this, &ProductsTableWindow::OnParentRowsDeleted);
   m_SignalConnection.Connect();
 }
 
 ProductsTableWindow::~ProductsTableWindow()
 {
-  m_Conn->terminateStatement(m_CreateStmt);
-  m_Conn->terminateStatement(m_DeleteStmt);
-  m_Conn->terminateStatement(m_UpdateStmt);
-
   if (m_SignalConnection.IsConnected())
     m_SignalConnection.Disconnect();
 }
 
 void ProductsTableWindow::OnUIRender()
 {
-  ImGui::Begin("Products");
+  WL_TRACE_SCOPE_CAT("render", __FUNCTION__);
+
+  const bool IsVisible = ImGui::Begin("Products");
 
   if (ImGui::IsWindowAppearing())
     m_NeedUpdate = true;
 
+  // Requested by the make order cards too, so it runs while this window is hidden
+  FetchDescriptions();
+
+  // Collapsed or in a hidden tab, a refresh waits until it is shown
+  if (!IsVisible)
+  {
+    ImGui::End();
+    return;
+  }
+
   if (m_NeedUpdate)
   {
-    UpdateTable();
+    RefreshTable();
     m_NeedUpdate = false;
   }
 
+  m_Refresh.MarkVisible();
+
   if (ImGui::Button("Create"))
     OpenCreateWindow();
   RenderCreateWindow();
@@ -82,7 +107,6 @@ void ProductsTableWindow::RenderCreateWindow()
     if (ButtonCentered("OK"))
     {
       Create(m_ProductNameBuffer.data(), m_DescriptionBuffer.data(), m_Cost, m_Price, m_CategoryId);
-      UpdateTable();
       CloseCreateWindow();
     }
 
@@ -107,12 +131,11 @@ void ProductsTableWindow::RenderDeleteWindow()
 {
   if (ImGui::BeginPopupModal("Delete", &m_IsDeleting, ImGuiWindowFlags_AlwaysAutoResize))
   {
-    DropDown<0>("Product ID", m_Table, m_ProductId);
+    DropDown<0>("Product ID", m_Table.Get(), m_ProductId);
 
     if (ButtonCentered("OK"))
     {
       Delete(m_ProductId);
-      UpdateTable();
       CloseDeleteWindow();
     }
 
@@ -161,7 +184,7 @@ void ProductsTableWindow::RenderTable()
   {
     ImGui::TableSetupColumn("ID");
     ImGui::TableSetupColumn("Name");
-    ImGui::TableSetupColumn("Description");
+    ImGui::TableSetupColumn("Description", ImGuiTableColumnFlags_NoSort);
     ImGui::TableSetupColumn("Cost");
     ImGui::TableSetupColumn("Price");
     ImGui::TableSetupColumn("Category ID");
@@ -170,25 +193,40 @@ void ProductsTableWindow::RenderTable()
     auto * SortSpecs = ImGui::TableGetSortSpecs();
     if (SortSpecs->SpecsDirty)
     {
-      SortTable(SortSpecs->Specs[0].ColumnIndex, SortSpecs->Specs[0].SortDirection);
+      // The description column is not in the table
+      const int ColIdx = SortSpecs->Specs[0].ColumnIndex;
+      SortTable(ColIdx > DESCRIPTION_COLUMN ? ColIdx - 1 : ColIdx, SortSpecs->Specs[0].SortDirection);
       SortSpecs->SpecsDirty = false;
     }
 
-    for (const auto & [Id, Name, Description, Cost, Price, CategoryId] : m_Table)
+    // Only rows on screen request their descriptions
+    ImGuiListClipper Clipper;
+    const auto & Rows = m_Table.Get();
+    Clipper.Begin(static_cast<int>(Rows.size()));
+    while (Clipper.Step())
     {
-      ImGui::TableNextRow();
-      ImGui::TableNextColumn();
-      ImGui::Text("%d", Id);
-      ImGui::TableNextColumn();
-      ImGui::TextUnformatted(Name.c_str());
-      ImGui::TableNextColumn();
-      ImGui::TextUnformatted(Description.c_str());
-      ImGui::TableNextColumn();
-      ImGui::Text("%.2f", Cost);
-      ImGui::TableNextColumn();
-      ImGui::Text("%.2f", Price);
-      ImGui::TableNextColumn();
-      ImGui::Text("%d", CategoryId);
+      for (int Idx = Clipper.DisplayStart; Idx < Clipper.DisplayEnd; ++Idx)
+      {
+        const auto & [Id, Name, Cost, Price, CategoryId] = Rows[Idx];
+        const auto * Description = GetDescription(Id);
+
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::Text("%d", Id);
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(Name.c_str());
+        ImGui::TableNextColumn();
+        if (Description)
+          ImGui::TextUnformatted(Description->c_str());
+        else
+          ImGui::TextDisabled("...");
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", Cost);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", Price);
+        ImGui::TableNextColumn();
+        ImGui::Text("%d", CategoryId);
+      }
     }
 
     ImGui::EndTable();
@@ -197,25 +235,18 @@ void ProductsTableWindow::RenderTable()
 
 void ProductsTableWindow::UpdateTable()
 {
-  m_Table.clear();
+  WL_TRACE_SCOPE_CAT("sql", __FUNCTION__);
 
+  // Superseded by this fetch
+  m_Refresh.Cancel();
+
+  m_Descriptions.clear();
+  m_IsDescriptionFailed = false;
+
+  auto Rows = std::make_shared<Table<int, std::string, float, float, int>>();
   try
   {
-    auto * Result = m_UpdateStmt->executeQuery();
-    Result->next();
-
-    while (Result->status() == oci::ResultSet::DATA_AVAILABLE)
-    {
-      m_Table.emplace_back(
-          Result->getInt(1),
-          Result->getString(2),
-          Result->getString(3),
-          Result->getFloat(4),
-          Result->getFloat(5),
-          Result->getInt(6)
-        );
-      Result->next();
-    }
+    m_UpdateStmt.FetchInto(*Rows, &ReadRow);
   }
   catch (const oci::SQLException & ex)
   {
@@ -223,26 +254,85 @@ void ProductsTableWindow::UpdateTable()
     OpenErrorWindow();
   }
 
-  if (!m_Table.empty())
+  m_Table.Publish(std::move(Rows));
+  OnTableLoaded();
+}
+
+void ProductsTableWindow::RefreshTable()
+{
+  m_Refresh.Start<Table<int, std::string, float, float, int>>(
+      m_UpdateStmt,
+      &ReadRow,
+      [this](Table<int, std::string, float, float, int> _Rows)
+      {
+        SetTable(std::move(_Rows));
+      },
+      [this](const oci::SQLException & ex)
+      {
+        m_ErrorMessage = ex.what();
+        OpenErrorWindow();
+      }
+    );
+}
+
+void ProductsTableWindow::SetTable(
+    Table<int, std::string, float, float, int> _Table
+  )
+{
+  m_Refresh.Cancel();
+  m_Table.Publish(std::make_shared<Table<int, std::string, float, float, int>>(std::move(_Table)));
+  m_Descriptions.clear();
+  m_IsDescriptionFailed = false;
+  OnTableLoaded();
+  m_NeedUpdate = false;
+  TableChangedSignal.Emit();
+}
+
+void ProductsTableWindow::OnTableLoaded()
+{
+  auto & Rows = m_Table.Edit();
+  std::sort(Rows.begin(), Rows.end(), m_SortPredicate);
+
+  if (!Rows.empty())
   {
-    Copy(std::get<0>(m_Table.front()), m_ProductId);
-    Copy(std::get<1>(m_Table.front()), m_ProductNameBuffer);
-    Copy(std::get<2>(m_Table.front()), m_DescriptionBuffer);
-    Copy(std::get<3>(m_Table.front()), m_Cost);
-    Copy(std::get<4>(m_Table.front()), m_Price);
-    Copy(std::get<5>(m_Table.front()), m_CategoryId);
+    Copy(std::get<0>(Rows.front()), m_ProductId);
+    Copy(std::get<1>(Rows.front()), m_ProductNameBuffer);
+    Copy(std::get<2>(Rows.front()), m_Cost);
+    Copy(std::get<3>(Rows.front()), m_Price);
+    Copy(std::get<4>(Rows.front()), m_CategoryId);
   }
 }
 
+std::tuple<int, std::string, float, float, int> ProductsTableWindow::ReadRow(
+    oci::ResultSet * _Result
+  )
+{
+  return std::make_tuple(
+      _Result->getInt(1),
+      _Result->getString(2),
+      _Result->getFloat(3),
+      _Result->getFloat(4),
+      _Result->getInt(5)
+    );
+}
+
+void ProductsTableWindow::OnParentRowsDeleted()
+{
+  UpdateTable();
+  RowsDeletedSignal.Emit();
+  TableChangedSignal.Emit();
+}
+
 void ProductsTableWindow::SortTable(
     int _ColIdx,
     ImGuiSortDirection _SortDir
   )
 {
-  std::sort(
-      m_Table.begin(), m_Table.end(),
-      PredicateImpl<decltype(m_Table)>{ _ColIdx, _SortDir }
-    );
+  WL_TRACE_SCOPE_CAT("sort", __FUNCTION__);
+
+  m_SortPredicate = { _ColIdx, _SortDir };
+  auto & Rows = m_Table.Edit();
+  std::sort(Rows.begin(), Rows.end(), m_SortPredicate);
 }
 
 void ProductsTableWindow::Create(
@@ -260,8 +350,12 @@ void ProductsTableWindow::Create(
     m_CreateStmt->setFloat(3, _Cost);
     m_CreateStmt->setFloat(4, _Price);
     m_CreateStmt->setInt(5, _CategoryId);
-    m_CreateStmt->executeUpdate();
-    m_Conn->commit();
+    m_CreateStmt.ExecuteUpdate();
+    m_CreateStmt.Commit();
+    const int ProductId = m_CreateStmt->getInt(6);
+    InsertSorted(m_Table.Edit(), std::make_tuple(ProductId, std::string(_ProductName), _Cost, _Price, _CategoryId), m_SortPredicate);
+    m_Descriptions[ProductId] = _Description;
+    TableChangedSignal.Emit();
   }
   catch (const oci::SQLException & ex)
   {
@@ -277,11 +371,76 @@ void ProductsTableWindow::Delete(
   try
   {
     m_DeleteStmt->setInt(1, _ProductID);
-    m_DeleteStmt->executeUpdate();
-    m_Conn->commit();
+    m_DeleteStmt.ExecuteUpdate();
+    m_DeleteStmt.Commit();
+    auto & Rows = m_Table.Edit();
+    EraseByKey<0>(Rows, _ProductID);
+    m_Descriptions.erase(_ProductID);
+    if (!Rows.empty())
+      Copy(std::get<0>(Rows.front()), m_ProductId);
+    RowsDeletedSignal.Emit();
+    TableChangedSignal.Emit();
+  }
+  catch (const oci::SQLException & ex)
+  {
+    m_ErrorMessage = ex.what();
+    OpenErrorWindow();
+  }
+}
+
+const std::string * ProductsTableWindow::GetDescription(
+    int _ProductId
+  )
+{
+  const auto It = m_Descriptions.find(_ProductId);
+  if (It != m_Descriptions.end())
+    return &It->second;
+
+  m_PendingDescriptions.insert(_ProductId);
+  return nullptr;
+}
+
+void ProductsTableWindow::FetchDescriptions()
+{
+  if (m_PendingDescriptions.empty())
+    return;
+
+  WL_TRACE_SCOPE_CAT("sql", __FUNCTION__);
+
+  std::vector<int> Pending(m_PendingDescriptions.begin(), m_PendingDescriptions.end());
+  m_PendingDescriptions.clear();
+
+  // The visible cards request their descriptions every frame, a failing query would run and report each time
+  if (m_IsDescriptionFailed)
+    return;
+
+  try
+  {
+    for (std::size_t Offset = 0; Offset < Pending.size(); Offset += DESCRIPTION_BATCH_SIZE)
+    {
+      // Unused slots repeat the first id so the statement text stays the same
+      for (int i = 0; i < DESCRIPTION_BATCH_SIZE; ++i)
+      {
+        const auto Idx = Offset + i < Pending.size() ? Offset + i : Offset;
+        m_DescriptionStmt->setInt(i + 1, Pending[Idx]);
+      }
+
+      Table<int, std::string> Rows;
+      m_DescriptionStmt.FetchInto(Rows, [](oci::ResultSet * _Result)
+      {
+        return std::make_tuple(_Result->getInt(1), _Result->getString(2));
+      });
+
+      // Products deleted elsewhere get an empty description instead of being requested every frame
+      for (std::size_t i = Offset; i < std::min(Offset + DESCRIPTION_BATCH_SIZE, Pending.size()); ++i)
+        m_Descriptions.emplace(Pending[i], std::string());
+      for (auto & [ProductId, Description] : Rows)
+        m_Descriptions[ProductId] = std::move(Description);
+    }
   }
   catch (const oci::SQLException & ex)
   {
+    m_IsDescriptionFailed = true;
     m_ErrorMessage = ex.what();
     OpenErrorWindow();
   }
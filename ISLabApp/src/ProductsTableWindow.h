@@ -2,11 +2,16 @@
 
 #include "ISLabApp.h"
 #include "IWindow.h"
+#include "DBStatement.h"
+#include "IncrementalFetch.h"
+#include "SnapshotCell.h"
 
 #include <imgui.h>
 #include <vector>
 #include <tuple>
 #include <functional>
+#include <set>
+#include <unordered_map>
 #include <signals/Connection.h>
 
 class ProductCategoriesTableWindow;
@@ -41,6 +46,19 @@ public:
   void RenderTable();
   void UpdateTable();
 
+  void SetTable(
+      Table<int, std::string, float, float, int> _Table
+    );
+
+  static constexpr const char * TABLE_NAME = "products";
+  static constexpr const char * UPDATE_QUERY = "SELECT product_id, product_name, cost, price, category_id FROM products";
+
+  static std::tuple<int, std::string, float, float, int> ReadRow(
+      oci::ResultSet * _Result
+    );
+
+  void OnParentRowsDeleted();
+
   void SortTable(
       int _ColIdx,
       ImGuiSortDirection _SortDir
@@ -58,23 +76,44 @@ public:
       int _ProductID
     );
 
+  // Descriptions are not part of the table, see GetDescription
   const auto & GetTable() const
   {
-    return m_Table;
+    return m_Table.Get();
   }
 
+  // Dependent windows read this instead of GetTable, it stays the same while they hold it
+  Snapshot<Table<int, std::string, float, float, int>> GetSnapshot() const
+  {
+    return m_Table.Read();
+  }
+
+  // Returns nullptr until the description is loaded, requested descriptions are fetched in batches on the next frame
+  const std::string * GetDescription(
+      int _ProductId
+    );
+
 public:
 
   sig::CSignal<> TableChangedSignal;
+  sig::CSignal<> RowsDeletedSignal;
 
 private:
 
+  void OnTableLoaded();
+  // Fetches the table a slice per frame and hands it to SetTable
+  void RefreshTable();
+  void FetchDescriptions();
+
   oci::Environment * m_Env = nullptr;
   oci::Connection * m_Conn = nullptr;
 
-  oci::Statement * m_CreateStmt = nullptr;
-  oci::Statement * m_DeleteStmt = nullptr;
-  oci::Statement * m_UpdateStmt = nullptr;
+  DBStatement m_CreateStmt;
+  DBStatement m_DeleteStmt;
+  DBStatement m_UpdateStmt;
+  // Reads m_UpdateStmt, declared after it so it is closed first
+  IncrementalFetch m_Refresh;
+  DBStatement m_DescriptionStmt;
 
   int m_ProductId = 0;
   std::vector<char> m_ProductNameBuffer = std::vector<char>(255 + 1, '\0');
@@ -90,7 +129,13 @@ private:
 
   std::string m_ErrorMessage;
 
-  Table<int, std::string, std::string, float, float, int> m_Table;
+  // Edited in place while no other window holds it, the loaded version is published as is
+  SnapshotCell<Table<int, std::string, float, float, int>> m_Table;
+  PredicateImpl<int, std::string, float, float, int> m_SortPredicate{ 0, ImGuiSortDirection_Ascending };
+  std::unordered_map<int, std::string> m_Descriptions;
+  std::set<int> m_PendingDescriptions;
+  // Set when fetching descriptions failed, none are fetched again until the table is reloaded
+  bool m_IsDescriptionFailed = false;
   ProductCategoriesTableWindow * m_Categories = nullptr;
   sig::CConnection<> m_SignalConnection;
 };
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include "QueryBuilder.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace
+{
+
+std::string ToUpper(
+    std::string _Str
+  )
+{
+  std::transform(_Str.begin(), _Str.end(), _Str.begin(), [](unsigned char _Char) { return static_cast<char>(std::toupper(_Char)); });
+  return _Str;
+}
+
+// The search is a plain substring, as on the client, so LIKE wildcards in it must match literally
+std::string EscapeLike(
+    const std::string & _Str
+  )
+{
+  std::string Escaped;
+  Escaped.reserve(_Str.size());
+  for (const char Char : _Str)
+  {
+    if (Char == '\\' || Char == '%' || Char == '_')
+      Escaped += '\\';
+    Escaped += Char;
+  }
+  return Escaped;
+}
+
+} // namespace
+
+QueryBuilder::QueryBuilder(
+    std::string _Select
+  ) :
+    m_Select{ std::move(_Select) }
+{
+}
+
+QueryBuilder & QueryBuilder::Where(
+    const std::string & _Condition,
+    std::vector<Value> _Values
+  )
+{
+  std::string Condition;
+  std::size_t BindIdx = m_Values.size();
+
+  for (const char Char : _Condition)
+  {
+    if (Char == '?')
+      Condition += ":" + std::to_string(++BindIdx);
+    else
+      Condition += Char;
+  }
+
+  m_Conditions.push_back("(" + Condition + ")");
+  m_Values.insert(m_Values.end(), std::make_move_iterator(_Values.begin()), std::make_move_iterator(_Values.end()));
+  return *this;
+}
+
+QueryBuilder & QueryBuilder::OrderBy(
+    const std::string & _Column,
+    ImGuiSortDirection _SortDir
+  )
+{
+  m_OrderBy.push_back(_Column + (_SortDir == ImGuiSortDirection_Descending ? " DESC" : " ASC"));
+  return *this;
+}
+
+QueryBuilder & QueryBuilder::Limit(
+    int _Rows
+  )
+{
+  m_Limit = _Rows;
+  return *this;
+}
+
+std::string QueryBuilder::GetSql() const
+{
+  std::string Sql = m_Select;
+
+  for (std::size_t i = 0; i < m_Conditions.size(); ++i)
+    Sql += (i == 0 ? " WHERE " : " AND ") + m_Conditions[i];
+
+  for (std::size_t i = 0; i < m_OrderBy.size(); ++i)
+    Sql += (i == 0 ? " ORDER BY " : ", ") + m_OrderBy[i];
+
+  if (m_Limit > 0)
+    Sql += " FETCH FIRST " + std::to_string(m_Limit) + " ROWS ONLY";
+
+  return Sql;
+}
+
+void QueryBuilder::Bind(
+    oci::Statement * _Stmt
+  ) const
+{
+  for (std::size_t i = 0; i < m_Values.size(); ++i)
+  {
+    const auto Idx = static_cast<unsigned int>(i + 1);
+    std::visit([&](const auto & _Value)
+    {
+      using TValue = std::decay_t<decltype(_Value)>;
+      if constexpr (std::is_same_v<TValue, int>)
+        _Stmt->setInt(Idx, _Value);
+      else if constexpr (std::is_same_v<TValue, float>)
+        _Stmt->setFloat(Idx, _Value);
+      else if constexpr (std::is_same_v<TValue, std::string>)
+        _Stmt->setString(Idx, _Value);
+      else
+        _Stmt->setDate(Idx, _Value);
+    }, m_Values[i]);
+  }
+}
+
+void ApplyOrderFilter(
+    QueryBuilder & _Query,
+    const OrderFilter & _Filter
+  )
+{
+  if (_Filter.Statuses.size() < ORDER_STATUS_LIST.size())
+  {
+    if (_Filter.Statuses.empty())
+    {
+      _Query.Where("1 = 0");
+    }
+    else
+    {
+      std::string Condition = "o.status IN (";
+      std::vector<QueryBuilder::Value> Values;
+      for (const auto Status : _Filter.Statuses)
+      {
+        Condition += Values.empty() ? "?" : ", ?";
+        Values.emplace_back(ORDER_STATUS_TO_STRING.at(Status));
+      }
+      _Query.Where(Condition + ")", std::move(Values));
+    }
+  }
+
+  if (_Filter.From)
+    _Query.Where("o.order_date >= ?", { *_Filter.From });
+  if (_Filter.To)
+    _Query.Where("o.order_date < ? + 1", { *_Filter.To });
+  if (_Filter.CustomerId)
+    _Query.Where("o.customer_id = ?", { *_Filter.CustomerId });
+  if (_Filter.ProductId)
+    _Query.Where("o.product_id = ?", { *_Filter.ProductId });
+
+  if (!_Filter.Search.empty())
+  {
+    const auto Pattern = "%" + EscapeLike(ToUpper(_Filter.Search)) + "%";
+    _Query.Where("UPPER(c.first_name || ' ' || c.last_name) LIKE ? ESCAPE '\\' OR UPPER(p.product_name) LIKE ? ESCAPE '\\'", { Pattern, Pattern });
+  }
+}
+
+bool IsOrderSuitable(
+    const OrderFilter & _Filter,
+    EOrderStatus _Status,
+    const oci::Date & _Date,
+    int _CustomerId,
+    int _ProductId,
+    const std::string & _CustomerName,
+    const std::string & _ProductName
+  )
+{
+  if (std::find(_Filter.Statuses.begin(), _Filter.Statuses.end(), _Status) == _Filter.Statuses.end())
+    return false;
+
+  // The upper bound is inclusive for the whole day, as in the SQL
+  if (_Filter.From && _Date < *_Filter.From)
+    return false;
+  if (_Filter.To && _Date.toText("YYYYMMDD") > _Filter.To->toText("YYYYMMDD"))
+    return false;
+
+  if (_Filter.CustomerId && _CustomerId != *_Filter.CustomerId)
+    return false;
+  if (_Filter.ProductId && _ProductId != *_Filter.ProductId)
+    return false;
+
+  if (!_Filter.Search.empty())
+  {
+    const auto Search = ToUpper(_Filter.Search);
+    return ToUpper(_CustomerName).find(Search) != std::string::npos
+        || ToUpper(_ProductName).find(Search) != std::string::npos;
+  }
+
+  return true;
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "ISLabApp.h"
+
+#include <imgui.h>
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
+// Parameterized SELECT assembled from UI state.
+// Conditions mark bind variables with '?', they are numbered in the order the conditions are added.
+class QueryBuilder
+{
+public:
+
+  using Value = std::variant<int, float, std::string, oci::Date>;
+
+  explicit QueryBuilder(
+      std::string _Select
+    );
+
+  QueryBuilder & Where(
+      const std::string & _Condition,
+      std::vector<Value> _Values = {}
+    );
+
+  QueryBuilder & OrderBy(
+      const std::string & _Column,
+      ImGuiSortDirection _SortDir
+    );
+
+  QueryBuilder & Limit(
+      int _Rows
+    );
+
+  std::string GetSql() const;
+
+  // The statement must be prepared from GetSql() of this builder
+  void Bind(
+      oci::Statement * _Stmt
+    ) const;
+
+private:
+
+  std::string m_Select;
+  std::vector<std::string> m_Conditions;
+  std::vector<std::string> m_OrderBy;
+  std::vector<Value> m_Values;
+  int m_Limit = 0;
+};
+
+// Columns of the orders table in the order of the orders window
+inline const std::vector<std::string> ORDERS_SORT_COLUMNS {
+    "order_id", "customer_id", "status", "order_date", "product_id", "quantity"
+  };
+
+struct OrderFilter
+{
+  std::vector<EOrderStatus> Statuses;
+  std::optional<oci::Date> From;
+  std::optional<oci::Date> To;
+  std::optional<int> CustomerId;
+  std::optional<int> ProductId;
+  std::string Search; // customer or product name, case insensitive
+};
+
+// Adds the filter to a query over orders o joined with customers c and products p
+void ApplyOrderFilter(
+    QueryBuilder & _Query,
+    const OrderFilter & _Filter
+  );
+
+bool IsOrderSuitable(
+    const OrderFilter & _Filter,
+    EOrderStatus _Status,
+    const oci::Date & _Date,
+    int _CustomerId,
+    int _ProductId,
+    const std::string & _CustomerName,
+    const std::string & _ProductName
+  );
+
+// Tables up to this size are filtered and sorted on the client once they are cached
+inline constexpr std::size_t PUSHDOWN_ROW_THRESHOLD = 20000;
+
+// Work goes to the server when the client does not hold every row or would have to scan too many of them
+inline bool ShouldPushDown(
+    std::size_t _CachedRows,
+    std::size_t _TotalRows
+  )
+{
+  return _CachedRows < _TotalRows || _TotalRows > PUSHDOWN_ROW_THRESHOLD;
+}
\ No newline at end of file
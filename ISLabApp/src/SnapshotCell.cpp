@@ -0,0 +1,35 @@
+#include "SnapshotCell.h"
+
+namespace
+{
+
+// Pushed by any thread, only ever emptied as a whole, so no node is popped while another thread reads it
+std::atomic<RetiredSnapshot *> & GetRetired()
+{
+  static std::atomic<RetiredSnapshot *> Retired{ nullptr };
+  return Retired;
+}
+
+} // namespace
+
+void RetireSnapshot(
+    RetiredSnapshot * _Retired
+  )
+{
+  auto & Retired = GetRetired();
+
+  _Retired->NextRetired = Retired.load(std::memory_order_relaxed);
+  while (!Retired.compare_exchange_weak(_Retired->NextRetired, _Retired, std::memory_order_release, std::memory_order_relaxed))
+    ;
+}
+
+void ReclaimSnapshots()
+{
+  auto * Retired = GetRetired().exchange(nullptr, std::memory_order_acquire);
+  while (Retired)
+  {
+    auto * Next = Retired->NextRetired;
+    delete Retired;
+    Retired = Next;
+  }
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+template<typename T>
+using Snapshot = std::shared_ptr<const T>;
+
+// A version replaced in a SnapshotCell, kept until ReclaimSnapshots
+struct RetiredSnapshot
+{
+  virtual ~RetiredSnapshot() = default;
+
+  RetiredSnapshot * NextRetired = nullptr;
+};
+
+// Callable from any thread, never blocks
+void RetireSnapshot(
+    RetiredSnapshot * _Retired
+  );
+
+// Frees the versions retired so far. The UI thread calls it once per frame before any cell is read,
+// the reads of the previous frame are over by then.
+void ReclaimSnapshots();
+
+// Latest version of a value, published and read by the UI thread without locks.
+// Not safe to publish from other threads, Edit reuses the current version while only the cell holds it.
+// A new version replaces the current one with an atomic pointer swap.
+// Versions are reference counted, a reader holding one keeps it alive after it is replaced and unchanged.
+template<typename T>
+class SnapshotCell
+{
+public:
+
+  SnapshotCell() :
+      m_Current{ new Version(std::make_shared<T>()) }
+  {
+  }
+
+  ~SnapshotCell()
+  {
+    delete m_Current.load();
+  }
+
+  SnapshotCell(const SnapshotCell &) = delete;
+  SnapshotCell & operator=(const SnapshotCell &) = delete;
+
+  // UI thread only
+  void Publish(
+      std::shared_ptr<T> _Value
+    )
+  {
+    RetireSnapshot(m_Current.exchange(new Version(std::move(_Value)), std::memory_order_acq_rel));
+  }
+
+  // UI thread only, the replaced version is freed at a frame boundary and the copy must be done by then
+  Snapshot<T> Read() const
+  {
+    return m_Current.load(std::memory_order_acquire)->Value;
+  }
+
+  // Owner only, on the UI thread. The current version without holding it, valid until the next Edit or Publish.
+  const T & Get() const
+  {
+    return *m_Current.load(std::memory_order_acquire)->Value;
+  }
+
+  // Owner only, on the UI thread. The current version is edited in place while no reader holds it,
+  // otherwise a copy of it is published and edited.
+  T & Edit()
+  {
+    auto * Current = m_Current.load(std::memory_order_acquire);
+    if (Current->Value.use_count() != 1)
+    {
+      Publish(std::make_shared<T>(*Current->Value));
+      Current = m_Current.load(std::memory_order_acquire);
+    }
+    return *Current->Value;
+  }
+
+private:
+
+  struct Version
+    : RetiredSnapshot
+  {
+    explicit Version(
+        std::shared_ptr<T> _Value
+      ) :
+        Value{ std::move(_Value) }
+    {
+    }
+
+    const std::shared_ptr<T> Value;
+  };
+
+  std::atomic<Version *> m_Current;
+};
\ No newline at end of file
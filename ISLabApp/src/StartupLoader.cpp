@@ -0,0 +1,113 @@
+#include "StartupLoader.h"
+
+#include <Walnut/Application.h>
+
+StartupLoader::StartupLoader(
+    oci::Environment * _Env,
+    std::string _UserName,
+    std::string _Password,
+    std::string _ConnectString
+  ) :
+    m_Env{ _Env },
+    m_UserName{ std::move(_UserName) },
+    m_Password{ std::move(_Password) },
+    m_ConnectString{ std::move(_ConnectString) }
+{
+}
+
+StartupLoader::~StartupLoader()
+{
+  for (auto & [Window, Job] : m_Jobs)
+    if (Job.Done.valid())
+      Job.Done.wait();
+}
+
+bool StartupLoader::IsLoading(
+    std::type_index _Window
+  ) const
+{
+  return m_Jobs.find(_Window) != m_Jobs.end();
+}
+
+bool StartupLoader::IsFetching() const
+{
+  for (const auto & [Window, Job] : m_Jobs)
+    if (Job.Done.valid() && Job.Done.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+      return true;
+  return false;
+}
+
+const std::string * StartupLoader::GetVersion(
+    std::type_index _Window
+  ) const
+{
+  const auto It = m_Versions.find(_Window);
+  return It != m_Versions.end() ? &It->second : nullptr;
+}
+
+void StartupLoader::WakeMainLoop()
+{
+  Walnut::Application::PostWakeEvent();
+}
+
+std::string StartupLoader::GetVersionQuery(
+    const char * _TableName
+  )
+{
+  return std::string("SELECT TO_CHAR(NVL(MAX(ORA_ROWSCN), 0)) || ':' || TO_CHAR(COUNT(*)) FROM ") + _TableName;
+}
+
+void StartupLoader::FetchConsistent(
+    const std::vector<ConsistentFetch> & _Fetches
+  )
+{
+  WL_TRACE_SCOPE_CAT("sql", __FUNCTION__);
+
+  // A read-only transaction reads every query as of its start, so all cursors see one SCN
+  // however long fetching them takes. The version of each table is read in it too.
+  std::string Sql = "BEGIN SET TRANSACTION READ ONLY;";
+  for (std::size_t i = 0; i < _Fetches.size(); ++i)
+  {
+    Sql += " OPEN :" + std::to_string(2 * i + 1) + " FOR " + GetVersionQuery(_Fetches[i].TableName) + ";";
+    Sql += " OPEN :" + std::to_string(2 * i + 2) + " FOR " + _Fetches[i].Sql + ";";
+  }
+  Sql += " END;";
+
+  auto * Conn = m_Env->createConnection(m_UserName, m_Password, m_ConnectString);
+
+  try
+  {
+    DBStatement Stmt(Conn, Sql);
+    for (unsigned int Idx = 1; Idx <= 2 * _Fetches.size(); ++Idx)
+      Stmt->registerOutParam(Idx, oci::OCCICURSOR);
+    Stmt.ExecuteUpdate();
+
+    for (std::size_t i = 0; i < _Fetches.size(); ++i)
+    {
+      auto & State = *_Fetches[i].State;
+
+      Table<std::string> Version;
+      auto VersionCursor = Stmt.GetCursor(static_cast<unsigned int>(2 * i + 1));
+      Stmt.FetchInto(VersionCursor, Version, [](oci::ResultSet * _Result)
+      {
+        return std::make_tuple(_Result->getString(1));
+      });
+
+      State.Version = Version.empty() ? std::string() : std::get<0>(Version.front());
+      State.IsChanged = true;
+
+      auto RowsCursor = Stmt.GetCursor(static_cast<unsigned int>(2 * i + 2));
+      _Fetches[i].Read(Stmt, RowsCursor);
+    }
+
+    // Ends the read-only transaction
+    Stmt.Commit();
+  }
+  catch (const oci::SQLException &)
+  {
+    m_Env->terminateConnection(Conn);
+    throw;
+  }
+
+  m_Env->terminateConnection(Conn);
+}
\ No newline at end of file
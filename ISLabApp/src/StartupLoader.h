@@ -0,0 +1,296 @@
+#pragma once
+
+#include "ISLabApp.h"
+#include "DBStatement.h"
+#include "TableSnapshot.h"
+
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+// Fetches the tables of the table windows concurrently, each on a worker thread with its own session.
+// Windows take their rows with Take and hand them to SetTable instead of querying on the UI thread.
+// A table restored from the snapshot is handed out at once by TakeCached, the worker then only compares
+// its version with the server and fetches the rows if it changed.
+// The environment must be created with THREADED_MUTEXED.
+class StartupLoader
+{
+public:
+
+  StartupLoader(
+      oci::Environment * _Env,
+      std::string _UserName,
+      std::string _Password,
+      std::string _ConnectString
+    );
+
+  // Waits for the fetches still running
+  ~StartupLoader();
+
+  StartupLoader(const StartupLoader &) = delete;
+  StartupLoader & operator=(const StartupLoader &) = delete;
+
+  // Starts fetching TWindow::UPDATE_QUERY decoded with TWindow::ReadRow, _Cached is the snapshot section of the table
+  template<typename TWindow>
+  void Load(
+      std::string_view _Cached = {}
+    );
+
+  // Fetches the tables of all TWindows in one read-only transaction on one session, so they are read at the same SCN.
+  // A single block opens a cursor per table, the rows are taken with Take as if each table was loaded by itself.
+  template<typename ... TWindows>
+  void LoadConsistent();
+
+  bool IsLoading(
+      std::type_index _Window
+    ) const;
+
+  // Some fetch has not finished yet, results finished but not taken do not count
+  bool IsFetching() const;
+
+  // Rows of a finished fetch, each result is handed out once.
+  // A failed fetch yields nothing, the window then loads the table itself and reports the error.
+  // Nothing is handed out when the snapshot rows are still current.
+  template<typename TWindow, typename TTable = decltype(std::declval<TWindow>().GetTable())>
+  std::optional<std::decay_t<TTable>> Take();
+
+  // Rows restored from the snapshot, handed out once
+  template<typename TWindow, typename TTable = decltype(std::declval<TWindow>().GetTable())>
+  std::optional<std::decay_t<TTable>> TakeCached();
+
+  // Server version of the rows handed out last, nullptr until the fetch finished
+  const std::string * GetVersion(
+      std::type_index _Window
+    ) const;
+
+  // Version of the rows of a table, cheap compared to fetching them.
+  // ORA_ROWSCN of the newest block changes with every insert and update, the count catches deletes.
+  static std::string GetVersionQuery(
+      const char * _TableName
+    );
+
+private:
+
+  struct JobState
+  {
+    std::shared_ptr<void> Rows;
+    std::string Version;
+    bool IsChanged = true;
+  };
+
+  struct Job
+  {
+    // Shared by the tables of one LoadConsistent
+    std::shared_future<void> Done;
+    std::shared_ptr<JobState> State;
+  };
+
+  struct ConsistentFetch
+  {
+    std::type_index Window;
+    const char * TableName;
+    const char * Sql;
+    std::shared_ptr<JobState> State;
+    std::function<void(DBStatement &, DBResultSet &)> Read;
+  };
+
+  // Lets the UI loop pick up a finished fetch without waiting for input
+  static void WakeMainLoop();
+
+  template<typename TTable, typename TReader>
+  void Fetch(
+      const char * _TableName,
+      const char * _Sql,
+      TReader _Reader,
+      const std::string & _CachedVersion,
+      JobState & _State
+    );
+
+  template<typename TWindow>
+  static ConsistentFetch MakeConsistentFetch();
+
+  void FetchConsistent(
+      const std::vector<ConsistentFetch> & _Fetches
+    );
+
+  oci::Environment * m_Env = nullptr;
+  std::string m_UserName;
+  std::string m_Password;
+  std::string m_ConnectString;
+
+  std::unordered_map<std::type_index, Job> m_Jobs;
+  std::unordered_map<std::type_index, std::string_view> m_Cached;
+  std::unordered_map<std::type_index, std::string> m_Versions;
+};
+
+template<typename TWindow>
+void StartupLoader::Load(
+    std::string_view _Cached
+  )
+{
+  using TTable = std::decay_t<decltype(std::declval<TWindow>().GetTable())>;
+
+  std::string CachedVersion;
+  if (!_Cached.empty())
+  {
+    m_Cached[typeid(TWindow)] = _Cached;
+    CachedVersion = ReadSnapshotVersion(_Cached);
+  }
+
+  auto State = std::make_shared<JobState>();
+  State->Rows = std::make_shared<TTable>();
+
+  auto & Job = m_Jobs[typeid(TWindow)];
+  Job.State = State;
+  Job.Done = std::async(std::launch::async, [this, State, CachedVersion]()
+  {
+    try
+    {
+      Fetch<TTable>(TWindow::TABLE_NAME, TWindow::UPDATE_QUERY, &TWindow::ReadRow, CachedVersion, *State);
+    }
+    catch (const oci::SQLException &)
+    {
+      WakeMainLoop();
+      throw;
+    }
+    WakeMainLoop();
+  }).share();
+}
+
+template<typename ... TWindows>
+void StartupLoader::LoadConsistent()
+{
+  std::vector<ConsistentFetch> Fetches{ MakeConsistentFetch<TWindows>()... };
+
+  const auto Done = std::async(std::launch::async, [this, Fetches]()
+  {
+    try
+    {
+      FetchConsistent(Fetches);
+    }
+    catch (const oci::SQLException &)
+    {
+      WakeMainLoop();
+      throw;
+    }
+    WakeMainLoop();
+  }).share();
+
+  for (const auto & Fetch : Fetches)
+    m_Jobs[Fetch.Window] = Job{ Done, Fetch.State };
+}
+
+template<typename TWindow>
+StartupLoader::ConsistentFetch StartupLoader::MakeConsistentFetch()
+{
+  using TTable = std::decay_t<decltype(std::declval<TWindow>().GetTable())>;
+
+  auto Rows = std::make_shared<TTable>();
+  auto State = std::make_shared<JobState>();
+  State->Rows = Rows;
+
+  return ConsistentFetch{
+      typeid(TWindow),
+      TWindow::TABLE_NAME,
+      TWindow::UPDATE_QUERY,
+      std::move(State),
+      [Rows](DBStatement & _Stmt, DBResultSet & _Result)
+      {
+        _Stmt.FetchInto(_Result, *Rows, &TWindow::ReadRow);
+      }
+    };
+}
+
+template<typename TWindow, typename TTable>
+std::optional<std::decay_t<TTable>> StartupLoader::Take()
+{
+  const auto It = m_Jobs.find(typeid(TWindow));
+  if (It == m_Jobs.end() || It->second.Done.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    return std::nullopt;
+
+  auto Job = std::move(It->second);
+  m_Jobs.erase(It);
+
+  try
+  {
+    Job.Done.get();
+  }
+  catch (const oci::SQLException &)
+  {
+    return std::nullopt;
+  }
+
+  // Cached rows not taken yet are current or superseded, either way they are not needed anymore
+  m_Cached.erase(typeid(TWindow));
+  m_Versions[typeid(TWindow)] = Job.State->Version;
+
+  if (!Job.State->IsChanged)
+    return std::nullopt;
+
+  return std::move(*std::static_pointer_cast<std::decay_t<TTable>>(Job.State->Rows));
+}
+
+template<typename TWindow, typename TTable>
+std::optional<std::decay_t<TTable>> StartupLoader::TakeCached()
+{
+  const auto It = m_Cached.find(typeid(TWindow));
+  if (It == m_Cached.end())
+    return std::nullopt;
+
+  const auto Section = It->second;
+  m_Cached.erase(It);
+
+  std::decay_t<TTable> Rows;
+  if (!DecodeSnapshotTable(Section, m_Env, Rows))
+    return std::nullopt;
+
+  return Rows;
+}
+
+template<typename TTable, typename TReader>
+void StartupLoader::Fetch(
+    const char * _TableName,
+    const char * _Sql,
+    TReader _Reader,
+    const std::string & _CachedVersion,
+    JobState & _State
+  )
+{
+  WL_TRACE_SCOPE_CAT("sql", _Sql);
+
+  auto * Conn = m_Env->createConnection(m_UserName, m_Password, m_ConnectString);
+
+  try
+  {
+    // Read before the rows, a change in between only makes the next start fetch again
+    Table<std::string> Version;
+    DBStatement VersionStmt(Conn, GetVersionQuery(_TableName));
+    VersionStmt.FetchInto(Version, [](oci::ResultSet * _Result)
+    {
+      return std::make_tuple(_Result->getString(1));
+    });
+
+    _State.Version = Version.empty() ? std::string() : std::get<0>(Version.front());
+    _State.IsChanged = _CachedVersion.empty() || _State.Version != _CachedVersion;
+
+    // Statements are terminated before their session
+    if (_State.IsChanged)
+    {
+      DBStatement Stmt(Conn, _Sql);
+      Stmt.FetchInto(*std::static_pointer_cast<TTable>(_State.Rows), _Reader);
+    }
+  }
+  catch (const oci::SQLException &)
+  {
+    m_Env->terminateConnection(Conn);
+    throw;
+  }
+
+  m_Env->terminateConnection(Conn);
+}
\ No newline at end of file
@@ -0,0 +1,344 @@
+#include "TableExport.h"
+
+#include "DBStatement.h"
+
+#include <Walnut/Application.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+
+constexpr const char * DATE_FORMAT_SQL = "ALTER SESSION SET NLS_DATE_FORMAT = 'YYYY-MM-DD HH24:MI:SS'";
+
+struct ExportColumn
+{
+  std::string Name;
+  bool IsNumber;
+};
+
+std::vector<ExportColumn> ReadColumns(
+    oci::ResultSet * _Result
+  )
+{
+  std::vector<ExportColumn> Columns;
+  for (const auto & Meta : _Result->getColumnListMetaData())
+  {
+    auto Name = Meta.getString(oci::MetaData::ATTR_NAME);
+    std::transform(Name.begin(), Name.end(), Name.begin(), [](unsigned char _Char)
+    {
+      return static_cast<char>(std::tolower(_Char));
+    });
+    Columns.push_back(ExportColumn{ std::move(Name), Meta.getInt(oci::MetaData::ATTR_DATA_TYPE) == oci::OCCI_SQLT_NUM });
+  }
+  return Columns;
+}
+
+void AppendCsv(
+    std::string & _Line,
+    const std::string & _Value
+  )
+{
+  if (_Value.find_first_of(",\"\r\n") == std::string::npos)
+  {
+    _Line += _Value;
+    return;
+  }
+
+  _Line += '"';
+  for (const char Char : _Value)
+  {
+    if (Char == '"')
+      _Line += '"';
+    _Line += Char;
+  }
+  _Line += '"';
+}
+
+void AppendJsonString(
+    std::string & _Line,
+    const std::string & _Value
+  )
+{
+  _Line += '"';
+  for (const char Char : _Value)
+  {
+    switch (Char)
+    {
+    case '"':  _Line += "\\\""; break;
+    case '\\': _Line += "\\\\"; break;
+    case '\n': _Line += "\\n"; break;
+    case '\r': _Line += "\\r"; break;
+    case '\t': _Line += "\\t"; break;
+    default:
+      if (static_cast<unsigned char>(Char) < 0x20)
+      {
+        char Escaped[8];
+        std::snprintf(Escaped, sizeof(Escaped), "\\u%04x", static_cast<unsigned int>(Char));
+        _Line += Escaped;
+      }
+      else
+      {
+        _Line += Char;
+      }
+    }
+  }
+  _Line += '"';
+}
+
+// Oracle drops the leading zero of fractions, JSON needs it
+void AppendJsonNumber(
+    std::string & _Line,
+    const std::string & _Value
+  )
+{
+  const bool IsNegative = !_Value.empty() && _Value[0] == '-';
+  const std::size_t Digits = IsNegative ? 1 : 0;
+
+  if (IsNegative)
+    _Line += '-';
+  if (_Value.size() > Digits && _Value[Digits] == '.')
+    _Line += '0';
+  _Line.append(_Value, Digits, std::string::npos);
+}
+
+void AppendRow(
+    std::string & _Line,
+    oci::ResultSet * _Result,
+    const std::vector<ExportColumn> & _Columns,
+    EExportFormat _Format
+  )
+{
+  for (unsigned int i = 0; i < _Columns.size(); ++i)
+  {
+    const bool IsNull = _Result->isNull(i + 1);
+
+    if (_Format == EExportFormat::CSV)
+    {
+      if (i != 0)
+        _Line += ',';
+      if (!IsNull)
+        AppendCsv(_Line, _Result->getString(i + 1));
+      continue;
+    }
+
+    _Line += (i == 0) ? '{' : ',';
+    AppendJsonString(_Line, _Columns[i].Name);
+    _Line += ':';
+
+    if (IsNull)
+      _Line += "null";
+    else if (_Columns[i].IsNumber)
+      AppendJsonNumber(_Line, _Result->getString(i + 1));
+    else
+      AppendJsonString(_Line, _Result->getString(i + 1));
+  }
+
+  if (_Format == EExportFormat::JSONL)
+    _Line += '}';
+  _Line += '\n';
+}
+
+} // namespace
+
+double ExportProgress::GetRowsPerSecond() const
+{
+  return ElapsedSeconds > 0.0 ? Rows / ElapsedSeconds : 0.0;
+}
+
+TableExport::TableExport(
+    oci::Environment * _Env,
+    std::string _UserName,
+    std::string _Password,
+    std::string _ConnectString
+  ) :
+    m_Env{ _Env },
+    m_UserName{ std::move(_UserName) },
+    m_Password{ std::move(_Password) },
+    m_ConnectString{ std::move(_ConnectString) }
+{
+}
+
+TableExport::~TableExport()
+{
+  Cancel();
+  if (m_Done.valid())
+    m_Done.wait();
+}
+
+void TableExport::Start(
+    ExportOptions _Options
+  )
+{
+  if (IsRunning())
+    return;
+
+  m_IsCancelled = false;
+  Begin();
+
+  m_Done = std::async(std::launch::async, [this, Options = std::move(_Options)]()
+  {
+    oci::Connection * Conn = nullptr;
+    try
+    {
+      Conn = m_Env->createConnection(m_UserName, m_Password, m_ConnectString);
+    }
+    catch (const oci::SQLException & ex)
+    {
+      return Finish(ex.what());
+    }
+
+    Run(Conn, Options);
+    m_Env->terminateConnection(Conn);
+  });
+}
+
+void TableExport::Cancel()
+{
+  m_IsCancelled = true;
+}
+
+bool TableExport::IsRunning() const
+{
+  return m_Done.valid() && m_Done.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+}
+
+ExportProgress TableExport::GetProgress() const
+{
+  std::scoped_lock Lock(m_Mutex);
+
+  ExportProgress Progress = m_Progress;
+  if (Progress.IsRunning)
+    Progress.ElapsedSeconds = std::chrono::duration<double>(Clock::now() - m_StartTime).count();
+
+  return Progress;
+}
+
+const char * TableExport::GetExtension(
+    EExportFormat _Format
+  )
+{
+  return _Format == EExportFormat::CSV ? ".csv" : ".jsonl";
+}
+
+void TableExport::Run(
+    oci::Connection * _Conn,
+    const ExportOptions & _Options
+  )
+{
+  WL_TRACE_SCOPE_CAT("sql", __FUNCTION__);
+
+  const auto BatchSize = static_cast<unsigned int>(std::clamp(_Options.BatchSize, 1, MAX_BATCH_SIZE));
+  const auto TempPath = _Options.Path + ".part";
+
+  std::ofstream Out(TempPath, std::ios::binary | std::ios::trunc);
+  if (!Out)
+    return Finish("Cannot write " + TempPath);
+
+  std::uint64_t Rows = 0;
+  std::uint64_t Bytes = 0;
+
+  try
+  {
+    DBStatement DateFormatStmt(_Conn, DATE_FORMAT_SQL);
+    DateFormatStmt.ExecuteUpdate();
+
+    DBStatement Stmt(_Conn, _Options.Query.GetSql());
+    _Options.Query.Bind(Stmt.Get());
+    Stmt->setPrefetchRowCount(BatchSize);
+
+    auto Result = Stmt.ExecuteQuery();
+    const auto Columns = ReadColumns(Result.Get());
+
+    // Reused for every row, so the export allocates only while lines keep getting longer
+    std::string Line;
+
+    if (_Options.Format == EExportFormat::CSV)
+    {
+      for (std::size_t i = 0; i < Columns.size(); ++i)
+      {
+        if (i != 0)
+          Line += ',';
+        AppendCsv(Line, Columns[i].Name);
+      }
+      Line += '\n';
+      Out.write(Line.data(), static_cast<std::streamsize>(Line.size()));
+      Bytes += Line.size();
+    }
+
+    while (!m_IsCancelled && Result.Next())
+    {
+      Line.clear();
+      AppendRow(Line, Result.Get(), Columns, _Options.Format);
+      Out.write(Line.data(), static_cast<std::streamsize>(Line.size()));
+      Bytes += Line.size();
+
+      if (++Rows % BatchSize == 0)
+        Report(Rows, Bytes);
+    }
+  }
+  catch (const oci::SQLException & ex)
+  {
+    Out.close();
+    std::remove(TempPath.c_str());
+    return Finish(ex.what());
+  }
+
+  Report(Rows, Bytes);
+  Out.close();
+
+  if (m_IsCancelled || !Out)
+  {
+    std::remove(TempPath.c_str());
+    return Finish(m_IsCancelled ? "Cancelled" : "Failed to write " + TempPath);
+  }
+
+  // POSIX rename replaces the old file atomically, Windows refuses to rename over an existing one
+#ifdef _WIN32
+  std::remove(_Options.Path.c_str());
+#endif
+  if (std::rename(TempPath.c_str(), _Options.Path.c_str()) != 0)
+    return Finish("Failed to rename " + TempPath);
+
+  Finish("");
+}
+
+void TableExport::Begin()
+{
+  std::scoped_lock Lock(m_Mutex);
+
+  m_Progress = ExportProgress();
+  m_Progress.IsRunning = true;
+  m_StartTime = Clock::now();
+}
+
+void TableExport::Report(
+    std::uint64_t _Rows,
+    std::uint64_t _Bytes
+  )
+{
+  std::scoped_lock Lock(m_Mutex);
+
+  m_Progress.Rows = _Rows;
+  m_Progress.Bytes = _Bytes;
+}
+
+void TableExport::Finish(
+    std::string _Error
+  )
+{
+  {
+    std::scoped_lock Lock(m_Mutex);
+
+    m_Progress.ElapsedSeconds = std::chrono::duration<double>(Clock::now() - m_StartTime).count();
+    m_Progress.IsRunning = false;
+    m_Progress.IsDone = true;
+    m_Progress.Error = std::move(_Error);
+  }
+
+  // Shows the result right away instead of at the next progress poll
+  Walnut::Application::PostWakeEvent();
+}
\ No newline at end of file
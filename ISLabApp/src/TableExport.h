@@ -0,0 +1,110 @@
+#pragma once
+
+#include "ISLabApp.h"
+#include "QueryBuilder.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <string>
+
+enum class EExportFormat
+{
+  CSV,
+  JSONL
+};
+
+struct ExportOptions
+{
+  QueryBuilder Query{ "" };
+  std::string Path;
+  EExportFormat Format = EExportFormat::CSV;
+
+  // Rows fetched per round trip
+  int BatchSize = 1000;
+};
+
+struct ExportProgress
+{
+  std::uint64_t Rows = 0;
+  std::uint64_t Bytes = 0;
+  double ElapsedSeconds = 0.0;
+  bool IsRunning = false;
+  bool IsDone = false;
+
+  std::string Error;
+
+  double GetRowsPerSecond() const;
+};
+
+// Writes the rows of a query to a file as they arrive from the server cursor, without keeping them.
+// Columns are named after the select list, dates are written as YYYY-MM-DD HH24:MI:SS.
+// The file appears under its name only once complete, a failed or cancelled export leaves nothing behind.
+class TableExport
+{
+public:
+
+  static constexpr int MAX_BATCH_SIZE = 10000;
+
+  TableExport(
+      oci::Environment * _Env,
+      std::string _UserName,
+      std::string _Password,
+      std::string _ConnectString
+    );
+
+  // Cancels the running export and waits for it
+  ~TableExport();
+
+  TableExport(const TableExport &) = delete;
+  TableExport & operator=(const TableExport &) = delete;
+
+  // Exports on a worker thread with its own session, the environment must be created with THREADED_MUTEXED
+  void Start(
+      ExportOptions _Options
+    );
+
+  void Cancel();
+
+  bool IsRunning() const;
+
+  ExportProgress GetProgress() const;
+
+  static const char * GetExtension(
+      EExportFormat _Format
+    );
+
+private:
+
+  void Run(
+      oci::Connection * _Conn,
+      const ExportOptions & _Options
+    );
+
+  void Begin();
+
+  void Report(
+      std::uint64_t _Rows,
+      std::uint64_t _Bytes
+    );
+
+  void Finish(
+      std::string _Error
+    );
+
+  using Clock = std::chrono::steady_clock;
+
+  oci::Environment * m_Env = nullptr;
+  std::string m_UserName;
+  std::string m_Password;
+  std::string m_ConnectString;
+
+  std::future<void> m_Done;
+  std::atomic<bool> m_IsCancelled{ false };
+
+  mutable std::mutex m_Mutex;
+  ExportProgress m_Progress;
+  Clock::time_point m_StartTime;
+};
\ No newline at end of file
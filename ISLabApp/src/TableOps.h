@@ -0,0 +1,41 @@
+#pragma once
+
+#include "ISLabApp.h"
+
+#include <algorithm>
+#include <tuple>
+#include <utility>
+
+// Tables are plain vectors, so patching a row costs O(n): the rows after it are moved, and finding it by key is a scan.
+// A patch follows a server round trip, which costs far more than moving the rows, while every frame iterates the tables.
+
+// Inserts _Row keeping _Table ordered by _Predicate, _Table must already be sorted by it
+template<typename ... TArgs>
+void InsertSorted(
+    Table<TArgs...> & _Table,
+    std::tuple<TArgs...> _Row,
+    const PredicateImpl<TArgs...> & _Predicate
+  )
+{
+  const auto It = std::upper_bound(_Table.begin(), _Table.end(), _Row, _Predicate);
+  _Table.insert(It, std::move(_Row));
+}
+
+// Erases the first row whose column KeyIdx equals _Key
+template<int KeyIdx, typename TKey, typename ... TArgs>
+bool EraseByKey(
+    Table<TArgs...> & _Table,
+    const TKey & _Key
+  )
+{
+  const auto It = std::find_if(_Table.begin(), _Table.end(), [&](const auto & _Row)
+  {
+    return std::get<KeyIdx>(_Row) == _Key;
+  });
+
+  if (It == _Table.end())
+    return false;
+
+  _Table.erase(It);
+  return true;
+}
\ No newline at end of file
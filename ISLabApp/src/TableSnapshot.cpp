@@ -0,0 +1,173 @@
+#include "TableSnapshot.h"
+
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+
+constexpr char MAGIC[4] = { 'I', 'S', 'L', 'S' };
+constexpr std::size_t NAME_SIZE = 32;
+
+struct FileHeader
+{
+  char Magic[4];
+  std::uint32_t FormatVersion;
+  std::uint32_t SectionCount;
+  std::uint32_t Reserved;
+  std::uint64_t DirectoryChecksum;
+};
+
+struct DirectoryEntry
+{
+  char Name[NAME_SIZE];
+  std::uint64_t Offset;
+  std::uint64_t Size;
+  std::uint64_t Checksum;
+};
+
+} // namespace
+
+std::uint64_t SnapshotChecksum(
+    std::string_view _Bytes
+  )
+{
+  std::uint64_t Hash = 0xcbf29ce484222325ull;
+  for (const char Byte : _Bytes)
+  {
+    Hash ^= static_cast<unsigned char>(Byte);
+    Hash *= 0x100000001b3ull;
+  }
+  return Hash;
+}
+
+std::string ReadSnapshotVersion(
+    std::string_view _Section
+  )
+{
+  SnapshotCursor In(_Section);
+
+  std::uint32_t RowCount = 0;
+  std::uint32_t ColumnCount = 0;
+  std::uint32_t VersionSize = 0;
+  std::string_view Version;
+
+  if (!In.Get(RowCount) || !In.Get(ColumnCount) || !In.Get(VersionSize) || !In.GetBytes(VersionSize, Version))
+    return {};
+
+  return std::string(Version);
+}
+
+TableSnapshot::TableSnapshot(
+    const std::string & _Path
+  ) :
+    m_File{ std::make_unique<MappedFile>(_Path) }
+{
+  if (!m_File->IsOpen())
+    return;
+
+  const std::string_view Bytes(m_File->GetData(), m_File->GetSize());
+  SnapshotCursor In(Bytes);
+
+  FileHeader Header{};
+  if (!In.Get(Header) || std::memcmp(Header.Magic, MAGIC, sizeof(MAGIC)) != 0 || Header.FormatVersion != FORMAT_VERSION)
+    return;
+
+  std::string_view Directory;
+  if (!In.GetBytes(Header.SectionCount * sizeof(DirectoryEntry), Directory) || SnapshotChecksum(Directory) != Header.DirectoryChecksum)
+    return;
+
+  SnapshotCursor Entries(Directory);
+  for (std::uint32_t i = 0; i < Header.SectionCount; ++i)
+  {
+    DirectoryEntry Entry{};
+    Entries.Get(Entry);
+
+    if (Entry.Offset > Bytes.size() || Entry.Size > Bytes.size() - Entry.Offset)
+      continue;
+
+    // A damaged section is dropped on its own, the others stay usable
+    const auto Section = Bytes.substr(static_cast<std::size_t>(Entry.Offset), static_cast<std::size_t>(Entry.Size));
+    if (SnapshotChecksum(Section) != Entry.Checksum)
+      continue;
+
+    m_Sections.emplace(std::string(Entry.Name, strnlen(Entry.Name, NAME_SIZE)), Section);
+  }
+}
+
+std::string_view TableSnapshot::GetSection(
+    const std::string & _Name
+  ) const
+{
+  const auto It = m_Sections.find(_Name);
+  return It != m_Sections.end() ? It->second : std::string_view();
+}
+
+void TableSnapshot::Close()
+{
+  m_Sections.clear();
+  if (m_File)
+    m_File->Close();
+}
+
+void SnapshotWriter::AddSection(
+    const std::string & _Name,
+    std::string_view _Bytes
+  )
+{
+  if (_Name.size() < NAME_SIZE && !_Bytes.empty())
+    m_Sections.emplace_back(_Name, std::string(_Bytes));
+}
+
+bool SnapshotWriter::Write(
+    const std::string & _Path
+  ) const
+{
+  SnapshotBuffer Directory;
+  std::uint64_t Offset = sizeof(FileHeader) + m_Sections.size() * sizeof(DirectoryEntry);
+
+  for (const auto & [Name, Bytes] : m_Sections)
+  {
+    DirectoryEntry Entry{};
+    std::memcpy(Entry.Name, Name.data(), Name.size());
+    Entry.Offset = Offset;
+    Entry.Size = Bytes.size();
+    Entry.Checksum = SnapshotChecksum(Bytes);
+    Directory.Put(Entry);
+
+    // Sections start 8-byte aligned so fixed-width columns can be read in place
+    Offset = (Offset + Bytes.size() + 7) & ~std::uint64_t{ 7 };
+  }
+
+  FileHeader Header{};
+  std::memcpy(Header.Magic, MAGIC, sizeof(MAGIC));
+  Header.FormatVersion = TableSnapshot::FORMAT_VERSION;
+  Header.SectionCount = static_cast<std::uint32_t>(m_Sections.size());
+  Header.DirectoryChecksum = SnapshotChecksum(Directory.GetBytes());
+
+  const auto TempPath = _Path + ".tmp";
+  {
+    std::ofstream Out(TempPath, std::ios::binary | std::ios::trunc);
+    if (!Out)
+      return false;
+
+    SnapshotBuffer Body;
+    Body.Put(Header);
+    Body.PutBytes(Directory.GetBytes());
+    for (const auto & [Name, Bytes] : m_Sections)
+    {
+      Body.PutBytes(Bytes);
+      Body.Align();
+    }
+
+    Out.write(Body.GetBytes().data(), static_cast<std::streamsize>(Body.GetSize()));
+    if (!Out)
+      return false;
+  }
+
+  // POSIX rename replaces the old file atomically, Windows refuses to rename over an existing one
+#ifdef _WIN32
+  std::remove(_Path.c_str());
+#endif
+  return std::rename(TempPath.c_str(), _Path.c_str()) == 0;
+}
\ No newline at end of file
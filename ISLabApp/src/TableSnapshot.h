@@ -0,0 +1,418 @@
+#pragma once
+
+#include "ISLabApp.h"
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// On-disk copy of the in-memory tables used to populate the windows before the server answers.
+//
+// File:    header, directory of sections, sections. Every section carries an FNV-1a checksum in the directory.
+// Section: row count, column count, server version of the rows, then one column after another, 8-byte aligned.
+// Column:  type tag, byte size, values. Fixed-width values are stored as arrays,
+//          strings as an offset array (row count + 1 entries) followed by the string heap.
+class TableSnapshot
+{
+public:
+
+  static constexpr std::uint32_t FORMAT_VERSION = 1;
+
+  TableSnapshot() = default;
+
+  // Maps the file, a missing or damaged file gives an empty snapshot
+  explicit TableSnapshot(
+      const std::string & _Path
+    );
+
+  // Checksum-verified section, empty when missing
+  std::string_view GetSection(
+      const std::string & _Name
+    ) const;
+
+  // Unmaps the file, sections obtained before become invalid
+  void Close();
+
+private:
+
+  std::unique_ptr<MappedFile> m_File;
+  std::unordered_map<std::string, std::string_view> m_Sections;
+};
+
+class SnapshotWriter
+{
+public:
+
+  void AddSection(
+      const std::string & _Name,
+      std::string_view _Bytes
+    );
+
+  // Writes to a temporary file that then replaces _Path, so a crash never leaves a torn snapshot
+  bool Write(
+      const std::string & _Path
+    ) const;
+
+private:
+
+  std::vector<std::pair<std::string, std::string>> m_Sections;
+};
+
+enum class ESnapshotColumn : std::uint8_t
+{
+  INT = 1,
+  FLOAT,
+  STRING,
+  DATE,
+  ORDER_STATUS
+};
+
+std::uint64_t SnapshotChecksum(
+    std::string_view _Bytes
+  );
+
+// Server version stored in a section, empty if the section is malformed
+std::string ReadSnapshotVersion(
+    std::string_view _Section
+  );
+
+// Appends plain values to a section, padding keeps every column 8-byte aligned
+class SnapshotBuffer
+{
+public:
+
+  template<typename TValue>
+  void Put(
+      const TValue & _Value
+    )
+  {
+    const auto * Bytes = reinterpret_cast<const char *>(&_Value);
+    m_Bytes.append(Bytes, sizeof(TValue));
+  }
+
+  void PutBytes(
+      std::string_view _Bytes
+    )
+  {
+    m_Bytes.append(_Bytes.data(), _Bytes.size());
+  }
+
+  void Align()
+  {
+    m_Bytes.resize((m_Bytes.size() + 7) & ~std::size_t{ 7 }, '\0');
+  }
+
+  std::size_t GetSize() const
+  {
+    return m_Bytes.size();
+  }
+
+  std::string & GetBytes()
+  {
+    return m_Bytes;
+  }
+
+private:
+
+  std::string m_Bytes;
+};
+
+// Bounds-checked reader over a section
+class SnapshotCursor
+{
+public:
+
+  explicit SnapshotCursor(
+      std::string_view _Bytes
+    ) :
+      m_Bytes{ _Bytes }
+  {
+  }
+
+  template<typename TValue>
+  bool Get(
+      TValue & _Value
+    )
+  {
+    if (m_Pos + sizeof(TValue) > m_Bytes.size())
+      return false;
+
+    std::memcpy(&_Value, m_Bytes.data() + m_Pos, sizeof(TValue));
+    m_Pos += sizeof(TValue);
+    return true;
+  }
+
+  bool GetBytes(
+      std::size_t _Size,
+      std::string_view & _Bytes
+    )
+  {
+    if (m_Pos + _Size > m_Bytes.size())
+      return false;
+
+    _Bytes = m_Bytes.substr(m_Pos, _Size);
+    m_Pos += _Size;
+    return true;
+  }
+
+  void Align()
+  {
+    m_Pos = (m_Pos + 7) & ~std::size_t{ 7 };
+  }
+
+private:
+
+  std::string_view m_Bytes;
+  std::size_t m_Pos = 0;
+};
+
+template<typename TValue>
+struct SnapshotColumnTraits;
+
+template<>
+struct SnapshotColumnTraits<int>
+{
+  static constexpr ESnapshotColumn TYPE = ESnapshotColumn::INT;
+  using Stored = std::int32_t;
+
+  static Stored Store(int _Value) { return _Value; }
+  static int Load(Stored _Value, oci::Environment *) { return _Value; }
+};
+
+template<>
+struct SnapshotColumnTraits<float>
+{
+  static constexpr ESnapshotColumn TYPE = ESnapshotColumn::FLOAT;
+  using Stored = float;
+
+  static Stored Store(float _Value) { return _Value; }
+  static float Load(Stored _Value, oci::Environment *) { return _Value; }
+};
+
+template<>
+struct SnapshotColumnTraits<EOrderStatus>
+{
+  static constexpr ESnapshotColumn TYPE = ESnapshotColumn::ORDER_STATUS;
+  using Stored = std::uint8_t;
+
+  static Stored Store(EOrderStatus _Value) { return static_cast<Stored>(_Value); }
+  static EOrderStatus Load(Stored _Value, oci::Environment *) { return static_cast<EOrderStatus>(_Value); }
+};
+
+template<>
+struct SnapshotColumnTraits<oci::Date>
+{
+  static constexpr ESnapshotColumn TYPE = ESnapshotColumn::DATE;
+
+  // Year 0 marks a null date
+  struct Stored
+  {
+    std::int16_t Year;
+    std::uint8_t Month, Day, Hour, Minute, Second, Padding;
+  };
+
+  static Stored Store(
+      const oci::Date & _Value
+    )
+  {
+    if (_Value.isNull())
+      return {};
+
+    int Year = 0;
+    unsigned Month = 0, Day = 0, Hour = 0, Minute = 0, Second = 0;
+    _Value.getDate(Year, Month, Day, Hour, Minute, Second);
+
+    return Stored{
+        static_cast<std::int16_t>(Year),
+        static_cast<std::uint8_t>(Month),
+        static_cast<std::uint8_t>(Day),
+        static_cast<std::uint8_t>(Hour),
+        static_cast<std::uint8_t>(Minute),
+        static_cast<std::uint8_t>(Second),
+        0
+      };
+  }
+
+  static oci::Date Load(
+      const Stored & _Value,
+      oci::Environment * _Env
+    )
+  {
+    if (_Value.Year == 0)
+      return oci::Date();
+
+    return oci::Date(_Env, _Value.Year, _Value.Month, _Value.Day, _Value.Hour, _Value.Minute, _Value.Second);
+  }
+};
+
+template<>
+struct SnapshotColumnTraits<std::string>
+{
+  static constexpr ESnapshotColumn TYPE = ESnapshotColumn::STRING;
+};
+
+template<std::size_t Idx, typename ... TArgs>
+void EncodeSnapshotColumn(
+    SnapshotBuffer & _Out,
+    const Table<TArgs...> & _Rows
+  )
+{
+  using TValue = std::tuple_element_t<Idx, std::tuple<TArgs...>>;
+  using Traits = SnapshotColumnTraits<TValue>;
+
+  SnapshotBuffer Column;
+  if constexpr (std::is_same_v<TValue, std::string>)
+  {
+    std::uint32_t Offset = 0;
+    Column.Put(Offset);
+    for (const auto & Row : _Rows)
+    {
+      Offset += static_cast<std::uint32_t>(std::get<Idx>(Row).size());
+      Column.Put(Offset);
+    }
+    for (const auto & Row : _Rows)
+      Column.PutBytes(std::get<Idx>(Row));
+  }
+  else
+  {
+    for (const auto & Row : _Rows)
+      Column.Put(Traits::Store(std::get<Idx>(Row)));
+  }
+
+  _Out.Put(Traits::TYPE);
+  _Out.Align();
+  _Out.Put(static_cast<std::uint64_t>(Column.GetSize()));
+  _Out.PutBytes(Column.GetBytes());
+  _Out.Align();
+}
+
+template<std::size_t Idx, typename ... TArgs>
+bool DecodeSnapshotColumn(
+    SnapshotCursor & _In,
+    oci::Environment * _Env,
+    Table<TArgs...> & _Rows
+  )
+{
+  using TValue = std::tuple_element_t<Idx, std::tuple<TArgs...>>;
+  using Traits = SnapshotColumnTraits<TValue>;
+
+  ESnapshotColumn Type{};
+  std::uint64_t Size = 0;
+  std::string_view Bytes;
+
+  if (!_In.Get(Type) || Type != Traits::TYPE)
+    return false;
+  _In.Align();
+  if (!_In.Get(Size) || !_In.GetBytes(static_cast<std::size_t>(Size), Bytes))
+    return false;
+  _In.Align();
+
+  SnapshotCursor Column(Bytes);
+  if constexpr (std::is_same_v<TValue, std::string>)
+  {
+    std::vector<std::uint32_t> Offsets(_Rows.size() + 1);
+    for (auto & Offset : Offsets)
+      if (!Column.Get(Offset))
+        return false;
+
+    std::string_view Heap;
+    if (!Column.GetBytes(Offsets.back(), Heap))
+      return false;
+
+    for (std::size_t i = 0; i < _Rows.size(); ++i)
+    {
+      if (Offsets[i] > Offsets[i + 1])
+        return false;
+      std::get<Idx>(_Rows[i]).assign(Heap.substr(Offsets[i], Offsets[i + 1] - Offsets[i]));
+    }
+  }
+  else
+  {
+    for (auto & Row : _Rows)
+    {
+      typename Traits::Stored Value{};
+      if (!Column.Get(Value))
+        return false;
+      std::get<Idx>(Row) = Traits::Load(Value, _Env);
+    }
+  }
+
+  return true;
+}
+
+template<typename ... TArgs, std::size_t ... Idx>
+void EncodeSnapshotColumns(
+    SnapshotBuffer & _Out,
+    const Table<TArgs...> & _Rows,
+    std::index_sequence<Idx...>
+  )
+{
+  (EncodeSnapshotColumn<Idx>(_Out, _Rows), ...);
+}
+
+template<typename ... TArgs, std::size_t ... Idx>
+bool DecodeSnapshotColumns(
+    SnapshotCursor & _In,
+    oci::Environment * _Env,
+    Table<TArgs...> & _Rows,
+    std::index_sequence<Idx...>
+  )
+{
+  return (DecodeSnapshotColumn<Idx>(_In, _Env, _Rows) && ...);
+}
+
+template<typename ... TArgs>
+std::string EncodeSnapshotTable(
+    const Table<TArgs...> & _Rows,
+    const std::string & _Version
+  )
+{
+  SnapshotBuffer Out;
+  Out.Put(static_cast<std::uint32_t>(_Rows.size()));
+  Out.Put(static_cast<std::uint32_t>(sizeof...(TArgs)));
+  Out.Put(static_cast<std::uint32_t>(_Version.size()));
+  Out.PutBytes(_Version);
+  Out.Align();
+
+  EncodeSnapshotColumns(Out, _Rows, std::index_sequence_for<TArgs...>{});
+
+  return std::move(Out.GetBytes());
+}
+
+// Fails on a section written for a different row type
+template<typename ... TArgs>
+bool DecodeSnapshotTable(
+    std::string_view _Section,
+    oci::Environment * _Env,
+    Table<TArgs...> & _Rows
+  )
+{
+  SnapshotCursor In(_Section);
+
+  std::uint32_t RowCount = 0;
+  std::uint32_t ColumnCount = 0;
+  std::uint32_t VersionSize = 0;
+  std::string_view Version;
+
+  if (!In.Get(RowCount) || !In.Get(ColumnCount) || !In.Get(VersionSize) || !In.GetBytes(VersionSize, Version))
+    return false;
+  if (ColumnCount != sizeof...(TArgs))
+    return false;
+  In.Align();
+
+  _Rows.assign(RowCount, {});
+
+  const bool IsDecoded = DecodeSnapshotColumns(In, _Env, _Rows, std::index_sequence_for<TArgs...>{});
+
+  if (!IsDecoded)
+    _Rows.clear();
+
+  return IsDecoded;
+}
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "ThumbnailCache.h"
+
+#include <Walnut/Application.h>
+#include <Walnut/Trace.h>
+#include <stb_image.h>
+#include <algorithm>
+
+namespace
+{
+
+constexpr const char * IMAGE_EXTENSIONS[] = { ".png", ".jpg", ".jpeg", ".bmp" };
+
+constexpr int CHANNEL_COUNT = 4;
+
+// Creating the textures stays cheap, but hundreds arriving at once are spread over a few frames
+constexpr int MAX_UPLOADS_PER_FRAME = 16;
+
+// Averages the source pixels under each target pixel, shrinking only
+std::vector<std::uint8_t> Downscale(
+    const std::uint8_t * _Source,
+    int _SourceWidth,
+    int _SourceHeight,
+    int _Width,
+    int _Height
+  )
+{
+  std::vector<std::uint8_t> Pixels(static_cast<std::size_t>(_Width) * _Height * CHANNEL_COUNT);
+
+  for (int y = 0; y < _Height; ++y)
+  {
+    const int Y0 = y * _SourceHeight / _Height;
+    const int Y1 = std::max(Y0 + 1, (y + 1) * _SourceHeight / _Height);
+
+    for (int x = 0; x < _Width; ++x)
+    {
+      const int X0 = x * _SourceWidth / _Width;
+      const int X1 = std::max(X0 + 1, (x + 1) * _SourceWidth / _Width);
+
+      unsigned int Sum[CHANNEL_COUNT] = {};
+      for (int sy = Y0; sy < Y1; ++sy)
+      {
+        const std::uint8_t * Row = _Source + (static_cast<std::size_t>(sy) * _SourceWidth + X0) * CHANNEL_COUNT;
+        for (int sx = X0; sx < X1; ++sx, Row += CHANNEL_COUNT)
+          for (int c = 0; c < CHANNEL_COUNT; ++c)
+            Sum[c] += Row[c];
+      }
+
+      const unsigned int Count = static_cast<unsigned int>((X1 - X0) * (Y1 - Y0));
+      std::uint8_t * Target = &Pixels[(static_cast<std::size_t>(y) * _Width + x) * CHANNEL_COUNT];
+      for (int c = 0; c < CHANNEL_COUNT; ++c)
+        Target[c] = static_cast<std::uint8_t>((Sum[c] + Count / 2) / Count);
+    }
+  }
+
+  return Pixels;
+}
+
+} // namespace
+
+ThumbnailCache::ThumbnailCache(
+    std::string _Directory,
+    int _MaxSize,
+    std::size_t _BudgetBytes
+  ) :
+    m_BudgetBytes{ _BudgetBytes },
+    m_DecodeQueue{ std::make_shared<DecodeQueue>() }
+{
+  m_DecodeQueue->Directory = std::move(_Directory);
+  m_DecodeQueue->MaxSize = _MaxSize;
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+  // The continuations hold this, cancelled they never run
+  m_Cancellation.Cancel();
+}
+
+void ThumbnailCache::Update()
+{
+  WL_TRACE_SCOPE_CAT("app", __FUNCTION__);
+
+  ++m_Frame;
+
+  {
+    std::scoped_lock Lock(m_DecodeQueue->Mutex);
+
+    // Requests of products scrolled out of view before a job got to them, their jobs find nothing to do
+    auto & Requests = m_DecodeQueue->Requests;
+    const auto Stale = std::stable_partition(Requests.begin(), Requests.end(), [this](int _ProductId)
+    {
+      return m_Entries[_ProductId].LastUsedFrame + 1 >= m_Frame;
+    });
+    for (auto It = Stale; It != Requests.end(); ++It)
+      m_Entries.erase(*It);
+    Requests.erase(Stale, Requests.end());
+  }
+
+  const auto Count = std::min<std::size_t>(m_Decoded.size(), MAX_UPLOADS_PER_FRAME);
+  std::vector<Decoded> Results(std::make_move_iterator(m_Decoded.begin()), std::make_move_iterator(m_Decoded.begin() + Count));
+  m_Decoded.erase(m_Decoded.begin(), m_Decoded.begin() + Count);
+
+  if (!m_Decoded.empty())
+    Walnut::Application::Get().RequestFrame();
+
+  for (auto & Result : Results)
+  {
+    auto & Entry = m_Entries[Result.ProductId];
+    if (Result.Pixels.empty() || !m_Atlas.Add(Result.Width, Result.Height, Result.Pixels.data(), Entry.Region))
+    {
+      Entry.State = EState::MISSING;
+      continue;
+    }
+
+    Entry.State = EState::LOADED;
+    Entry.LruIt = m_Lru.insert(m_Lru.begin(), Result.ProductId);
+    m_UsedBytes += Result.Pixels.size();
+  }
+
+  Evict();
+}
+
+std::optional<Thumbnail> ThumbnailCache::Get(
+    int _ProductId
+  )
+{
+  auto [It, IsNew] = m_Entries.try_emplace(_ProductId);
+  auto & Entry = It->second;
+  Entry.LastUsedFrame = m_Frame;
+
+  if (IsNew)
+  {
+    {
+      std::scoped_lock Lock(m_DecodeQueue->Mutex);
+      m_DecodeQueue->Requests.push_back(_ProductId);
+    }
+
+    Walnut::Application::GetJobSystem().Schedule(
+        [Queue = m_DecodeQueue]()
+        {
+          return DecodeNext(*Queue);
+        },
+        [this](std::optional<Decoded> _Result)
+        {
+          if (_Result)
+            m_Decoded.push_back(std::move(*_Result));
+        },
+        Walnut::JobPriority::Low,
+        m_Cancellation
+      );
+    return std::nullopt;
+  }
+
+  if (Entry.State != EState::LOADED)
+    return std::nullopt;
+
+  m_Lru.splice(m_Lru.begin(), m_Lru, Entry.LruIt);
+
+  // The copy to the GPU is recorded with the next frame, keep drawing until it lands
+  if (!m_Atlas.IsUploaded(Entry.Region))
+  {
+    Walnut::Application::Get().RequestFrame();
+    return std::nullopt;
+  }
+
+  return Thumbnail{
+      m_Atlas.GetDescriptorSet(Entry.Region),
+      m_Atlas.GetUV0(Entry.Region),
+      m_Atlas.GetUV1(Entry.Region),
+      ImVec2(static_cast<float>(Entry.Region.Width), static_cast<float>(Entry.Region.Height))
+    };
+}
+
+bool ThumbnailCache::IsMissing(
+    int _ProductId
+  ) const
+{
+  const auto It = m_Entries.find(_ProductId);
+  return It != m_Entries.end() && It->second.State == EState::MISSING;
+}
+
+std::optional<ThumbnailCache::Decoded> ThumbnailCache::DecodeNext(
+    DecodeQueue & _Queue
+  )
+{
+  int ProductId = 0;
+  {
+    std::scoped_lock Lock(_Queue.Mutex);
+    if (_Queue.Requests.empty())
+      return std::nullopt;
+
+    ProductId = _Queue.Requests.back();
+    _Queue.Requests.pop_back();
+  }
+
+  return Decode(_Queue, ProductId);
+}
+
+ThumbnailCache::Decoded ThumbnailCache::Decode(
+    const DecodeQueue & _Queue,
+    int _ProductId
+  )
+{
+  WL_TRACE_SCOPE_CAT("app", __FUNCTION__);
+
+  Decoded Result;
+  Result.ProductId = _ProductId;
+
+  int Width = 0;
+  int Height = 0;
+  int Channels = 0;
+  stbi_uc * Pixels = nullptr;
+  for (const char * Extension : IMAGE_EXTENSIONS)
+  {
+    const auto Path = _Queue.Directory + "/" + std::to_string(_ProductId) + Extension;
+    if ((Pixels = stbi_load(Path.c_str(), &Width, &Height, &Channels, CHANNEL_COUNT)))
+      break;
+  }
+
+  if (!Pixels)
+    return Result;
+
+  const float Scale = std::min(1.0f, static_cast<float>(_Queue.MaxSize) / std::max(Width, Height));
+  Result.Width = std::max(1, static_cast<int>(Width * Scale));
+  Result.Height = std::max(1, static_cast<int>(Height * Scale));
+
+  if (Result.Width == Width && Result.Height == Height)
+    Result.Pixels.assign(Pixels, Pixels + static_cast<std::size_t>(Width) * Height * CHANNEL_COUNT);
+  else
+    Result.Pixels = Downscale(Pixels, Width, Height, Result.Width, Result.Height);
+
+  stbi_image_free(Pixels);
+  return Result;
+}
+
+void ThumbnailCache::Evict()
+{
+  // Thumbnails still on screen last frame stay, even over the budget
+  while (m_UsedBytes > m_BudgetBytes && !m_Lru.empty())
+  {
+    const int ProductId = m_Lru.back();
+    const auto It = m_Entries.find(ProductId);
+    if (It->second.LastUsedFrame >= m_Frame - 1)
+      break;
+
+    m_UsedBytes -= static_cast<std::size_t>(It->second.Region.Width) * It->second.Region.Height * CHANNEL_COUNT;
+    m_Atlas.Remove(It->second.Region);
+    m_Lru.pop_back();
+    m_Entries.erase(It);
+  }
+}
\ No newline at end of file
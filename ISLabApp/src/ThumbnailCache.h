@@ -0,0 +1,124 @@
+#pragma once
+
+#include <Walnut/JobSystem.h>
+#include <Walnut/TextureAtlas.h>
+#include <imgui.h>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct Thumbnail
+{
+  ImTextureID Texture;
+  ImVec2 UV0;
+  ImVec2 UV1;
+  ImVec2 Size;
+};
+
+// Product images shrunk to thumbnails, decoded by low priority jobs and kept on the GPU up to a memory budget.
+// The thumbnails share the pages of a texture atlas instead of an image and descriptor set each.
+// Images are read from <directory>/<product id>.png or .jpg, products without a file get no thumbnail.
+// Everything but the decoding runs on the UI thread.
+class ThumbnailCache
+{
+public:
+
+  ThumbnailCache(
+      std::string _Directory,
+      int _MaxSize,
+      std::size_t _BudgetBytes
+    );
+
+  // Cancels the queued decodes, those in progress are finished and thrown away
+  ~ThumbnailCache();
+
+  ThumbnailCache(const ThumbnailCache &) = delete;
+  ThumbnailCache & operator=(const ThumbnailCache &) = delete;
+
+  // Uploads what the jobs decoded and evicts the least recently used thumbnails over the budget, once per frame
+  void Update();
+
+  // Returns nothing until the thumbnail is on the GPU, the first call queues the decode.
+  // Only visible products should ask, a request not repeated the next frame is dropped unless already decoding.
+  std::optional<Thumbnail> Get(
+      int _ProductId
+    );
+
+  // The product has no image or it could not be decoded
+  bool IsMissing(
+      int _ProductId
+    ) const;
+
+  std::size_t GetUsedBytes() const
+  {
+    return m_UsedBytes;
+  }
+
+private:
+
+  enum class EState
+  {
+    // Waiting for or being decoded by a job
+    QUEUED,
+    LOADED,
+    MISSING
+  };
+
+  struct Entry
+  {
+    EState State = EState::QUEUED;
+    Walnut::AtlasRegion Region;
+    std::list<int>::iterator LruIt;
+    std::uint64_t LastUsedFrame = 0;
+  };
+
+  struct Decoded
+  {
+    int ProductId;
+    int Width = 0;
+    int Height = 0;
+    std::vector<std::uint8_t> Pixels;
+  };
+
+  // Shared with the jobs, which may still run after the cache is gone
+  struct DecodeQueue
+  {
+    std::string Directory;
+    int MaxSize = 0;
+
+    std::mutex Mutex;
+    // Served newest first, the cards just scrolled into view come before the ones already passed
+    std::vector<int> Requests;
+  };
+
+  // One job per request, each takes the newest request left when it starts
+  static std::optional<Decoded> DecodeNext(
+      DecodeQueue & _Queue
+    );
+
+  static Decoded Decode(
+      const DecodeQueue & _Queue,
+      int _ProductId
+    );
+
+  void Evict();
+
+  std::size_t m_BudgetBytes = 0;
+  std::size_t m_UsedBytes = 0;
+  std::uint64_t m_Frame = 0;
+
+  Walnut::TextureAtlas m_Atlas;
+  std::unordered_map<int, Entry> m_Entries;
+  // Most recently used in front, only loaded thumbnails
+  std::list<int> m_Lru;
+
+  std::shared_ptr<DecodeQueue> m_DecodeQueue;
+  // Decoded but not uploaded yet, filled by the job continuations
+  std::vector<Decoded> m_Decoded;
+  Walnut::CancellationToken m_Cancellation;
+};
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "WarehousesTableWindow.h"
 
 #include "CountriesTableWindow.h"
+#include "TableOps.h"
 
 #include <imgui.h>
 #include <algorithm>
@@ -15,36 +16,43 @@ WarehousesTableWindow::WarehousesTableWindow(
     m_Conn{ _Conn },
     m_Countries{ _Countries }
 {
-  m_CreateStmt = m_Conn->createStatement("INSERT INTO warehouses(warehouse_name, country_id) VALUES(:1,:2)");
-  m_DeleteStmt = m_Conn->createStatement("DELETE FROM warehouses WHERE warehouse_id = :1");
-  m_UpdateStmt = m_Conn->createStatement("SELECT * FROM warehouses");
+  m_CreateStmt = DBStatement(m_Conn, "INSERT INTO warehouses(warehouse_name, country_id) VALUES(:1,:2) RETURNING warehouse_id INTO :3");
+  m_CreateStmt->registerOutParam(3, oci::OCCIINT);
+  m_DeleteStmt = DBStatement(m_Conn, "DELETE FROM warehouses WHERE warehouse_id = :1");
+  m_UpdateStmt = DBStatement(m_Conn, UPDATE_QUERY);
 
-  m_SignalConnections.AddConnection(m_Countries->TableChangedSignal, this, &WarehousesTableWindow::UpdateTable);
-  m_SignalConnections.AddConnection(m_Countries->TableChangedSignal, &TableChangedSignal, &sig::CSignal<>::Emit);
+  m_SignalConnections.AddConnection(m_Countries->RowsDeletedSignal, this, &WarehousesTableWindow::OnParentRowsDeleted);
 }
 
 WarehousesTableWindow::~WarehousesTableWindow()
 {
-  m_Conn->terminateStatement(m_CreateStmt);
-  m_Conn->terminateStatement(m_DeleteStmt);
-  m_Conn->terminateStatement(m_UpdateStmt);
-
   m_SignalConnections.Disconnect();
 }
 
 void WarehousesTableWindow::OnUIRender()
 {
-  ImGui::Begin("Warehouses");
+  WL_TRACE_SCOPE_CAT("render", __FUNCTION__);
+
+  const bool IsVisible = ImGui::Begin("Warehouses");
 
   if (ImGui::IsWindowAppearing())
     m_NeedUpdate = true;
 
+  // Collapsed or in a hidden tab, a refresh waits until it is shown
+  if (!IsVisible)
+  {
+    ImGui::End();
+    return;
+  }
+
   if (m_NeedUpdate)
   {
-    UpdateTable();
+    RefreshTable();
     m_NeedUpdate = false;
   }
 
+  m_Refresh.MarkVisible();
+
   if (ImGui::Button("Create"))
     OpenCreateWindow();
   RenderCreateWindow();
@@ -78,7 +86,6 @@ void WarehousesTableWindow::RenderCreateWindow()
     if (ButtonCentered("OK"))
     {
       Create(m_WarehouseNameBuffer.data(), m_CountryIdBuffer.data());
-      UpdateTable();
       CloseCreateWindow();
     }
 
@@ -103,12 +110,11 @@ void WarehousesTableWindow::RenderDeleteWindow()
 {
   if (ImGui::BeginPopupModal("Delete", &m_IsDeleting, ImGuiWindowFlags_AlwaysAutoResize))
   {
-    DropDown<0>("Warehouse ID", m_Table, m_WarehouseId);
+    DropDown<0>("Warehouse ID", m_Table.Get(), m_WarehouseId);
 
     if (ButtonCentered("OK"))
     {
       Delete(m_WarehouseId);
-      UpdateTable();
       CloseDeleteWindow();
     }
 
@@ -167,7 +173,7 @@ void WarehousesTableWindow::RenderTable()
       SortSpecs->SpecsDirty = false;
     }
 
-    for (const auto & [WarehouseID, WarehouseName, CountryID] : m_Table)
+    for (const auto & [WarehouseID, WarehouseName, CountryID] : m_Table.Get())
     {
       ImGui::TableNextRow();
       ImGui::TableNextColumn();
@@ -184,18 +190,15 @@ void WarehousesTableWindow::RenderTable()
 
 void WarehousesTableWindow::UpdateTable()
 {
-  m_Table.clear();
+  WL_TRACE_SCOPE_CAT("sql", __FUNCTION__);
 
+  // Superseded by this fetch
+  m_Refresh.Cancel();
+
+  auto Rows = std::make_shared<Table<int, std::string, std::string>>();
   try
   {
-    auto * Result = m_UpdateStmt->executeQuery();
-    Result->next();
-
-    while (Result->status() == oci::ResultSet::DATA_AVAILABLE)
-    {
-      m_Table.emplace_back(Result->getInt(1), Result->getString(2), Result->getString(3));
-      Result->next();
-    }
+    m_UpdateStmt.FetchInto(*Rows, &ReadRow);
   }
   catch (const oci::SQLException & ex)
   {
@@ -203,12 +206,64 @@ void WarehousesTableWindow::UpdateTable()
     OpenErrorWindow();
   }
 
-  if (!m_Table.empty())
+  m_Table.Publish(std::move(Rows));
+  OnTableLoaded();
+}
+
+void WarehousesTableWindow::RefreshTable()
+{
+  m_Refresh.Start<Table<int, std::string, std::string>>(
+      m_UpdateStmt,
+      &ReadRow,
+      [this](Table<int, std::string, std::string> _Rows)
+      {
+        SetTable(std::move(_Rows));
+      },
+      [this](const oci::SQLException & ex)
+      {
+        m_ErrorMessage = ex.what();
+        OpenErrorWindow();
+      }
+    );
+}
+
+void WarehousesTableWindow::SetTable(
+    Table<int, std::string, std::string> _Table
+  )
+{
+  m_Refresh.Cancel();
+  m_Table.Publish(std::make_shared<Table<int, std::string, std::string>>(std::move(_Table)));
+  OnTableLoaded();
+  m_NeedUpdate = false;
+  TableChangedSignal.Emit();
+}
+
+void WarehousesTableWindow::OnTableLoaded()
+{
+  auto & Rows = m_Table.Edit();
+  std::sort(Rows.begin(), Rows.end(), m_SortPredicate);
+
+  if (!Rows.empty())
   {
-    Copy(std::get<0>(m_Table.front()), m_WarehouseId);
-    Copy(std::get<1>(m_Table.front()), m_WarehouseNameBuffer);
-    Copy(std::get<2>(m_Table.front()), m_CountryIdBuffer);
+    Copy(std::get<0>(Rows.front()), m_WarehouseId);
+    Copy(std::get<1>(Rows.front()), m_WarehouseNameBuffer);
+    Copy(std::get<2>(Rows.front()), m_CountryIdBuffer);
   }
+
+}
+
+std::tuple<int, std::string, std::string> WarehousesTableWindow::ReadRow(
+    oci::ResultSet * _Result
+  )
+{
+  return std::make_tuple(_Result->getInt(1), _Result->getString(2), _Result->getString(3));
+}
+
+void WarehousesTableWindow::OnParentRowsDeleted()
+{
+  UpdateTable();
+  RowsDeletedSignal.Emit();
+  TableChangedSignal.Emit();
 }
 
 void WarehousesTableWindow::SortTable(
@@ -216,10 +271,11 @@ void WarehousesTableWindow::SortTable(
     ImGuiSortDirection _SortDir
   )
 {
-  std::sort(
-      m_Table.begin(), m_Table.end(),
-      PredicateImpl<int, std::string, std::string>{ _ColIdx, _SortDir }
-    );
+  WL_TRACE_SCOPE_CAT("sort", __FUNCTION__);
+
+  m_SortPredicate = { _ColIdx, _SortDir };
+  auto & Rows = m_Table.Edit();
+  std::sort(Rows.begin(), Rows.end(), m_SortPredicate);
 }
 
 void WarehousesTableWindow::Create(
@@ -231,8 +287,10 @@ void WarehousesTableWindow::Create(
   {
     m_CreateStmt->setString(1, _WarehouseName);
     m_CreateStmt->setString(2, _CountryID);
-    m_CreateStmt->executeUpdate();
-    m_Conn->commit();
+    m_CreateStmt.ExecuteUpdate();
+    m_CreateStmt.Commit();
+    InsertSorted(m_Table.Edit(), std::make_tuple(m_CreateStmt->getInt(3), std::string(_WarehouseName), std::string(_CountryID)), m_SortPredicate);
+    TableChangedSignal.Emit();
   }
   catch (const oci::SQLException & ex)
   {
@@ -248,8 +306,14 @@ void WarehousesTableWindow::Delete(
   try
   {
     m_DeleteStmt->setInt(1, _WarehouseID);
-    m_DeleteStmt->executeUpdate();
-    m_Conn->commit();
+    m_DeleteStmt.ExecuteUpdate();
+    m_DeleteStmt.Commit();
+    auto & Rows = m_Table.Edit();
+    EraseByKey<0>(Rows, _WarehouseID);
+    if (!Rows.empty())
+      Copy(std::get<0>(Rows.front()), m_WarehouseId);
+    RowsDeletedSignal.Emit();
+    TableChangedSignal.Emit();
   }
   catch (const oci::SQLException & ex)
   {
@@ -2,6 +2,9 @@
 
 #include "ISLabApp.h"
 #include "IWindow.h"
+#include "DBStatement.h"
+#include "IncrementalFetch.h"
+#include "SnapshotCell.h"
 
 #include <imgui.h>
 #include <vector>
@@ -41,6 +44,19 @@ public:
   void RenderTable();
   void UpdateTable();
 
+  void SetTable(
+      Table<int, std::string, std::string> _Table
+    );
+
+  static constexpr const char * TABLE_NAME = "warehouses";
+  static constexpr const char * UPDATE_QUERY = "SELECT warehouse_id, warehouse_name, country_id FROM warehouses";
+
+  static std::tuple<int, std::string, std::string> ReadRow(
+      oci::ResultSet * _Result
+    );
+
+  void OnParentRowsDeleted();
+
   void SortTable(
       int _ColIdx,
       ImGuiSortDirection _SortDir
@@ -57,21 +73,34 @@ public:
 
   const auto & GetTable() const
   {
-    return m_Table;
+    return m_Table.Get();
+  }
+
+  // Dependent windows read this instead of GetTable, it stays the same while they hold it
+  Snapshot<Table<int, std::string, std::string>> GetSnapshot() const
+  {
+    return m_Table.Read();
   }
 
 public:
 
   sig::CSignal<> TableChangedSignal;
+  sig::CSignal<> RowsDeletedSignal;
 
 private:
 
+  void OnTableLoaded();
+  // Fetches the table a slice per frame and hands it to SetTable
+  void RefreshTable();
+
   oci::Environment * m_Env = nullptr;
   oci::Connection * m_Conn = nullptr;
 
-  oci::Statement * m_CreateStmt = nullptr;
-  oci::Statement * m_DeleteStmt = nullptr;
-  oci::Statement * m_UpdateStmt = nullptr;
+  DBStatement m_CreateStmt;
+  DBStatement m_DeleteStmt;
+  DBStatement m_UpdateStmt;
+  // Reads m_UpdateStmt, declared after it so it is closed first
+  IncrementalFetch m_Refresh;
 
   int m_WarehouseId = 0;
   std::vector<char> m_WarehouseNameBuffer = std::vector<char>(255 + 1, '\0');
@@ -84,7 +113,9 @@ private:
 
   std::string m_ErrorMessage;
 
-  Table<int, std::string, std::string> m_Table;
+  // Edited in place while no other window holds it, the loaded version is published as is
+  SnapshotCell<Table<int, std::string, std::string>> m_Table;
+  PredicateImpl<int, std::string, std::string> m_SortPredicate{ 0, ImGuiSortDirection_Ascending };
   CountriesTableWindow * m_Countries = nullptr;
   sig::CMultiConnection m_SignalConnections;
 };
\ No newline at end of file
@@ -1,4 +1,9 @@
 #include "Application.h"
+#include "Trace.h"
+#include "UploadQueue.h"
+#include "MemoryAllocator.h"
+#include "FontAtlasCache.h"
+#include "JobSystem.h"
 
 //
 // Adapted from Dear ImGui Vulkan example
@@ -15,7 +20,14 @@
 #include <vulkan/vulkan.h>
 #include <glm/glm.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <thread>
 
 // Emedded font
 #include "ImGui/Roboto-Regular.embed"
@@ -56,8 +68,42 @@ static std::vector<std::vector<std::function<void()>>> s_ResourceFreeQueue;
 // and is always guaranteed to increase (eg. 0, 1, 2, 0, 1, 2)
 static uint32_t s_CurrentFrameIndex = 0;
 
+static std::unique_ptr<Walnut::MemoryAllocator> s_MemoryAllocator;
+static std::unique_ptr<Walnut::UploadQueue> s_UploadQueue;
+static std::unique_ptr<Walnut::JobSystem> s_JobSystem;
+static VkSampler s_Sampler = VK_NULL_HANDLE;
+
+// Numbers the frame submissions so the upload queue can tell which of its copies have completed,
+// s_FrameSubmitSerials holds the last serial submitted with the fence of each swapchain image
+static uint64_t s_SubmitSerial = 0;
+static std::vector<uint64_t> s_FrameSubmitSerials;
+
 static Walnut::Application* s_Instance = nullptr;
 
+// Set between glfwInit and glfwTerminate, PostWakeEvent is called from other threads
+static std::atomic<bool> s_IsGlfwInitialized{ false };
+
+// Frames rendered after an event before the loop waits again, popups and layout changes take a few
+static constexpr int s_SettleFrameCount = 3;
+
+// Half the ImGui text cursor blink period
+static constexpr float s_CaretBlinkInterval = 0.4f;
+
+static constexpr const char* s_PipelineCacheFileName = "walnut_pipeline.cache";
+static constexpr const char* s_FontCacheFileName = "walnut_fonts.cache";
+
+struct StartupPhase
+{
+	const char* Name;
+	uint64_t DurationNs;
+};
+
+// Filled by Init and the first frame of Run, printed once that frame is presented
+static std::vector<StartupPhase> s_StartupPhases;
+static uint64_t s_StartupBeginNs = 0;
+static uint64_t s_StartupPhaseBeginNs = 0;
+static bool s_StartupReported = false;
+
 void check_vk_result(VkResult err)
 {
 	if (err == 0)
@@ -252,8 +298,116 @@ static void SetupVulkanWindow(ImGui_ImplVulkanH_Window* wd, VkSurfaceKHR surface
 	ImGui_ImplVulkanH_CreateOrResizeWindow(g_Instance, g_PhysicalDevice, g_Device, wd, g_QueueFamily, g_Allocator, width, height, g_MinImageCount);
 }
 
+static std::string GetCachePath(const std::string& directory, const char* fileName)
+{
+	if (directory.empty())
+		return {};
+	return (std::filesystem::path(directory) / fileName).string();
+}
+
+static void SetupPipelineCache(const std::string& path)
+{
+	std::vector<char> data;
+	if (!path.empty())
+	{
+		std::ifstream in(path, std::ios::binary | std::ios::ate);
+		if (in)
+		{
+			data.resize((size_t)in.tellg());
+			in.seekg(0);
+			if (!in.read(data.data(), data.size()))
+				data.clear();
+		}
+	}
+
+	// Some drivers do not validate the data they are given, a cache from another GPU or driver version is dropped here
+	if (!data.empty())
+	{
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(g_PhysicalDevice, &properties);
+
+		uint32_t header[4] = {};
+		bool valid = data.size() >= sizeof(header) + VK_UUID_SIZE;
+		if (valid)
+		{
+			memcpy(header, data.data(), sizeof(header));
+			valid = header[0] >= sizeof(header) + VK_UUID_SIZE && header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+				&& header[2] == properties.vendorID && header[3] == properties.deviceID
+				&& memcmp(data.data() + sizeof(header), properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+		}
+		if (!valid)
+			data.clear();
+	}
+
+	VkPipelineCacheCreateInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	info.initialDataSize = data.size();
+	info.pInitialData = data.empty() ? nullptr : data.data();
+	VkResult err = vkCreatePipelineCache(g_Device, &info, g_Allocator, &g_PipelineCache);
+	if (err != VK_SUCCESS && !data.empty())
+	{
+		// Rejected by the driver, start over with an empty cache
+		info.initialDataSize = 0;
+		info.pInitialData = nullptr;
+		err = vkCreatePipelineCache(g_Device, &info, g_Allocator, &g_PipelineCache);
+	}
+	check_vk_result(err);
+}
+
+static void SavePipelineCache(const std::string& path)
+{
+	if (path.empty() || g_PipelineCache == VK_NULL_HANDLE)
+		return;
+
+	size_t size = 0;
+	VkResult err = vkGetPipelineCacheData(g_Device, g_PipelineCache, &size, nullptr);
+	if (err != VK_SUCCESS || size == 0)
+		return;
+	std::vector<char> data(size);
+	err = vkGetPipelineCacheData(g_Device, g_PipelineCache, &size, data.data());
+	if (err != VK_SUCCESS)
+		return;
+
+	// Written aside and renamed, a crash while writing never leaves a truncated cache behind
+	const std::string tempPath = path + ".tmp";
+	{
+		std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+		if (!out.write(data.data(), size))
+		{
+			out.close();
+			std::remove(tempPath.c_str());
+			return;
+		}
+	}
+	// Windows refuses to rename over an existing file, POSIX replaces it atomically
+#ifdef _WIN32
+	std::remove(path.c_str());
+#endif
+	std::rename(tempPath.c_str(), path.c_str());
+}
+
+static void MarkStartupPhase(const char* name)
+{
+	const uint64_t now = Walnut::Trace::Now();
+	s_StartupPhases.push_back({ name, now - s_StartupPhaseBeginNs });
+#ifdef WL_ENABLE_TRACING
+	Walnut::Trace::Record(name, "startup", s_StartupPhaseBeginNs, now);
+#endif
+	s_StartupPhaseBeginNs = now;
+}
+
+static void ReportStartupTimeline()
+{
+	fprintf(stderr, "[startup]");
+	for (auto& phase : s_StartupPhases)
+		fprintf(stderr, " %s %.1f ms,", phase.Name, phase.DurationNs / 1e6);
+	fprintf(stderr, " total %.1f ms\n", (s_StartupPhaseBeginNs - s_StartupBeginNs) / 1e6);
+	s_StartupPhases.clear();
+}
+
 static void CleanupVulkan()
 {
+	vkDestroyPipelineCache(g_Device, g_PipelineCache, g_Allocator);
 	vkDestroyDescriptorPool(g_Device, g_DescriptorPool, g_Allocator);
 
 #ifdef IMGUI_VULKAN_DEBUG_REPORT
@@ -294,6 +448,9 @@ static void FrameRender(ImGui_ImplVulkanH_Window* wd, ImDrawData* draw_data)
 
 		err = vkResetFences(g_Device, 1, &fd->Fence);
 		check_vk_result(err);
+
+		// A signaled fence also covers everything submitted before it on the queue
+		s_UploadQueue->Retire(s_FrameSubmitSerials[wd->FrameIndex]);
 	}
 
 	{
@@ -320,6 +477,11 @@ static void FrameRender(ImGui_ImplVulkanH_Window* wd, ImDrawData* draw_data)
 		err = vkBeginCommandBuffer(fd->CommandBuffer, &info);
 		check_vk_result(err);
 	}
+	{
+		// Image uploads go ahead of the render pass that may sample them this frame
+		s_FrameSubmitSerials[wd->FrameIndex] = ++s_SubmitSerial;
+		s_UploadQueue->Record(fd->CommandBuffer, s_SubmitSerial);
+	}
 	{
 		VkRenderPassBeginInfo info = {};
 		info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -407,6 +569,12 @@ namespace Walnut {
 
 	void Application::Init()
 	{
+		WL_TRACE_THREAD_NAME("Main");
+		WL_TRACE_SCOPE_CAT("startup", "Application::Init");
+
+		s_StartupBeginNs = Trace::Now();
+		s_StartupPhaseBeginNs = s_StartupBeginNs;
+
 		// Setup GLFW window
 		glfwSetErrorCallback(glfw_error_callback);
 		if (!glfwInit())
@@ -414,9 +582,11 @@ namespace Walnut {
 			std::cerr << "Could not initalize GLFW!\n";
 			return;
 		}
+		s_IsGlfwInitialized = true;
 
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 		m_WindowHandle = glfwCreateWindow(m_Specification.Width, m_Specification.Height, m_Specification.Name.c_str(), NULL, NULL);
+		MarkStartupPhase("window");
 
 		// Setup Vulkan
 		if (!glfwVulkanSupported())
@@ -427,6 +597,15 @@ namespace Walnut {
 		uint32_t extensions_count = 0;
 		const char** extensions = glfwGetRequiredInstanceExtensions(&extensions_count);
 		SetupVulkan(extensions, extensions_count);
+		MarkStartupPhase("vulkan");
+
+		if (!m_Specification.CacheDirectory.empty())
+		{
+			std::error_code error;
+			std::filesystem::create_directories(m_Specification.CacheDirectory, error);
+		}
+		SetupPipelineCache(GetCachePath(m_Specification.CacheDirectory, s_PipelineCacheFileName));
+		MarkStartupPhase("pipeline cache");
 
 		// Create Window Surface
 		VkSurfaceKHR surface;
@@ -438,9 +617,31 @@ namespace Walnut {
 		glfwGetFramebufferSize(m_WindowHandle, &w, &h);
 		ImGui_ImplVulkanH_Window* wd = &g_MainWindowData;
 		SetupVulkanWindow(wd, surface, w, h);
+		MarkStartupPhase("swap chain");
 
 		s_AllocatedCommandBuffers.resize(wd->ImageCount);
 		s_ResourceFreeQueue.resize(wd->ImageCount);
+		s_FrameSubmitSerials.resize(wd->ImageCount);
+
+		s_MemoryAllocator = std::make_unique<MemoryAllocator>(g_Device, g_PhysicalDevice, m_Specification.MemoryBlockSize);
+		s_UploadQueue = std::make_unique<UploadQueue>(g_Device, m_Specification.UploadRingSize);
+		s_JobSystem = std::make_unique<JobSystem>(m_Specification.JobThreadCount);
+
+		{
+			VkSamplerCreateInfo info = {};
+			info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+			info.magFilter = VK_FILTER_LINEAR;
+			info.minFilter = VK_FILTER_LINEAR;
+			info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+			info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+			info.minLod = -1000;
+			info.maxLod = 1000;
+			info.maxAnisotropy = 1.0f;
+			err = vkCreateSampler(g_Device, &info, g_Allocator, &s_Sampler);
+			check_vk_result(err);
+		}
 
 		// Setup Dear ImGui context
 		IMGUI_CHECKVERSION();
@@ -483,6 +684,7 @@ namespace Walnut {
 		init_info.Allocator = g_Allocator;
 		init_info.CheckVkResultFn = check_vk_result;
 		ImGui_ImplVulkan_Init(&init_info, wd->RenderPass);
+		MarkStartupPhase("imgui");
 
 		// Load default font
 		ImFontConfig fontConfig;
@@ -492,6 +694,14 @@ namespace Walnut {
 		ImFont* robotoFont40 = io.Fonts->AddFontFromMemoryTTF((void*)g_RobotoRegular, sizeof(g_RobotoRegular), 40.0f, &fontConfig);
 		io.FontDefault = robotoFont24;
 
+		// Rasterizing the fonts is most of the startup time, the baked atlas is reused while the fonts stay the same
+		const std::string fontCachePath = GetCachePath(m_Specification.CacheDirectory, s_FontCacheFileName);
+		const uint64_t fontKey = FontAtlasCache::ComputeKey(*io.Fonts);
+		const bool fontsCached = !fontCachePath.empty() && FontAtlasCache::Load(*io.Fonts, fontCachePath, fontKey);
+		if (!fontsCached && io.Fonts->Build() && !fontCachePath.empty())
+			FontAtlasCache::Save(*io.Fonts, fontCachePath, fontKey);
+		MarkStartupPhase(fontsCached ? "fonts (cached)" : "fonts (built)");
+
 		// Upload Fonts
 		{
 			// Use any command queue
@@ -521,10 +731,14 @@ namespace Walnut {
 			check_vk_result(err);
 			ImGui_ImplVulkan_DestroyFontUploadObjects();
 		}
+		MarkStartupPhase("font upload");
 	}
 
 	void Application::Shutdown()
 	{
+		// Before the layers detach, running jobs may still use them
+		s_JobSystem.reset();
+
 		for (auto& layer : m_LayerStack)
 			layer->OnDetach();
 
@@ -542,6 +756,12 @@ namespace Walnut {
 		}
 		s_ResourceFreeQueue.clear();
 
+		SavePipelineCache(GetCachePath(m_Specification.CacheDirectory, s_PipelineCacheFileName));
+
+		s_UploadQueue.reset();
+		vkDestroySampler(g_Device, s_Sampler, g_Allocator);
+		s_MemoryAllocator.reset();
+
 		ImGui_ImplVulkan_Shutdown();
 		ImGui_ImplGlfw_Shutdown();
 		ImPlot::DestroyContext();
@@ -551,6 +771,7 @@ namespace Walnut {
 		CleanupVulkan();
 
 		glfwDestroyWindow(m_WindowHandle);
+		s_IsGlfwInitialized = false;
 		glfwTerminate();
 
 		g_ApplicationRunning = false;
@@ -564,18 +785,37 @@ namespace Walnut {
 		ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 		ImGuiIO& io = ImGui::GetIO();
 
+		m_ActiveFrames = s_SettleFrameCount;
+
+		// Layers are pushed between the constructor and Run
+		if (!s_StartupReported)
+			MarkStartupPhase("layers");
+
 		// Main loop
 		while (!glfwWindowShouldClose(m_WindowHandle) && m_Running)
 		{
+			WL_TRACE_SCOPE_CAT("frame", "Frame");
+
 			// Poll and handle events (inputs, window resize, etc.)
 			// You can read the io.WantCaptureMouse, io.WantCaptureKeyboard flags to tell if dear imgui wants to use your inputs.
 			// - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application.
 			// - When io.WantCaptureKeyboard is true, do not dispatch keyboard input data to your main application.
 			// Generally you may always pass all inputs to dear imgui, and hide them from your application based on those two flags.
-			glfwPollEvents();
+			{
+				WL_TRACE_SCOPE_CAT("frame", "PollEvents");
+				WaitForEvents();
+			}
 
-			for (auto& layer : m_LayerStack)
-				layer->OnUpdate(m_TimeStep);
+			{
+				WL_TRACE_SCOPE_CAT("frame", "JobSystem::RunContinuations");
+				s_JobSystem->RunContinuations();
+			}
+
+			{
+				WL_TRACE_SCOPE_CAT("frame", "Layer::OnUpdate");
+				for (auto& layer : m_LayerStack)
+					layer->OnUpdate(m_TimeStep);
+			}
 
 			// Resize swap chain?
 			if (g_SwapChainRebuild)
@@ -592,6 +832,10 @@ namespace Walnut {
 					s_AllocatedCommandBuffers.clear();
 					s_AllocatedCommandBuffers.resize(g_MainWindowData.ImageCount);
 
+					// The resize waited for the device, so every submission so far has completed
+					s_UploadQueue->Retire(s_SubmitSerial);
+					s_FrameSubmitSerials.assign(g_MainWindowData.ImageCount, 0);
+
 					g_SwapChainRebuild = false;
 				}
 			}
@@ -652,14 +896,20 @@ namespace Walnut {
 					}
 				}
 
-				for (auto& layer : m_LayerStack)
-					layer->OnUIRender();
+				{
+					WL_TRACE_SCOPE_CAT("render", "Layer::OnUIRender");
+					for (auto& layer : m_LayerStack)
+						layer->OnUIRender();
+				}
 
 				ImGui::End();
 			}
 
 			// Rendering
-			ImGui::Render();
+			{
+				WL_TRACE_SCOPE_CAT("render", "ImGui::Render");
+				ImGui::Render();
+			}
 			ImDrawData* main_draw_data = ImGui::GetDrawData();
 			const bool main_is_minimized = (main_draw_data->DisplaySize.x <= 0.0f || main_draw_data->DisplaySize.y <= 0.0f);
 			wd->ClearValue.color.float32[0] = clear_color.x * clear_color.w;
@@ -667,18 +917,37 @@ namespace Walnut {
 			wd->ClearValue.color.float32[2] = clear_color.z * clear_color.w;
 			wd->ClearValue.color.float32[3] = clear_color.w;
 			if (!main_is_minimized)
+			{
+				WL_TRACE_SCOPE_CAT("render", "FrameRender");
 				FrameRender(wd, main_draw_data);
+			}
 
 			// Update and Render additional Platform Windows
 			if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
 			{
+				WL_TRACE_SCOPE_CAT("render", "RenderPlatformWindows");
 				ImGui::UpdatePlatformWindows();
 				ImGui::RenderPlatformWindowsDefault();
 			}
 
 			// Present Main Platform Window
 			if (!main_is_minimized)
+			{
+				WL_TRACE_SCOPE_CAT("render", "FramePresent");
 				FramePresent(wd);
+			}
+
+			if (!s_StartupReported)
+			{
+				MarkStartupPhase("first frame");
+				ReportStartupTimeline();
+				s_StartupReported = true;
+			}
+
+			if (io.WantTextInput)
+				RequestFrame(s_CaretBlinkInterval);
+
+			LimitFrameRate();
 
 			float time = GetTime();
 			m_FrameTime = time - m_LastFrameTime;
@@ -698,6 +967,67 @@ namespace Walnut {
 		return (float)glfwGetTime();
 	}
 
+	void Application::RequestFrame(float delay)
+	{
+		const double time = glfwGetTime() + delay;
+		if (m_RequestedFrameTime < 0.0 || time < m_RequestedFrameTime)
+			m_RequestedFrameTime = time;
+	}
+
+	void Application::PostWakeEvent()
+	{
+		if (s_IsGlfwInitialized)
+			glfwPostEmptyEvent();
+	}
+
+	void Application::WaitForEvents()
+	{
+		const bool isBusy = !m_Specification.IdleRendering || m_ActiveFrames > 0 || g_SwapChainRebuild || ImGui::IsAnyMouseDown();
+		if (isBusy)
+		{
+			m_ActiveFrames = glm::max(m_ActiveFrames - 1, 0);
+			glfwPollEvents();
+			return;
+		}
+
+		const double start = glfwGetTime();
+		double timeout = m_Specification.IdleTimeout;
+		if (m_RequestedFrameTime >= 0.0)
+			timeout = glm::min(timeout, m_RequestedFrameTime - start);
+
+		if (timeout <= 0.0)
+		{
+			glfwPollEvents();
+		}
+		else
+		{
+			WL_TRACE_SCOPE_CAT("frame", "Idle");
+			glfwWaitEventsTimeout(timeout);
+
+			// Woken before the timeout by input or PostWakeEvent
+			if (glfwGetTime() - start < timeout)
+				m_ActiveFrames = s_SettleFrameCount;
+		}
+
+		if (m_RequestedFrameTime >= 0.0 && glfwGetTime() >= m_RequestedFrameTime)
+			m_RequestedFrameTime = -1.0;
+	}
+
+	void Application::LimitFrameRate()
+	{
+		if (m_Specification.MaxFrameRate == 0)
+			return;
+
+		// Sleeping rather than waiting for events, input arriving meanwhile is picked up by the next poll
+		const double frameEnd = m_LastFrameTime + 1.0 / m_Specification.MaxFrameRate;
+		const double remaining = frameEnd - glfwGetTime();
+		if (remaining > 0.0)
+		{
+			WL_TRACE_SCOPE_CAT("frame", "LimitFrameRate");
+			std::this_thread::sleep_for(std::chrono::duration<double>(remaining));
+		}
+	}
+
 	VkInstance Application::GetInstance()
 	{
 		return g_Instance;
@@ -713,6 +1043,11 @@ namespace Walnut {
 		return g_Device;
 	}
 
+	VkDescriptorPool Application::GetDescriptorPool()
+	{
+		return g_DescriptorPool;
+	}
+
 	VkCommandBuffer Application::GetCommandBuffer(bool begin)
 	{
 		ImGui_ImplVulkanH_Window* wd = &g_MainWindowData;
@@ -767,6 +1102,26 @@ namespace Walnut {
 	}
 
 
+	JobSystem& Application::GetJobSystem()
+	{
+		return *s_JobSystem;
+	}
+
+	UploadQueue& Application::GetUploadQueue()
+	{
+		return *s_UploadQueue;
+	}
+
+	MemoryAllocator& Application::GetMemoryAllocator()
+	{
+		return *s_MemoryAllocator;
+	}
+
+	VkSampler Application::GetSampler()
+	{
+		return s_Sampler;
+	}
+
 	void Application::SubmitResourceFree(std::function<void()>&& func)
 	{
 		s_ResourceFreeQueue[s_CurrentFrameIndex].emplace_back(func);
@@ -21,8 +21,30 @@ namespace Walnut {
     std::string Name = "Walnut App";
     uint32_t Width = 1600;
     uint32_t Height = 900;
+
+    // Wait for input instead of rendering continuously while nothing changes
+    bool IdleRendering = false;
+    // Longest wait between frames while idle, in seconds
+    float IdleTimeout = 1.0f;
+    // Frames per second while active, 0 leaves the pace to the swap chain
+    uint32_t MaxFrameRate = 0;
+
+    // Persistently mapped staging memory shared by all image uploads of a frame
+    uint64_t UploadRingSize = 32 * 1024 * 1024;
+    // Device memory is allocated in blocks of this size and shared by the images in it
+    uint64_t MemoryBlockSize = 64 * 1024 * 1024;
+
+    // Where the pipeline cache and the baked font atlas are kept between runs, empty disables both
+    std::string CacheDirectory = ".";
+
+    // Workers of the job system, 0 uses all hardware threads but the one of the main loop
+    uint32_t JobThreadCount = 0;
   };
 
+  class JobSystem;
+  class MemoryAllocator;
+  class UploadQueue;
+
   class Application
   {
   public:
@@ -48,17 +70,35 @@ namespace Walnut {
     float GetTime();
     GLFWwindow* GetWindowHandle() const { return m_WindowHandle; }
 
+    // Renders a frame no later than delay seconds from now even if idle, for animations and polling.
+    // Main thread only, background threads use PostWakeEvent.
+    void RequestFrame(float delay = 0.0f);
+
+    // Wakes the main loop from an idle wait, callable from any thread
+    static void PostWakeEvent();
+
     static VkInstance GetInstance();
     static VkPhysicalDevice GetPhysicalDevice();
     static VkDevice GetDevice();
+    static VkDescriptorPool GetDescriptorPool();
 
     static VkCommandBuffer GetCommandBuffer(bool begin);
     static void FlushCommandBuffer(VkCommandBuffer commandBuffer);
 
+    // Continuations of its jobs run in Run before Layer::OnUpdate
+    static JobSystem& GetJobSystem();
+    static UploadQueue& GetUploadQueue();
+    static MemoryAllocator& GetMemoryAllocator();
+    // Linear filtering, repeat addressing, shared by every image
+    static VkSampler GetSampler();
+
     static void SubmitResourceFree(std::function<void()>&& func);
   private:
     void Init();
     void Shutdown();
+
+    void WaitForEvents();
+    void LimitFrameRate();
   private:
     ApplicationSpecification m_Specification;
     GLFWwindow* m_WindowHandle = nullptr;
@@ -68,6 +108,11 @@ namespace Walnut {
     float m_FrameTime = 0.0f;
     float m_LastFrameTime = 0.0f;
 
+    // Frames still rendered without waiting, ImGui needs a few to settle after input
+    int m_ActiveFrames = 0;
+    // Time of the earliest frame requested with RequestFrame, negative if none
+    double m_RequestedFrameTime = -1.0;
+
     std::vector<std::shared_ptr<Layer>> m_LayerStack;
     std::function<void()> m_MenubarCallback;
   };
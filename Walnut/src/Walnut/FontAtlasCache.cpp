@@ -0,0 +1,279 @@
+#include "FontAtlasCache.h"
+
+#include "imgui.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace Walnut {
+
+	static constexpr uint32_t s_FileMagic = 0x41464C57; // "WLFA"
+	static constexpr uint32_t s_FileVersion = 1;
+
+	namespace Utils {
+
+		static void HashBytes(uint64_t& hash, const void* data, size_t size)
+		{
+			// FNV-1a
+			const uint8_t* bytes = (const uint8_t*)data;
+			for (size_t i = 0; i < size; i++)
+			{
+				hash ^= bytes[i];
+				hash *= 0x100000001B3ull;
+			}
+		}
+
+		template<typename T>
+		static void HashValue(uint64_t& hash, const T& value)
+		{
+			HashBytes(hash, &value, sizeof(T));
+		}
+
+		template<typename T>
+		static void Write(std::ofstream& out, const T& value)
+		{
+			out.write((const char*)&value, sizeof(T));
+		}
+
+		template<typename T>
+		static bool Read(std::ifstream& in, T& value)
+		{
+			return (bool)in.read((char*)&value, sizeof(T));
+		}
+
+	}
+
+	struct CachedFont
+	{
+		float FontSize, Ascent, Descent;
+		int MetricsTotalSurface;
+		ImWchar FallbackChar, EllipsisChar;
+		std::vector<ImFontGlyph> Glyphs;
+	};
+
+	uint64_t FontAtlasCache::ComputeKey(const ImFontAtlas& atlas)
+	{
+		uint64_t hash = 0xCBF29CE484222325ull;
+
+		// Glyphs are stored as they are in memory, another ImGui version may lay them out differently
+		Utils::HashValue(hash, (int)IMGUI_VERSION_NUM);
+		Utils::HashValue(hash, sizeof(ImFontGlyph));
+
+		Utils::HashValue(hash, atlas.Flags);
+		Utils::HashValue(hash, atlas.TexDesiredWidth);
+		Utils::HashValue(hash, atlas.TexGlyphPadding);
+		Utils::HashValue(hash, atlas.Fonts.Size);
+
+		for (const ImFontConfig& config : atlas.ConfigData)
+		{
+			Utils::HashBytes(hash, config.FontData, (size_t)config.FontDataSize);
+			Utils::HashValue(hash, config.FontNo);
+			Utils::HashValue(hash, config.SizePixels);
+			Utils::HashValue(hash, config.OversampleH);
+			Utils::HashValue(hash, config.OversampleV);
+			Utils::HashValue(hash, config.PixelSnapH);
+			Utils::HashValue(hash, config.GlyphExtraSpacing);
+			Utils::HashValue(hash, config.GlyphOffset);
+			Utils::HashValue(hash, config.GlyphMinAdvanceX);
+			Utils::HashValue(hash, config.GlyphMaxAdvanceX);
+			Utils::HashValue(hash, config.MergeMode);
+			Utils::HashValue(hash, config.FontBuilderFlags);
+			Utils::HashValue(hash, config.RasterizerMultiply);
+			Utils::HashValue(hash, config.EllipsisChar);
+
+			// The ranges are zero terminated pairs, null picks the default ranges
+			const ImWchar* ranges = config.GlyphRanges;
+			for (; ranges && ranges[0]; ranges += 2)
+				Utils::HashBytes(hash, ranges, sizeof(ImWchar) * 2);
+			Utils::HashValue(hash, ranges != nullptr);
+
+			// Merged configs are hashed with the font they belong to
+			for (int i = 0; i < atlas.Fonts.Size; i++)
+			{
+				if (atlas.Fonts[i] == config.DstFont)
+					Utils::HashValue(hash, i);
+			}
+		}
+
+		return hash;
+	}
+
+	bool FontAtlasCache::Load(ImFontAtlas& atlas, const std::string& path, uint64_t key)
+	{
+		std::ifstream in(path, std::ios::binary);
+		if (!in)
+			return false;
+
+		uint32_t magic = 0, version = 0;
+		uint64_t fileKey = 0;
+		if (!Utils::Read(in, magic) || !Utils::Read(in, version) || !Utils::Read(in, fileKey))
+			return false;
+		if (magic != s_FileMagic || version != s_FileVersion || fileKey != key)
+			return false;
+
+		// Everything is read before the atlas is touched, a truncated file leaves it as it was
+		int width = 0, height = 0;
+		ImVec2 uvScale, uvWhitePixel;
+		ImVec4 uvLines[IM_ARRAYSIZE(atlas.TexUvLines)];
+		int packIdMouseCursors = 0, packIdLines = 0;
+		int customRectCount = 0, fontCount = 0;
+		if (!Utils::Read(in, width) || !Utils::Read(in, height) || !Utils::Read(in, uvScale) || !Utils::Read(in, uvWhitePixel)
+			|| !Utils::Read(in, uvLines) || !Utils::Read(in, packIdMouseCursors) || !Utils::Read(in, packIdLines)
+			|| !Utils::Read(in, customRectCount) || customRectCount < 0)
+			return false;
+
+		std::vector<ImFontAtlasCustomRect> customRects(customRectCount);
+		for (auto& rect : customRects)
+		{
+			if (!Utils::Read(in, rect.Width) || !Utils::Read(in, rect.Height) || !Utils::Read(in, rect.X) || !Utils::Read(in, rect.Y)
+				|| !Utils::Read(in, rect.GlyphID) || !Utils::Read(in, rect.GlyphAdvanceX) || !Utils::Read(in, rect.GlyphOffset))
+				return false;
+			rect.Font = nullptr;
+		}
+
+		if (!Utils::Read(in, fontCount) || fontCount != atlas.Fonts.Size)
+			return false;
+
+		std::vector<CachedFont> fonts(fontCount);
+		for (auto& font : fonts)
+		{
+			int glyphCount = 0;
+			if (!Utils::Read(in, font.FontSize) || !Utils::Read(in, font.Ascent) || !Utils::Read(in, font.Descent)
+				|| !Utils::Read(in, font.MetricsTotalSurface) || !Utils::Read(in, font.FallbackChar) || !Utils::Read(in, font.EllipsisChar)
+				|| !Utils::Read(in, glyphCount) || glyphCount < 0)
+				return false;
+
+			font.Glyphs.resize(glyphCount);
+			if (!in.read((char*)font.Glyphs.data(), sizeof(ImFontGlyph) * glyphCount))
+				return false;
+		}
+
+		if (width <= 0 || height <= 0)
+			return false;
+		std::vector<unsigned char> pixels((size_t)width * height);
+		if (!in.read((char*)pixels.data(), pixels.size()))
+			return false;
+
+		atlas.ClearTexData();
+		atlas.TexPixelsAlpha8 = (unsigned char*)IM_ALLOC(pixels.size());
+		memcpy(atlas.TexPixelsAlpha8, pixels.data(), pixels.size());
+		atlas.TexWidth = width;
+		atlas.TexHeight = height;
+		atlas.TexUvScale = uvScale;
+		atlas.TexUvWhitePixel = uvWhitePixel;
+		memcpy(atlas.TexUvLines, uvLines, sizeof(uvLines));
+
+		atlas.CustomRects.resize(customRectCount);
+		for (int i = 0; i < customRectCount; i++)
+			atlas.CustomRects[i] = customRects[i];
+		atlas.PackIdMouseCursors = packIdMouseCursors;
+		atlas.PackIdLines = packIdLines;
+
+		// What ImFontAtlasBuildSetupFont and ImFontAtlasBuildFinish do after rasterizing
+		for (int i = 0; i < fontCount; i++)
+		{
+			ImFont* dstFont = atlas.Fonts[i];
+			CachedFont& font = fonts[i];
+
+			dstFont->ClearOutputData();
+			dstFont->ContainerAtlas = &atlas;
+			dstFont->ConfigData = nullptr;
+			dstFont->ConfigDataCount = 0;
+			for (ImFontConfig& config : atlas.ConfigData)
+			{
+				if (config.DstFont != dstFont)
+					continue;
+				if (!dstFont->ConfigData)
+					dstFont->ConfigData = &config;
+				dstFont->ConfigDataCount++;
+			}
+
+			dstFont->FontSize = font.FontSize;
+			dstFont->Ascent = font.Ascent;
+			dstFont->Descent = font.Descent;
+			dstFont->MetricsTotalSurface = font.MetricsTotalSurface;
+			dstFont->FallbackChar = font.FallbackChar;
+			dstFont->EllipsisChar = font.EllipsisChar;
+			dstFont->Glyphs.resize((int)font.Glyphs.size());
+			if (!font.Glyphs.empty())
+				memcpy(dstFont->Glyphs.Data, font.Glyphs.data(), sizeof(ImFontGlyph) * font.Glyphs.size());
+			dstFont->BuildLookupTable();
+		}
+
+		atlas.TexReady = true;
+		return true;
+	}
+
+	bool FontAtlasCache::Save(const ImFontAtlas& atlas, const std::string& path, uint64_t key)
+	{
+		if (!atlas.TexReady || !atlas.TexPixelsAlpha8)
+			return false;
+
+		// Glyph rectangles point at their font, the cache only knows the rectangles ImGui adds itself
+		for (const ImFontAtlasCustomRect& rect : atlas.CustomRects)
+		{
+			if (rect.Font)
+				return false;
+		}
+
+		const std::string tempPath = path + ".tmp";
+		{
+			std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+			if (!out)
+				return false;
+
+			Utils::Write(out, s_FileMagic);
+			Utils::Write(out, s_FileVersion);
+			Utils::Write(out, key);
+
+			Utils::Write(out, atlas.TexWidth);
+			Utils::Write(out, atlas.TexHeight);
+			Utils::Write(out, atlas.TexUvScale);
+			Utils::Write(out, atlas.TexUvWhitePixel);
+			Utils::Write(out, atlas.TexUvLines);
+			Utils::Write(out, atlas.PackIdMouseCursors);
+			Utils::Write(out, atlas.PackIdLines);
+
+			Utils::Write(out, atlas.CustomRects.Size);
+			for (const ImFontAtlasCustomRect& rect : atlas.CustomRects)
+			{
+				Utils::Write(out, rect.Width);
+				Utils::Write(out, rect.Height);
+				Utils::Write(out, rect.X);
+				Utils::Write(out, rect.Y);
+				Utils::Write(out, rect.GlyphID);
+				Utils::Write(out, rect.GlyphAdvanceX);
+				Utils::Write(out, rect.GlyphOffset);
+			}
+
+			Utils::Write(out, atlas.Fonts.Size);
+			for (const ImFont* font : atlas.Fonts)
+			{
+				Utils::Write(out, font->FontSize);
+				Utils::Write(out, font->Ascent);
+				Utils::Write(out, font->Descent);
+				Utils::Write(out, font->MetricsTotalSurface);
+				Utils::Write(out, font->FallbackChar);
+				Utils::Write(out, font->EllipsisChar);
+				Utils::Write(out, font->Glyphs.Size);
+				out.write((const char*)font->Glyphs.Data, sizeof(ImFontGlyph) * font->Glyphs.Size);
+			}
+
+			out.write((const char*)atlas.TexPixelsAlpha8, (size_t)atlas.TexWidth * atlas.TexHeight);
+			if (!out.flush())
+			{
+				out.close();
+				std::remove(tempPath.c_str());
+				return false;
+			}
+		}
+
+#ifdef _WIN32
+		std::remove(path.c_str());
+#endif
+		return std::rename(tempPath.c_str(), path.c_str()) == 0;
+	}
+
+}
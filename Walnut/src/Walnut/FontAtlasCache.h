@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+struct ImFontAtlas;
+
+namespace Walnut {
+
+	// Keeps the rasterized font atlas on disk, so a launch with the same fonts skips building it.
+	// The key covers the font data, the sizes and every config that changes the glyphs, and the ImGui version.
+	class FontAtlasCache
+	{
+	public:
+		static uint64_t ComputeKey(const ImFontAtlas& atlas);
+
+		// Fills the atlas as Build would. The fonts must be added already, with the configs the key was computed from.
+		// Returns false and leaves the atlas untouched if the file is missing or was written for another key.
+		static bool Load(ImFontAtlas& atlas, const std::string& path, uint64_t key);
+
+		// The atlas must be built and still hold its alpha texture
+		static bool Save(const ImFontAtlas& atlas, const std::string& path, uint64_t key);
+	};
+
+}
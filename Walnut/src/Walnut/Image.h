@@ -2,6 +2,8 @@
 
 #include <string>
 
+#include "MemoryAllocator.h"
+
 #include "vulkan/vulkan.h"
 
 namespace Walnut {
@@ -20,7 +22,13 @@ namespace Walnut {
 		Image(uint32_t width, uint32_t height, ImageFormat format, const void* data = nullptr);
 		~Image();
 
+		// Queues the upload with the next frame, the image can be drawn right away
 		void SetData(const void* data);
+		// Replaces a rectangle of width * height pixels and keeps the rest
+		void SetData(const void* data, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
+		// True once the GPU has finished the last upload from SetData
+		bool IsUploaded() const;
+		uint64_t GetUploadTicket() const { return m_UploadTicket; }
 
 		VkDescriptorSet GetDescriptorSet() const { return m_DescriptorSet; }
 
@@ -36,15 +44,12 @@ namespace Walnut {
 
 		VkImage m_Image = nullptr;
 		VkImageView m_ImageView = nullptr;
-		VkDeviceMemory m_Memory = nullptr;
-		VkSampler m_Sampler = nullptr;
+		MemoryAllocation m_Memory;
 
 		ImageFormat m_Format = ImageFormat::None;
 
-		VkBuffer m_StagingBuffer = nullptr;
-		VkDeviceMemory m_StagingBufferMemory = nullptr;
-
-		size_t m_AlignedSize = 0;
+		uint64_t m_UploadTicket = 0;
+		bool m_HasData = false;
 
 		VkDescriptorSet m_DescriptorSet = nullptr;
 
@@ -0,0 +1,153 @@
+#include "JobSystem.h"
+
+#include "Application.h"
+#include "Trace.h"
+
+#include <algorithm>
+
+namespace Walnut {
+
+	// Set on worker threads, jobs scheduled from a job go to the queue of the worker running it
+	static thread_local JobSystem* s_CurrentJobSystem = nullptr;
+	static thread_local uint32_t s_CurrentWorkerIndex = 0;
+
+	JobSystem::JobSystem(uint32_t threadCount)
+	{
+		if (threadCount == 0)
+			threadCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+		m_Workers.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++)
+			m_Workers.push_back(std::make_unique<Worker>());
+
+		// Started once every queue exists, workers steal from all of them
+		for (uint32_t i = 0; i < threadCount; i++)
+			m_Workers[i]->Thread = std::thread(&JobSystem::RunWorker, this, i);
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::scoped_lock lock(m_SleepMutex);
+			m_IsStopping = true;
+		}
+		m_Wakeup.notify_all();
+
+		for (auto& worker : m_Workers)
+			worker->Thread.join();
+	}
+
+	void JobSystem::Schedule(Job job, JobPriority priority, const CancellationToken& token)
+	{
+		uint32_t index;
+		if (s_CurrentJobSystem == this)
+			index = s_CurrentWorkerIndex;
+		else
+			index = m_NextWorker.fetch_add(1) % (uint32_t)m_Workers.size();
+
+		// Counted before it is queued, so a worker taking it never sees the count drop below zero
+		{
+			std::scoped_lock lock(m_SleepMutex);
+			m_QueuedCount++;
+		}
+
+		{
+			Worker& worker = *m_Workers[index];
+			std::scoped_lock lock(worker.Mutex);
+			worker.Queues[(size_t)priority].push_back({ std::move(job), token });
+		}
+		m_Wakeup.notify_one();
+	}
+
+	void JobSystem::Post(Job func, const CancellationToken& token)
+	{
+		{
+			std::scoped_lock lock(m_ContinuationMutex);
+			m_Continuations.push_back({ std::move(func), token });
+		}
+		Application::PostWakeEvent();
+	}
+
+	void JobSystem::RunContinuations()
+	{
+		std::vector<QueuedJob> continuations;
+		{
+			std::scoped_lock lock(m_ContinuationMutex);
+			continuations.swap(m_Continuations);
+		}
+
+		// Posted by these continuations runs next frame, a continuation posting itself cannot stall the frame
+		for (auto& continuation : continuations)
+		{
+			if (!continuation.Token.IsCancelled())
+				continuation.Func();
+		}
+	}
+
+	void JobSystem::RunWorker(uint32_t index)
+	{
+		WL_TRACE_THREAD_NAME("Job Worker");
+
+		s_CurrentJobSystem = this;
+		s_CurrentWorkerIndex = index;
+
+		while (true)
+		{
+			// Checked before taking a job, so the jobs still queued are dropped rather than drained
+			if (m_IsStopping)
+				return;
+
+			QueuedJob job;
+			if (TakeJob(index, job))
+			{
+				if (!job.Token.IsCancelled())
+				{
+					WL_TRACE_SCOPE_CAT("jobs", "Job");
+					job.Func();
+				}
+				continue;
+			}
+
+			std::unique_lock lock(m_SleepMutex);
+			m_Wakeup.wait(lock, [this]() { return m_IsStopping || m_QueuedCount > 0; });
+			if (m_IsStopping)
+				return;
+		}
+	}
+
+	bool JobSystem::TakeJob(uint32_t index, QueuedJob& job)
+	{
+		const uint32_t workerCount = (uint32_t)m_Workers.size();
+
+		// A higher priority job anywhere comes before a lower one on the own queue
+		for (size_t priority = 0; priority < s_PriorityCount; priority++)
+		{
+			for (uint32_t offset = 0; offset < workerCount; offset++)
+			{
+				Worker& worker = *m_Workers[(index + offset) % workerCount];
+				std::scoped_lock lock(worker.Mutex);
+
+				auto& queue = worker.Queues[priority];
+				if (queue.empty())
+					continue;
+
+				// The own queue newest first while its data is still in cache, stolen jobs oldest first
+				if (offset == 0)
+				{
+					job = std::move(queue.back());
+					queue.pop_back();
+				}
+				else
+				{
+					job = std::move(queue.front());
+					queue.pop_front();
+				}
+				m_QueuedCount--;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+}
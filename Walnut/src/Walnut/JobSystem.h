@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Walnut {
+
+	enum class JobPriority
+	{
+		High = 0, Normal, Low
+	};
+
+	// Copies share one flag. A cancelled job that has not started is skipped, and so is its continuation,
+	// a running job may poll IsCancelled to stop early.
+	class CancellationToken
+	{
+	public:
+		CancellationToken() : m_IsCancelled(std::make_shared<std::atomic<bool>>(false)) {}
+
+		void Cancel() { m_IsCancelled->store(true); }
+		bool IsCancelled() const { return m_IsCancelled->load(); }
+	private:
+		std::shared_ptr<std::atomic<bool>> m_IsCancelled;
+	};
+
+	// Worker threads with a queue each, an idle worker steals the oldest job of a busy one.
+	// Results go back to the main thread through a queue drained once per frame by Application::Run,
+	// so continuations may use ImGui and Vulkan while jobs must not.
+	class JobSystem
+	{
+	public:
+		using Job = std::function<void()>;
+
+		// 0 starts one worker per hardware thread but one, the main thread keeps the last
+		explicit JobSystem(uint32_t threadCount = 0);
+		// Waits for the running jobs, queued ones are dropped
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+		// Callable from any thread, a worker scheduling a job keeps it on its own queue
+		void Schedule(Job job, JobPriority priority = JobPriority::Normal, const CancellationToken& token = CancellationToken());
+
+		// Runs work on a worker and passes its result to continuation on the main thread
+		template<typename Work, typename Continuation>
+		void Schedule(Work&& work, Continuation&& continuation, JobPriority priority = JobPriority::Normal, const CancellationToken& token = CancellationToken())
+		{
+			Schedule([this, work = std::forward<Work>(work), continuation = std::forward<Continuation>(continuation), token]() mutable
+			{
+				if constexpr (std::is_void_v<std::invoke_result_t<Work&>>)
+				{
+					work();
+					Post(std::move(continuation), token);
+				}
+				else
+				{
+					// Shared, std::function needs a copyable callable and the result may be move only
+					auto result = std::make_shared<std::invoke_result_t<Work&>>(work());
+					Post([continuation = std::move(continuation), result]() mutable { continuation(std::move(*result)); }, token);
+				}
+			}, priority, token);
+		}
+
+		// Queues func for the main thread and wakes it, callable from any thread
+		void Post(Job func, const CancellationToken& token = CancellationToken());
+
+		// Main thread only
+		void RunContinuations();
+
+		uint32_t GetThreadCount() const { return (uint32_t)m_Workers.size(); }
+	private:
+		static constexpr size_t s_PriorityCount = 3;
+
+		struct QueuedJob
+		{
+			Job Func;
+			CancellationToken Token;
+		};
+
+		struct Worker
+		{
+			std::mutex Mutex;
+			std::deque<QueuedJob> Queues[s_PriorityCount];
+			std::thread Thread;
+		};
+
+		void RunWorker(uint32_t index);
+		bool TakeJob(uint32_t index, QueuedJob& job);
+	private:
+		std::vector<std::unique_ptr<Worker>> m_Workers;
+		std::atomic<uint32_t> m_NextWorker{ 0 };
+
+		// Idle workers sleep on m_Wakeup until a job is queued anywhere
+		std::mutex m_SleepMutex;
+		std::condition_variable m_Wakeup;
+		std::atomic<uint32_t> m_QueuedCount{ 0 };
+		// Written under m_SleepMutex so no sleeping worker misses it, read without it between jobs
+		std::atomic<bool> m_IsStopping{ false };
+
+		std::mutex m_ContinuationMutex;
+		std::vector<QueuedJob> m_Continuations;
+	};
+
+}
@@ -0,0 +1,178 @@
+#include "MemoryAllocator.h"
+
+#include "Application.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace Walnut {
+
+	namespace Utils {
+
+		static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+	}
+
+	MemoryAllocator::MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize blockSize)
+		: m_Device(device), m_BlockSize(blockSize)
+	{
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_MemoryProperties);
+		m_Blocks.resize(m_MemoryProperties.memoryTypeCount);
+	}
+
+	MemoryAllocator::~MemoryAllocator()
+	{
+		for (auto& blocks : m_Blocks)
+		{
+			for (auto& block : blocks)
+			{
+				if (block.Memory)
+					vkFreeMemory(m_Device, block.Memory, nullptr);
+			}
+		}
+	}
+
+	MemoryAllocation MemoryAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties)
+	{
+		MemoryAllocation allocation;
+		allocation.Size = requirements.size;
+		allocation.MemoryType = FindMemoryType(properties, requirements.memoryTypeBits);
+
+		VkResult err;
+
+		if (requirements.size > m_BlockSize / 2)
+		{
+			VkMemoryAllocateInfo alloc_info = {};
+			alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+			alloc_info.allocationSize = requirements.size;
+			alloc_info.memoryTypeIndex = allocation.MemoryType;
+			err = vkAllocateMemory(m_Device, &alloc_info, nullptr, &allocation.Memory);
+			check_vk_result(err);
+
+			allocation.Block = s_DedicatedBlock;
+			return allocation;
+		}
+
+		auto& blocks = m_Blocks[allocation.MemoryType];
+		for (uint32_t i = 0; i < (uint32_t)blocks.size(); i++)
+		{
+			if (blocks[i].Memory && AllocateFromBlock(blocks[i], requirements.size, requirements.alignment, allocation.Offset))
+			{
+				allocation.Memory = blocks[i].Memory;
+				allocation.Block = i;
+				return allocation;
+			}
+		}
+
+		// Reuse the slot of a released block before growing the list
+		auto it = std::find_if(blocks.begin(), blocks.end(), [](const Block& block) { return !block.Memory; });
+		if (it == blocks.end())
+			it = blocks.emplace(blocks.end());
+
+		VkMemoryAllocateInfo alloc_info = {};
+		alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		alloc_info.allocationSize = m_BlockSize;
+		alloc_info.memoryTypeIndex = allocation.MemoryType;
+		err = vkAllocateMemory(m_Device, &alloc_info, nullptr, &it->Memory);
+		check_vk_result(err);
+		it->FreeRanges = { { 0, m_BlockSize } };
+		it->Used = 0;
+
+		AllocateFromBlock(*it, requirements.size, requirements.alignment, allocation.Offset);
+		allocation.Memory = it->Memory;
+		allocation.Block = (uint32_t)(it - blocks.begin());
+		return allocation;
+	}
+
+	void MemoryAllocator::Free(const MemoryAllocation& allocation)
+	{
+		if (!allocation.Memory)
+			return;
+
+		if (allocation.Block == s_DedicatedBlock)
+		{
+			vkFreeMemory(m_Device, allocation.Memory, nullptr);
+			return;
+		}
+
+		auto& blocks = m_Blocks[allocation.MemoryType];
+		Block& block = blocks[allocation.Block];
+
+		VkDeviceSize offset = allocation.Offset;
+		VkDeviceSize size = allocation.Size;
+
+		auto next = block.FreeRanges.lower_bound(offset);
+		if (next != block.FreeRanges.begin())
+		{
+			auto prev = std::prev(next);
+			if (prev->first + prev->second == offset)
+			{
+				offset = prev->first;
+				size += prev->second;
+				block.FreeRanges.erase(prev);
+			}
+		}
+		if (next != block.FreeRanges.end() && offset + size == next->first)
+		{
+			size += next->second;
+			block.FreeRanges.erase(next);
+		}
+		block.FreeRanges.emplace(offset, size);
+		block.Used -= allocation.Size;
+
+		// Keep one block of each type around, images come and go in bursts
+		if (block.Used == 0 && std::count_if(blocks.begin(), blocks.end(), [](const Block& other) { return other.Memory; }) > 1)
+		{
+			vkFreeMemory(m_Device, block.Memory, nullptr);
+			block = Block();
+		}
+	}
+
+	uint32_t MemoryAllocator::FindMemoryType(VkMemoryPropertyFlags properties, uint32_t typeBits) const
+	{
+		for (uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount; i++)
+		{
+			if ((m_MemoryProperties.memoryTypes[i].propertyFlags & properties) == properties && typeBits & (1 << i))
+				return i;
+		}
+
+		return 0xffffffff;
+	}
+
+	uint32_t MemoryAllocator::GetBlockCount() const
+	{
+		uint32_t count = 0;
+		for (auto& blocks : m_Blocks)
+			count += (uint32_t)std::count_if(blocks.begin(), blocks.end(), [](const Block& block) { return block.Memory; });
+		return count;
+	}
+
+	bool MemoryAllocator::AllocateFromBlock(Block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset)
+	{
+		// First fit, the remainders before and after the aligned range stay free
+		for (auto it = block.FreeRanges.begin(); it != block.FreeRanges.end(); ++it)
+		{
+			const VkDeviceSize rangeStart = it->first;
+			const VkDeviceSize rangeEnd = it->first + it->second;
+			const VkDeviceSize start = Utils::AlignUp(rangeStart, alignment);
+			if (start + size > rangeEnd)
+				continue;
+
+			block.FreeRanges.erase(it);
+			if (start > rangeStart)
+				block.FreeRanges.emplace(rangeStart, start - rangeStart);
+			if (start + size < rangeEnd)
+				block.FreeRanges.emplace(start + size, rangeEnd - start - size);
+
+			block.Used += size;
+			offset = start;
+			return true;
+		}
+
+		return false;
+	}
+
+}
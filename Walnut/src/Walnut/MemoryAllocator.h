@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+namespace Walnut {
+
+	struct MemoryAllocation
+	{
+		VkDeviceMemory Memory = nullptr;
+		VkDeviceSize Offset = 0;
+		VkDeviceSize Size = 0;
+
+		// Index into the blocks of the memory type, s_DedicatedBlock if the allocation owns Memory
+		uint32_t Block = 0;
+		uint32_t MemoryType = 0;
+	};
+
+	// Hands out device memory from large blocks, so many small images cost a few vkAllocateMemory calls
+	// instead of one each and stay far below maxMemoryAllocationCount. Meant for optimal-tiling images only,
+	// linear resources would have to respect bufferImageGranularity next to them.
+	// Main thread only.
+	class MemoryAllocator
+	{
+	public:
+		static constexpr uint32_t s_DedicatedBlock = 0xffffffff;
+
+		MemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize blockSize);
+		~MemoryAllocator();
+
+		MemoryAllocator(const MemoryAllocator&) = delete;
+		MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+		// Requests larger than half a block get memory of their own
+		MemoryAllocation Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties);
+		void Free(const MemoryAllocation& allocation);
+
+		// Memory properties are read once, this is cheap to call for every resource
+		uint32_t FindMemoryType(VkMemoryPropertyFlags properties, uint32_t typeBits) const;
+
+		uint32_t GetBlockCount() const;
+	private:
+		struct Block
+		{
+			VkDeviceMemory Memory = nullptr;
+			// Free ranges by offset, adjacent ranges are merged
+			std::map<VkDeviceSize, VkDeviceSize> FreeRanges;
+			VkDeviceSize Used = 0;
+		};
+
+		bool AllocateFromBlock(Block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& offset);
+	private:
+		VkDevice m_Device = nullptr;
+		VkPhysicalDeviceMemoryProperties m_MemoryProperties = {};
+		VkDeviceSize m_BlockSize = 0;
+
+		// Blocks of each memory type, a freed block leaves an empty slot behind so indices stay valid
+		std::vector<std::vector<Block>> m_Blocks;
+	};
+
+}
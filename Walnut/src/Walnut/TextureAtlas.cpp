@@ -0,0 +1,166 @@
+#include "TextureAtlas.h"
+
+#include "Application.h"
+#include "UploadQueue.h"
+
+namespace Walnut {
+
+	// Gap between regions, so linear filtering at an edge never reads a neighbour
+	static constexpr uint32_t s_RegionPadding = 1;
+
+	// Shelves are this many pixels apart in height, images of similar height share them
+	static constexpr uint32_t s_ShelfHeightStep = 16;
+
+	TextureAtlas::TextureAtlas(uint32_t pageSize)
+		: m_PageSize(pageSize)
+	{
+	}
+
+	bool TextureAtlas::Add(uint32_t width, uint32_t height, const void* data, AtlasRegion& region)
+	{
+		if (width + s_RegionPadding > m_PageSize || height + s_RegionPadding > m_PageSize)
+			return false;
+
+		uint32_t pageIndex = 0;
+		for (; pageIndex < (uint32_t)m_Pages.size(); pageIndex++)
+		{
+			if (m_Pages[pageIndex].Texture && Allocate(m_Pages[pageIndex], width, height, region))
+				break;
+		}
+
+		if (pageIndex == (uint32_t)m_Pages.size())
+		{
+			// Reuse the entry of a released page before growing the list
+			for (pageIndex = 0; pageIndex < (uint32_t)m_Pages.size(); pageIndex++)
+			{
+				if (!m_Pages[pageIndex].Texture)
+					break;
+			}
+			if (pageIndex == (uint32_t)m_Pages.size())
+				m_Pages.emplace_back();
+
+			Page& page = m_Pages[pageIndex];
+			page.Texture = std::make_unique<Image>(m_PageSize, m_PageSize, ImageFormat::RGBA);
+			Allocate(page, width, height, region);
+		}
+
+		Page& page = m_Pages[pageIndex];
+		page.RegionCount++;
+
+		region.Page = pageIndex;
+		region.Width = width;
+		region.Height = height;
+
+		page.Texture->SetData(data, region.X, region.Y, width, height);
+		region.UploadTicket = page.Texture->GetUploadTicket();
+		return true;
+	}
+
+	void TextureAtlas::Remove(const AtlasRegion& region)
+	{
+		Page& page = m_Pages[region.Page];
+		Shelf& shelf = page.Shelves[region.Shelf];
+		shelf.Slots[region.Slot].IsUsed = false;
+
+		// Trailing free slots go back to the end of the shelf, so a wider image fits there again
+		while (!shelf.Slots.empty() && !shelf.Slots.back().IsUsed)
+		{
+			shelf.End = shelf.Slots.back().X;
+			shelf.Slots.pop_back();
+		}
+
+		if (--page.RegionCount == 0)
+		{
+			// Image defers the destruction until the frames drawing it are done
+			page = Page();
+		}
+	}
+
+	VkDescriptorSet TextureAtlas::GetDescriptorSet(const AtlasRegion& region) const
+	{
+		return m_Pages[region.Page].Texture->GetDescriptorSet();
+	}
+
+	ImVec2 TextureAtlas::GetUV0(const AtlasRegion& region) const
+	{
+		// Half a texel in, the sampler then never blends with the padding
+		return ImVec2((region.X + 0.5f) / m_PageSize, (region.Y + 0.5f) / m_PageSize);
+	}
+
+	ImVec2 TextureAtlas::GetUV1(const AtlasRegion& region) const
+	{
+		return ImVec2((region.X + region.Width - 0.5f) / m_PageSize, (region.Y + region.Height - 0.5f) / m_PageSize);
+	}
+
+	bool TextureAtlas::IsUploaded(const AtlasRegion& region) const
+	{
+		return Application::GetUploadQueue().IsComplete(region.UploadTicket);
+	}
+
+	uint32_t TextureAtlas::GetPageCount() const
+	{
+		uint32_t count = 0;
+		for (auto& page : m_Pages)
+		{
+			if (page.Texture)
+				count++;
+		}
+		return count;
+	}
+
+	bool TextureAtlas::Allocate(Page& page, uint32_t width, uint32_t height, AtlasRegion& region)
+	{
+		const uint32_t paddedWidth = width + s_RegionPadding;
+		const uint32_t shelfHeight = (height + s_RegionPadding + s_ShelfHeightStep - 1) / s_ShelfHeightStep * s_ShelfHeightStep;
+
+		for (uint32_t shelfIndex = 0; shelfIndex < (uint32_t)page.Shelves.size(); shelfIndex++)
+		{
+			Shelf& shelf = page.Shelves[shelfIndex];
+			if (shelf.Height != shelfHeight)
+				continue;
+
+			for (uint32_t slotIndex = 0; slotIndex < (uint32_t)shelf.Slots.size(); slotIndex++)
+			{
+				Slot& slot = shelf.Slots[slotIndex];
+				if (slot.IsUsed || slot.Width < paddedWidth)
+					continue;
+
+				slot.IsUsed = true;
+				region.Shelf = shelfIndex;
+				region.Slot = slotIndex;
+				region.X = slot.X;
+				region.Y = shelf.Y;
+				return true;
+			}
+
+			if (shelf.End + paddedWidth <= m_PageSize)
+			{
+				region.Shelf = shelfIndex;
+				region.Slot = (uint32_t)shelf.Slots.size();
+				region.X = shelf.End;
+				region.Y = shelf.Y;
+
+				shelf.Slots.push_back({ shelf.End, paddedWidth, true });
+				shelf.End += paddedWidth;
+				return true;
+			}
+		}
+
+		if (page.ShelvesEnd + shelfHeight > m_PageSize)
+			return false;
+
+		Shelf& shelf = page.Shelves.emplace_back();
+		shelf.Y = page.ShelvesEnd;
+		shelf.Height = shelfHeight;
+		shelf.Slots.push_back({ 0, paddedWidth, true });
+		shelf.End = paddedWidth;
+		page.ShelvesEnd += shelfHeight;
+
+		region.Shelf = (uint32_t)page.Shelves.size() - 1;
+		region.Slot = 0;
+		region.X = 0;
+		region.Y = shelf.Y;
+		return true;
+	}
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Image.h"
+
+#include <memory>
+#include <vector>
+
+#include "imgui.h"
+
+namespace Walnut {
+
+	struct AtlasRegion
+	{
+		uint32_t Page = 0;
+		uint32_t Shelf = 0;
+		uint32_t Slot = 0;
+
+		uint32_t X = 0, Y = 0;
+		uint32_t Width = 0, Height = 0;
+
+		uint64_t UploadTicket = 0;
+	};
+
+	// Packs many small RGBA images into a few large pages, each page is one image with one descriptor set.
+	// Regions are drawn with the descriptor set of their page and their UV rectangle.
+	// Pages are filled shelf by shelf, a removed region leaves a slot for one of similar height.
+	class TextureAtlas
+	{
+	public:
+		TextureAtlas(uint32_t pageSize = 2048);
+
+		// False if the image does not fit in a page
+		bool Add(uint32_t width, uint32_t height, const void* data, AtlasRegion& region);
+		void Remove(const AtlasRegion& region);
+
+		VkDescriptorSet GetDescriptorSet(const AtlasRegion& region) const;
+		ImVec2 GetUV0(const AtlasRegion& region) const;
+		ImVec2 GetUV1(const AtlasRegion& region) const;
+
+		// True once the pixels of the region are on the GPU
+		bool IsUploaded(const AtlasRegion& region) const;
+
+		uint32_t GetPageCount() const;
+	private:
+		struct Slot
+		{
+			uint32_t X = 0;
+			uint32_t Width = 0;
+			bool IsUsed = false;
+		};
+
+		struct Shelf
+		{
+			uint32_t Y = 0;
+			uint32_t Height = 0;
+			uint32_t End = 0;
+			std::vector<Slot> Slots;
+		};
+
+		struct Page
+		{
+			std::unique_ptr<Image> Texture;
+			std::vector<Shelf> Shelves;
+			uint32_t ShelvesEnd = 0;
+			uint32_t RegionCount = 0;
+		};
+
+		bool Allocate(Page& page, uint32_t width, uint32_t height, AtlasRegion& region);
+	private:
+		uint32_t m_PageSize = 0;
+
+		// A page without regions is released, its entry stays so region indices remain valid
+		std::vector<Page> m_Pages;
+	};
+
+}
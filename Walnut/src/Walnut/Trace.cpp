@@ -0,0 +1,215 @@
+#include "Trace.h"
+
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <fstream>
+
+namespace Walnut {
+
+	namespace {
+
+		struct ThreadBuffer
+		{
+			std::mutex Lock; // only contended while a trace is being written
+			std::vector<TraceEvent> Events;
+			size_t Next = 0;
+			bool Wrapped = false;
+			uint32_t ThreadId = 0;
+			std::string ThreadName;
+		};
+
+		struct Registry
+		{
+			std::mutex Lock;
+			std::vector<std::shared_ptr<ThreadBuffer>> Buffers;
+			// Buffers of exited threads in exit order, handed to the threads started next
+			std::vector<std::shared_ptr<ThreadBuffer>> Free;
+			std::atomic<uint32_t> NextThreadId{ 1 };
+		};
+
+		// Timestamps are written relative to program start
+		const uint64_t s_Epoch = Trace::Now();
+
+		Registry& GetRegistry()
+		{
+			static Registry registry;
+			return registry;
+		}
+
+		std::shared_ptr<ThreadBuffer> AcquireThreadBuffer()
+		{
+			Registry& registry = GetRegistry();
+			const uint32_t threadId = registry.NextThreadId++;
+
+			std::scoped_lock lock(registry.Lock);
+
+			// A ring already written out is reused as is
+			auto it = std::find_if(registry.Free.begin(), registry.Free.end(), [](const std::shared_ptr<ThreadBuffer>& buffer)
+			{
+				std::scoped_lock bufferLock(buffer->Lock);
+				return buffer->Next == 0 && !buffer->Wrapped;
+			});
+			if (it == registry.Free.end() && (registry.Free.empty() || registry.Buffers.size() < Trace::RetainedThreadBuffers))
+			{
+				auto result = std::make_shared<ThreadBuffer>();
+				result->Events.resize(Trace::EventsPerThread);
+				result->ThreadId = threadId;
+				registry.Buffers.push_back(result);
+				return result;
+			}
+
+			// Drops the events of the thread that exited first
+			if (it == registry.Free.end())
+				it = registry.Free.begin();
+
+			auto result = *it;
+			registry.Free.erase(it);
+
+			std::scoped_lock bufferLock(result->Lock);
+			result->Next = 0;
+			result->Wrapped = false;
+			result->ThreadId = threadId;
+			result->ThreadName.clear();
+			return result;
+		}
+
+		// Returns the buffer to the registry when its thread exits, the registry
+		// keeps it for the next written trace and for reuse.
+		struct ThreadBufferOwner
+		{
+			std::shared_ptr<ThreadBuffer> Buffer = AcquireThreadBuffer();
+
+			~ThreadBufferOwner()
+			{
+				Registry& registry = GetRegistry();
+				std::scoped_lock lock(registry.Lock);
+				registry.Free.push_back(std::move(Buffer));
+			}
+		};
+
+		ThreadBuffer& GetThreadBuffer()
+		{
+			thread_local ThreadBufferOwner owner;
+			return *owner.Buffer;
+		}
+
+		void WriteJsonString(std::ostream& out, const char* str)
+		{
+			out << '"';
+			for (const char* c = str ? str : ""; *c; ++c)
+			{
+				switch (*c)
+				{
+					case '"':  out << "\\\""; break;
+					case '\\': out << "\\\\"; break;
+					case '\n': out << "\\n"; break;
+					case '\r': out << "\\r"; break;
+					case '\t': out << "\\t"; break;
+					default:
+						if ((unsigned char)*c < 0x20)
+							out << ' ';
+						else
+							out << *c;
+				}
+			}
+			out << '"';
+		}
+
+	}
+
+	void Trace::Record(const char* name, const char* category, uint64_t startNs, uint64_t endNs)
+	{
+		ThreadBuffer& buffer = GetThreadBuffer();
+
+		std::scoped_lock lock(buffer.Lock);
+		buffer.Events[buffer.Next] = TraceEvent{ name, category, startNs, endNs - startNs };
+		if (++buffer.Next == buffer.Events.size())
+		{
+			buffer.Next = 0;
+			buffer.Wrapped = true;
+		}
+	}
+
+	void Trace::SetThreadName(const char* name)
+	{
+		ThreadBuffer& buffer = GetThreadBuffer();
+
+		std::scoped_lock lock(buffer.Lock);
+		buffer.ThreadName = name;
+	}
+
+	bool Trace::WriteChromeJson(const std::string& path)
+	{
+		std::ofstream out(path, std::ios::binary);
+		if (!out)
+			return false;
+
+		Registry& registry = GetRegistry();
+		std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+		{
+			std::scoped_lock lock(registry.Lock);
+			buffers = registry.Buffers;
+		}
+
+		bool first = true;
+		auto separator = [&]()
+		{
+			if (!first)
+				out << ",\n";
+			first = false;
+		};
+
+		out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		for (auto& buffer : buffers)
+		{
+			std::scoped_lock lock(buffer->Lock);
+
+			if (!buffer->ThreadName.empty())
+			{
+				separator();
+				out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->ThreadId << ",\"args\":{\"name\":";
+				WriteJsonString(out, buffer->ThreadName.c_str());
+				out << "}}";
+			}
+
+			const size_t count = buffer->Wrapped ? buffer->Events.size() : buffer->Next;
+			const size_t begin = buffer->Wrapped ? buffer->Next : 0;
+			for (size_t i = 0; i < count; i++)
+			{
+				const TraceEvent& event = buffer->Events[(begin + i) % buffer->Events.size()];
+				const uint64_t start = event.StartNs > s_Epoch ? event.StartNs - s_Epoch : 0;
+
+				separator();
+				out << "{\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->ThreadId << ",\"name\":";
+				WriteJsonString(out, event.Name);
+				out << ",\"cat\":";
+				WriteJsonString(out, event.Category);
+				out << ",\"ts\":" << start / 1000 << '.' << (start % 1000) / 100
+					<< ",\"dur\":" << event.DurationNs / 1000 << '.' << (event.DurationNs % 1000) / 100 << '}';
+			}
+
+			buffer->Next = 0;
+			buffer->Wrapped = false;
+		}
+		out << "\n]}\n";
+
+		return (bool)out;
+	}
+
+	void Trace::Clear()
+	{
+		Registry& registry = GetRegistry();
+
+		std::scoped_lock lock(registry.Lock);
+		for (auto& buffer : registry.Buffers)
+		{
+			std::scoped_lock bufferLock(buffer->Lock);
+			buffer->Next = 0;
+			buffer->Wrapped = false;
+		}
+	}
+
+}
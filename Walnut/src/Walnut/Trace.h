@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <chrono>
+
+// Compile-time switch: define WL_ENABLE_TRACING (premake does so for Debug and
+// Release) to record trace events. Without it every WL_TRACE_* macro expands to
+// nothing and no tracing code reaches the binary.
+
+namespace Walnut {
+
+	struct TraceEvent
+	{
+		// Names and categories must point to storage that outlives the trace
+		// (string literals, __FUNCTION__, interned strings).
+		const char* Name = nullptr;
+		const char* Category = nullptr;
+		uint64_t StartNs = 0;
+		uint64_t DurationNs = 0;
+	};
+
+	class Trace
+	{
+	public:
+		// Events kept per thread; older events are overwritten once a thread's
+		// ring is full so memory stays bounded during long sessions.
+		static constexpr size_t EventsPerThread = 1 << 16;
+
+		// Rings of exited threads are kept for the next written trace until this
+		// many rings exist; past it a new thread reuses the ring of the thread
+		// that exited first.
+		static constexpr size_t RetainedThreadBuffers = 16;
+
+		static uint64_t Now()
+		{
+			return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		static void Record(const char* name, const char* category, uint64_t startNs, uint64_t endNs);
+
+		static void SetThreadName(const char* name);
+
+		// Writes every buffered event in Chrome trace event format (loadable in
+		// chrome://tracing and ui.perfetto.dev) and clears the buffers.
+		static bool WriteChromeJson(const std::string& path);
+
+		static void Clear();
+	};
+
+	class ScopedTrace
+	{
+	public:
+		ScopedTrace(const char* name, const char* category = "app")
+			: m_Name(name), m_Category(category), m_Start(Trace::Now()) {}
+
+		~ScopedTrace()
+		{
+			Trace::Record(m_Name, m_Category, m_Start, Trace::Now());
+		}
+
+		ScopedTrace(const ScopedTrace&) = delete;
+		ScopedTrace& operator=(const ScopedTrace&) = delete;
+	private:
+		const char* m_Name;
+		const char* m_Category;
+		uint64_t m_Start;
+	};
+
+}
+
+#define WL_TRACE_CONCAT_IMPL(a, b) a##b
+#define WL_TRACE_CONCAT(a, b) WL_TRACE_CONCAT_IMPL(a, b)
+
+#ifdef WL_ENABLE_TRACING
+	#define WL_TRACE_SCOPE_CAT(category, name) ::Walnut::ScopedTrace WL_TRACE_CONCAT(wlTraceScope, __LINE__)(name, category)
+	#define WL_TRACE_SCOPE(name) WL_TRACE_SCOPE_CAT("app", name)
+	#define WL_TRACE_FUNCTION() WL_TRACE_SCOPE(__FUNCTION__)
+	#define WL_TRACE_THREAD_NAME(name) ::Walnut::Trace::SetThreadName(name)
+#else
+	#define WL_TRACE_SCOPE_CAT(category, name) ((void)0)
+	#define WL_TRACE_SCOPE(name) ((void)0)
+	#define WL_TRACE_FUNCTION() ((void)0)
+	#define WL_TRACE_THREAD_NAME(name) ((void)0)
+#endif
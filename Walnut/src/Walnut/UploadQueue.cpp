@@ -0,0 +1,215 @@
+#include "UploadQueue.h"
+
+#include "Application.h"
+#include "MemoryAllocator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+namespace Walnut {
+
+	// vkCmdCopyBufferToImage needs offsets aligned to the texel size and 4, 16 covers every ImageFormat
+	static constexpr VkDeviceSize s_StagingAlignment = 16;
+
+	namespace Utils {
+
+		static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+		{
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+	}
+
+	UploadQueue::UploadQueue(VkDevice device, VkDeviceSize ringSize)
+		: m_Device(device), m_RingSize(Utils::AlignUp(ringSize, s_StagingAlignment))
+	{
+		m_Ring = CreateStagingBuffer(m_RingSize, (void**)&m_RingData);
+	}
+
+	UploadQueue::~UploadQueue()
+	{
+		// The device is idle by now, see Application::Shutdown
+		for (auto& upload : m_Pending)
+			DestroyStagingBuffer(upload.Dedicated);
+		for (auto& submission : m_InFlight)
+		{
+			for (auto& staging : submission.Dedicated)
+				DestroyStagingBuffer(staging);
+		}
+
+		vkUnmapMemory(m_Device, m_Ring.Memory);
+		DestroyStagingBuffer(m_Ring);
+	}
+
+	uint64_t UploadQueue::Enqueue(VkImage image, uint32_t width, uint32_t height, const void* data, VkDeviceSize size)
+	{
+		// Never recorded, so the GPU has not seen their staging memory
+		auto superseded = std::stable_partition(m_Pending.begin(), m_Pending.end(), [image](const PendingUpload& pending) { return pending.Image != image; });
+		for (auto it = superseded; it != m_Pending.end(); ++it)
+			DestroyStagingBuffer(it->Dedicated);
+		m_Pending.erase(superseded, m_Pending.end());
+
+		return Push({ image, 0, 0, width, height, true, 0, {}, 0 }, data, size);
+	}
+
+	uint64_t UploadQueue::EnqueueRegion(VkImage image, int32_t x, int32_t y, uint32_t width, uint32_t height, const void* data, VkDeviceSize size, bool discardRest)
+	{
+		return Push({ image, x, y, width, height, discardRest, 0, {}, 0 }, data, size);
+	}
+
+	uint64_t UploadQueue::Push(PendingUpload upload, const void* data, VkDeviceSize size)
+	{
+		upload.Ticket = m_NextTicket++;
+
+		if (AllocateFromRing(size, upload.Offset))
+		{
+			memcpy(m_RingData + upload.Offset, data, size);
+		}
+		else
+		{
+			// Larger than the ring or the ring is still busy with earlier frames, never wait for the GPU here
+			void* mapped = nullptr;
+			upload.Dedicated = CreateStagingBuffer(size, &mapped);
+			memcpy(mapped, data, size);
+			vkUnmapMemory(m_Device, upload.Dedicated.Memory);
+		}
+
+		m_Pending.push_back(upload);
+		return upload.Ticket;
+	}
+
+	void UploadQueue::Record(VkCommandBuffer commandBuffer, uint64_t submitSerial)
+	{
+		if (m_Pending.empty())
+			return;
+
+		// One transition per image, an atlas page may receive many rectangles in a frame
+		std::vector<VkImageMemoryBarrier> barriers;
+		std::unordered_map<VkImage, size_t> barrierIndices;
+		for (auto& upload : m_Pending)
+		{
+			if (!barrierIndices.emplace(upload.Image, barriers.size()).second)
+				continue;
+
+			// Only fragment shader reads of earlier frames come before, the writes were made visible by then
+			VkImageMemoryBarrier& copy_barrier = barriers.emplace_back();
+			copy_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			copy_barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			copy_barrier.oldLayout = upload.Discard ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			copy_barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			copy_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			copy_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			copy_barrier.image = upload.Image;
+			copy_barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			copy_barrier.subresourceRange.levelCount = 1;
+			copy_barrier.subresourceRange.layerCount = 1;
+		}
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, (uint32_t)barriers.size(), barriers.data());
+
+		Submission submission = { submitSerial, m_RingHead, 0, {} };
+
+		for (auto& upload : m_Pending)
+		{
+			VkBufferImageCopy region = {};
+			region.bufferOffset = upload.Dedicated.Buffer ? 0 : upload.Offset;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.layerCount = 1;
+			region.imageOffset.x = upload.X;
+			region.imageOffset.y = upload.Y;
+			region.imageExtent.width = upload.Width;
+			region.imageExtent.height = upload.Height;
+			region.imageExtent.depth = 1;
+			VkBuffer source = upload.Dedicated.Buffer ? upload.Dedicated.Buffer : m_Ring.Buffer;
+			vkCmdCopyBufferToImage(commandBuffer, source, upload.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+			if (upload.Dedicated.Buffer)
+				submission.Dedicated.push_back(upload.Dedicated);
+			submission.LastTicket = std::max(submission.LastTicket, upload.Ticket);
+		}
+
+		for (auto& use_barrier : barriers)
+		{
+			use_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			use_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			use_barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			use_barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		}
+		vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, (uint32_t)barriers.size(), barriers.data());
+
+		m_Pending.clear();
+		m_InFlight.push_back(std::move(submission));
+	}
+
+	void UploadQueue::Retire(uint64_t completedSerial)
+	{
+		while (!m_InFlight.empty() && m_InFlight.front().Serial <= completedSerial)
+		{
+			Submission& submission = m_InFlight.front();
+			for (auto& staging : submission.Dedicated)
+				DestroyStagingBuffer(staging);
+
+			m_RingTail = std::max(m_RingTail, submission.RingEnd);
+			m_CompletedTicket = std::max(m_CompletedTicket, submission.LastTicket);
+			m_InFlight.pop_front();
+		}
+	}
+
+	UploadQueue::StagingBuffer UploadQueue::CreateStagingBuffer(VkDeviceSize size, void** mapped)
+	{
+		StagingBuffer staging;
+		VkResult err;
+
+		VkBufferCreateInfo buffer_info = {};
+		buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		buffer_info.size = size;
+		buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		err = vkCreateBuffer(m_Device, &buffer_info, nullptr, &staging.Buffer);
+		check_vk_result(err);
+		VkMemoryRequirements req;
+		vkGetBufferMemoryRequirements(m_Device, staging.Buffer, &req);
+		// Coherent memory makes the host writes visible to the next submit without flushing ranges
+		VkMemoryAllocateInfo alloc_info = {};
+		alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		alloc_info.allocationSize = req.size;
+		alloc_info.memoryTypeIndex = Application::GetMemoryAllocator().FindMemoryType(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, req.memoryTypeBits);
+		err = vkAllocateMemory(m_Device, &alloc_info, nullptr, &staging.Memory);
+		check_vk_result(err);
+		err = vkBindBufferMemory(m_Device, staging.Buffer, staging.Memory, 0);
+		check_vk_result(err);
+
+		err = vkMapMemory(m_Device, staging.Memory, 0, size, 0, mapped);
+		check_vk_result(err);
+
+		return staging;
+	}
+
+	void UploadQueue::DestroyStagingBuffer(const StagingBuffer& staging)
+	{
+		if (!staging.Buffer)
+			return;
+
+		vkDestroyBuffer(m_Device, staging.Buffer, nullptr);
+		vkFreeMemory(m_Device, staging.Memory, nullptr);
+	}
+
+	bool UploadQueue::AllocateFromRing(VkDeviceSize size, VkDeviceSize& offset)
+	{
+		if (size > m_RingSize)
+			return false;
+
+		uint64_t start = Utils::AlignUp(m_RingHead, s_StagingAlignment);
+		// Never split an upload across the end of the ring, skip to the start instead
+		if (start % m_RingSize + size > m_RingSize)
+			start = Utils::AlignUp(start, m_RingSize);
+
+		if (start + size - m_RingTail > m_RingSize)
+			return false;
+
+		m_RingHead = start + size;
+		offset = start % m_RingSize;
+		return true;
+	}
+
+}
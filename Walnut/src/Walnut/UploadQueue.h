@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+namespace Walnut {
+
+	// Batches image uploads into the frame's command buffer instead of a blocking submit per image.
+	// Pixels are copied into a persistently mapped staging ring at once, the copies are recorded ahead of
+	// the render pass of the next frame and the ring space is reclaimed when that frame's fence signals.
+	// Main thread only, like every other Vulkan call in Walnut.
+	class UploadQueue
+	{
+	public:
+		UploadQueue(VkDevice device, VkDeviceSize ringSize);
+		~UploadQueue();
+
+		UploadQueue(const UploadQueue&) = delete;
+		UploadQueue& operator=(const UploadQueue&) = delete;
+
+		// Copies the pixels and returns a ticket for IsComplete. The whole image is replaced,
+		// a newer upload to the same image within a frame supersedes the pending ones.
+		uint64_t Enqueue(VkImage image, uint32_t width, uint32_t height, const void* data, VkDeviceSize size);
+		// Replaces a rectangle and keeps the rest of the image. Pass discardRest for an image never written before,
+		// its other texels stay undefined. Rectangles of one image queued in the same frame must not overlap.
+		uint64_t EnqueueRegion(VkImage image, int32_t x, int32_t y, uint32_t width, uint32_t height, const void* data, VkDeviceSize size, bool discardRest);
+
+		bool IsComplete(uint64_t ticket) const { return ticket <= m_CompletedTicket; }
+
+		uint32_t GetPendingCount() const { return (uint32_t)m_Pending.size(); }
+
+		// Records the pending uploads, the command buffer must be submitted before any draw that samples them
+		void Record(VkCommandBuffer commandBuffer, uint64_t submitSerial);
+		// Releases everything recorded with a submission serial up to completedSerial
+		void Retire(uint64_t completedSerial);
+	private:
+		struct StagingBuffer
+		{
+			VkBuffer Buffer = nullptr;
+			VkDeviceMemory Memory = nullptr;
+		};
+
+		struct PendingUpload
+		{
+			VkImage Image;
+			int32_t X, Y;
+			uint32_t Width, Height;
+			// The previous contents of the image need not be kept
+			bool Discard;
+			// Offset into the ring, or into Dedicated when the ring had no room
+			VkDeviceSize Offset;
+			StagingBuffer Dedicated;
+			uint64_t Ticket;
+		};
+
+		struct Submission
+		{
+			uint64_t Serial;
+			uint64_t RingEnd;
+			uint64_t LastTicket;
+			std::vector<StagingBuffer> Dedicated;
+		};
+
+		uint64_t Push(PendingUpload upload, const void* data, VkDeviceSize size);
+
+		StagingBuffer CreateStagingBuffer(VkDeviceSize size, void** mapped);
+		void DestroyStagingBuffer(const StagingBuffer& staging);
+
+		bool AllocateFromRing(VkDeviceSize size, VkDeviceSize& offset);
+	private:
+		VkDevice m_Device = nullptr;
+
+		StagingBuffer m_Ring;
+		uint8_t* m_RingData = nullptr;
+		VkDeviceSize m_RingSize = 0;
+
+		// Monotonic positions, the ring offset is the position modulo m_RingSize
+		uint64_t m_RingHead = 0;
+		uint64_t m_RingTail = 0;
+
+		uint64_t m_NextTicket = 1;
+		uint64_t m_CompletedTicket = 0;
+
+		std::vector<PendingUpload> m_Pending;
+		std::deque<Submission> m_InFlight;
+	};
+
+}
@@ -4,4 +4,5 @@ DROP TABLE product_categories;
 DROP TABLE products;
 DROP TABLE customers;
 DROP TABLE orders;
-DROP TABLE inventories;
\ No newline at end of file
+DROP TABLE inventories;
+DROP PROCEDURE place_order;
\ No newline at end of file
@@ -92,4 +92,83 @@ CREATE TABLE inventories
       FOREIGN KEY( warehouse_id )
       REFERENCES warehouses( warehouse_id ) 
       ON DELETE CASCADE
-  );
\ No newline at end of file
+  );
+
+-- Checks stock, allocates the quantity over warehouses (customer's country first,
+-- then the fullest ones), decrements inventories and inserts the order.
+-- Returns the new order and the changed inventory rows so the client can patch
+-- its local tables without reloading them. Either everything is applied or nothing.
+CREATE OR REPLACE PROCEDURE place_order
+  (
+    p_customer_id IN  NUMBER         ,
+    p_product_id  IN  NUMBER         ,
+    p_quantity    IN  NUMBER         ,
+    p_status      IN  VARCHAR2       ,
+    p_order_id    OUT NUMBER         ,
+    p_order_date  OUT DATE           ,
+    p_inventories OUT SYS_REFCURSOR
+  )
+AS
+  v_country_id   customers.country_id%TYPE;
+  v_warehouses   SYS.ODCINUMBERLIST;
+  v_quantities   SYS.ODCINUMBERLIST;
+  v_changed      SYS.ODCINUMBERLIST := SYS.ODCINUMBERLIST();
+  v_available    NUMBER := 0;
+  v_left         NUMBER := p_quantity;
+  v_take         NUMBER;
+BEGIN
+  IF p_quantity IS NULL OR p_quantity <= 0 THEN
+    RAISE_APPLICATION_ERROR( -20001, 'Quantity must be positive' );
+  END IF;
+
+  SELECT country_id
+    INTO v_country_id
+    FROM customers
+   WHERE customer_id = p_customer_id;
+
+  -- Locks the product's stock rows until the end of the transaction
+  SELECT i.warehouse_id, i.quantity
+    BULK COLLECT INTO v_warehouses, v_quantities
+    FROM inventories i
+    JOIN warehouses w ON w.warehouse_id = i.warehouse_id
+   WHERE i.product_id = p_product_id
+   ORDER BY CASE WHEN w.country_id = v_country_id THEN 0 ELSE 1 END,
+            i.quantity DESC,
+            i.warehouse_id
+     FOR UPDATE OF i.quantity;
+
+  FOR i IN 1 .. v_quantities.COUNT LOOP
+    v_available := v_available + v_quantities( i );
+  END LOOP;
+
+  IF v_available < p_quantity THEN
+    RAISE_APPLICATION_ERROR( -20002, 'Not enough items in stock: ' || v_available || ' available' );
+  END IF;
+
+  FOR i IN 1 .. v_warehouses.COUNT LOOP
+    EXIT WHEN v_left <= 0;
+
+    v_take := LEAST( v_left, v_quantities( i ) );
+    IF v_take > 0 THEN
+      UPDATE inventories
+         SET quantity = quantity - v_take
+       WHERE product_id = p_product_id
+         AND warehouse_id = v_warehouses( i );
+
+      v_changed.EXTEND;
+      v_changed( v_changed.COUNT ) := v_warehouses( i );
+      v_left := v_left - v_take;
+    END IF;
+  END LOOP;
+
+  INSERT INTO orders( customer_id, status, order_date, product_id, quantity )
+  VALUES( p_customer_id, p_status, SYSDATE, p_product_id, p_quantity )
+  RETURNING order_id, order_date INTO p_order_id, p_order_date;
+
+  OPEN p_inventories FOR
+    SELECT product_id, warehouse_id, quantity
+      FROM inventories
+     WHERE product_id = p_product_id
+       AND warehouse_id IN ( SELECT column_value FROM TABLE( v_changed ) );
+END;
+/
\ No newline at end of file